@@ -24,6 +24,7 @@
  * THE SOFTWARE.
  */
 
+#include <errno.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -43,6 +44,13 @@
 // Command line options, with their defaults
 static uint emit_opt = MP_EMIT_OPT_NONE;
 mp_uint_t mp_verbose_flag = 0;
+static const char **module_consts = NULL;
+static size_t module_consts_len = 0;
+#if MICROPY_EMIT_NATIVE
+static const char *profile_file = NULL;
+static size_t native_budget = (size_t)-1;
+#endif
+static bool batch_mode = false;
 
 // Heap size of GC heap (if enabled)
 // Make it larger on a 64 bit machine, because pointers are larger.
@@ -64,31 +72,213 @@ static void stderr_print_strn(void *env, const char *str, size_t len) {
 
 static const mp_print_t mp_stderr_print = {NULL, stderr_print_strn};
 
+static void compile_file(const char *file, qstr source_name, mp_compiled_module_t *cm) {
+    mp_lexer_t *lex;
+    if (strcmp(file, "-") == 0) {
+        lex = mp_lexer_new_from_fd(MP_QSTR__lt_stdin_gt_, STDIN_FILENO, false);
+    } else {
+        lex = mp_lexer_new_from_file(qstr_from_str(file));
+    }
+    mp_parse_tree_t parse_tree = mp_parse(lex, MP_PARSE_FILE_INPUT);
+    cm->context = m_new_obj(mp_module_context_t);
+    mp_compile_to_raw_code(&parse_tree, source_name, false, cm);
+}
+
+#if MICROPY_EMIT_NATIVE
+// A function of the module being compiled that is hot according to the call
+// profile given with --profile (see py/callprofile.c for the format)
+typedef struct _profile_fun_t {
+    qstr name;
+    size_t line;
+    size_t us;
+    size_t extra_len; // how much bigger its native code is, or -1 if it has none
+    bool native;
+} profile_fun_t;
+
+static profile_fun_t *profile_funs = NULL;
+static size_t profile_funs_len = 0;
+static bool profile_measuring = false;
+
+static size_t profile_read_uleb(const byte **ptr, const byte *top) {
+    size_t value = 0;
+    for (unsigned shift = 0;; shift += 7) {
+        if (*ptr >= top || shift >= 8 * sizeof(size_t)) {
+            mp_raise_ValueError(MP_ERROR_TEXT("bad profile"));
+        }
+        byte b = *(*ptr)++;
+        value |= (size_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) {
+            return value;
+        }
+    }
+}
+
+static const char *profile_read_str(const byte **ptr, const byte *top, size_t *len) {
+    *len = profile_read_uleb(ptr, top);
+    if (*len > (size_t)(top - *ptr)) {
+        mp_raise_ValueError(MP_ERROR_TEXT("bad profile"));
+    }
+    const char *str = (const char *)*ptr;
+    *ptr += *len;
+    return str;
+}
+
+// The file of a function in the profile is its source name on the device, which
+// may have a different directory to the source name given to mpy-cross.
+static bool profile_file_matches(const char *a, size_t a_len, const char *b, size_t b_len) {
+    if (a_len < b_len) {
+        const char *s = a;
+        a = b;
+        b = s;
+        size_t n = a_len;
+        a_len = b_len;
+        b_len = n;
+    }
+    return b_len > 0
+           && memcmp(a + a_len - b_len, b, b_len) == 0
+           && (a_len == b_len || a[a_len - b_len - 1] == '/');
+}
+
+// Load the functions of the given source file that account for at least 1% of
+// the time in the profile, hottest first.
+static void profile_load(qstr source_name) {
+    // forget the functions of the previous file in --batch mode
+    free(profile_funs);
+    profile_funs = NULL;
+    profile_funs_len = 0;
+
+    FILE *f = fopen(profile_file, "rb");
+    if (f == NULL) {
+        mp_raise_OSError(errno);
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    byte *data = m_new(byte, size < 0 ? 0 : size);
+    size_t data_len = fread(data, 1, size < 0 ? 0 : size, f);
+    fclose(f);
+
+    const byte *top = data + data_len;
+    if (data_len < 5 || memcmp(data, "MPCP\x01", 5) != 0) {
+        mp_raise_ValueError(MP_ERROR_TEXT("bad profile"));
+    }
+    size_t source_len;
+    const char *source = (const char *)qstr_data(source_name, &source_len);
+    size_t total_us = 0;
+    for (int pass = 0; pass < 2; ++pass) {
+        const byte *ptr = data + 5;
+        size_t n = profile_read_uleb(&ptr, top);
+        if (pass == 1) {
+            // not on the GC heap, which mpy-cross doesn't scan
+            profile_funs = malloc(n * sizeof(*profile_funs));
+        }
+        for (size_t i = 0; i < n; ++i) {
+            size_t file_len, name_len;
+            const char *file = profile_read_str(&ptr, top, &file_len);
+            const char *name = profile_read_str(&ptr, top, &name_len);
+            size_t line = profile_read_uleb(&ptr, top);
+            profile_read_uleb(&ptr, top); // number of calls
+            size_t us = profile_read_uleb(&ptr, top);
+            if (pass == 0) {
+                total_us += us;
+            } else if (us > 0 && us >= total_us / 100 && profile_file_matches(file, file_len, source, source_len)) {
+                // insert it in order of time
+                size_t j = profile_funs_len++;
+                for (; j > 0 && profile_funs[j - 1].us < us; --j) {
+                    profile_funs[j] = profile_funs[j - 1];
+                }
+                profile_funs[j].name = qstr_from_strn(name, name_len);
+                profile_funs[j].line = line;
+                profile_funs[j].us = us;
+                profile_funs[j].extra_len = (size_t)-1;
+                profile_funs[j].native = false;
+            }
+        }
+        if (ptr != top) {
+            mp_raise_ValueError(MP_ERROR_TEXT("bad profile"));
+        }
+    }
+    m_del(byte, data, size);
+}
+
+// Hook for mp_dynamic_compiler.native_select.  The module is compiled twice: the
+// first time every hot function is compiled to native code to find its size,
+// then the hottest ones that fit within the budget are chosen for the second.
+static bool profile_native_select(qstr name, size_t line, size_t bytecode_len, size_t native_len) {
+    for (size_t i = 0; i < profile_funs_len; ++i) {
+        profile_fun_t *f = &profile_funs[i];
+        if (f->name == name && f->line == line) {
+            if (!profile_measuring) {
+                return f->native;
+            }
+            if (native_len == 0) {
+                return true;
+            }
+            f->extra_len = native_len > bytecode_len ? native_len - bytecode_len : 0;
+            return false;
+        }
+    }
+    return false;
+}
+
+static void profile_choose(void) {
+    size_t budget = native_budget;
+    for (size_t i = 0; i < profile_funs_len; ++i) {
+        profile_fun_t *f = &profile_funs[i];
+        if (f->extra_len != (size_t)-1 && f->extra_len <= budget) {
+            f->native = true;
+            budget -= f->extra_len;
+            if (mp_verbose_flag) {
+                mp_printf(&mp_stderr_print, "native: %q line %u, %u us, +%u bytes\n",
+                    f->name, (uint)f->line, (uint)f->us, (uint)f->extra_len);
+            }
+        }
+    }
+}
+#endif
+
 static int compile_and_save(const char *file, const char *output_file, const char *source_file) {
     nlr_buf_t nlr;
     if (nlr_push(&nlr) == 0) {
-        mp_lexer_t *lex;
-        if (strcmp(file, "-") == 0) {
-            lex = mp_lexer_new_from_fd(MP_QSTR__lt_stdin_gt_, STDIN_FILENO, false);
-        } else {
-            lex = mp_lexer_new_from_file(qstr_from_str(file));
+        // each constant is given as <module>.<name>=<value>
+        for (size_t i = 0; i < module_consts_len; i++) {
+            const char *def = module_consts[i];
+            const char *value = strchr(def, '=');
+            if (value == NULL || value == def) {
+                mp_raise_ValueError(MP_ERROR_TEXT("-D must be <module>.<name>=<value>"));
+            }
+            value++;
+            mp_lexer_t *lex = mp_lexer_new_from_str_len(MP_QSTR__lt_string_gt_, value, strlen(value), 0);
+            mp_parse_define_module_const(qstr_from_strn(def, value - 1 - def), lex);
         }
 
         qstr source_name;
-        if (source_file == NULL) {
-            source_name = lex->source_name;
-        } else {
+        if (source_file != NULL) {
             source_name = qstr_from_str(source_file);
+        } else if (strcmp(file, "-") == 0) {
+            source_name = MP_QSTR__lt_stdin_gt_;
+        } else {
+            source_name = qstr_from_str(file);
         }
 
         #if MICROPY_PY___FILE__
         mp_store_global(MP_QSTR___file__, MP_OBJ_NEW_QSTR(source_name));
         #endif
 
-        mp_parse_tree_t parse_tree = mp_parse(lex, MP_PARSE_FILE_INPUT);
         mp_compiled_module_t cm;
-        cm.context = m_new_obj(mp_module_context_t);
-        mp_compile_to_raw_code(&parse_tree, source_name, false, &cm);
+        #if MICROPY_EMIT_NATIVE
+        if (profile_file != NULL) {
+            profile_load(source_name);
+            if (profile_funs_len > 0) {
+                mp_dynamic_compiler.native_select = profile_native_select;
+                profile_measuring = true;
+                compile_file(file, source_name, &cm);
+                profile_measuring = false;
+                profile_choose();
+            }
+        }
+        #endif
+        compile_file(file, source_name, &cm);
 
         if ((output_file != NULL && strcmp(output_file, "-") == 0) ||
             (output_file == NULL && strcmp(file, "-") == 0)) {
@@ -122,10 +312,17 @@ static int usage(char **argv) {
         "usage: %s [<opts>] [-X <implopt>] [--] <input filename>\n"
         "Options:\n"
         "--version : show version information\n"
+        "--batch : compile the files given on stdin, one line of tab-separated options per file\n"
         "-o : output file for compiled bytecode (defaults to input filename with .mpy extension, or stdout if input is stdin)\n"
         "-s : source filename to embed in the compiled bytecode (defaults to input file)\n"
         "-v : verbose (trace various operations); can be multiple\n"
         "-O[N] : apply bytecode optimizations of level N\n"
+        "-D <module>.<name>=<value> : with -O2 or higher, make <name> a constant when it is imported from <module>\n"
+        "--hoist-globals : look up the globals and builtins that a loop reads once, before the loop (unsafe, see README.md)\n"
+        #if MICROPY_EMIT_NATIVE
+        "--profile <file> : compile the hot functions in a call profile, from micropython.call_snapshot(), to native code\n"
+        "--native-budget <bytes> : with --profile, the most that native code may add to the size of the output\n"
+        #endif
         "\n"
         "Target specific options:\n"
         "-msmall-int-bits=number : set the maximum bits used to encode a small-int\n"
@@ -211,18 +408,25 @@ static char *backslash_to_forwardslash(char *path) {
     return path;
 }
 
-MP_NOINLINE int main_(int argc, char **argv) {
-    mp_stack_set_limit(40000 * (sizeof(void *) / 4));
+// Compile the file given by the command line arguments, with a fresh VM
+static int compile_args(int argc, char **argv, char *heap, char *heap_end) {
+    // options persist between files in --batch mode, so reset them
+    emit_opt = MP_EMIT_OPT_NONE;
+    mp_verbose_flag = 0;
+    free(module_consts);
+    module_consts = NULL;
+    module_consts_len = 0;
+    #if MICROPY_EMIT_NATIVE
+    profile_file = NULL;
+    native_budget = (size_t)-1;
+    mp_dynamic_compiler.native_select = NULL;
+    #endif
 
     pre_process_options(argc, argv);
 
-    char *heap = malloc(heap_size);
-    gc_init(heap, heap + heap_size);
+    gc_init(heap, heap_end);
 
     mp_init();
-    #ifdef _WIN32
-    set_fmode_binary();
-    #endif
 
     #if MICROPY_EMIT_NATIVE
     // Set default emitter options
@@ -236,6 +440,7 @@ MP_NOINLINE int main_(int argc, char **argv) {
     // don't support native emitter unless -march is specified
     mp_dynamic_compiler.native_arch = MP_NATIVE_ARCH_NONE;
     mp_dynamic_compiler.nlr_buf_num_regs = 0;
+    mp_dynamic_compiler.hoist_globals = false;
 
     const char *input_file = NULL;
     const char *output_file = NULL;
@@ -261,15 +466,44 @@ MP_NOINLINE int main_(int argc, char **argv) {
                     for (char *p = argv[a] + 1; *p && *p == 'O'; p++, MP_STATE_VM(mp_optimise_value)++) {;
                     }
                 }
+            } else if (strcmp(argv[a], "-D") == 0) {
+                if (a + 1 >= argc) {
+                    return usage(argv);
+                }
+                a += 1;
+                if (module_consts == NULL) {
+                    module_consts = malloc(argc * sizeof(*module_consts));
+                }
+                module_consts[module_consts_len++] = argv[a];
+            } else if (strcmp(argv[a], "--hoist-globals") == 0) {
+                mp_dynamic_compiler.hoist_globals = true;
+            #if MICROPY_EMIT_NATIVE
+            } else if (strcmp(argv[a], "--profile") == 0) {
+                if (a + 1 >= argc) {
+                    return usage(argv);
+                }
+                a += 1;
+                profile_file = argv[a];
+            } else if (strcmp(argv[a], "--native-budget") == 0) {
+                if (a + 1 >= argc) {
+                    return usage(argv);
+                }
+                a += 1;
+                char *end;
+                native_budget = strtoul(argv[a], &end, 0);
+                if (*end) {
+                    return usage(argv);
+                }
+            #endif
             } else if (strcmp(argv[a], "-o") == 0) {
                 if (a + 1 >= argc) {
-                    exit(usage(argv));
+                    return usage(argv);
                 }
                 a += 1;
                 output_file = argv[a];
             } else if (strcmp(argv[a], "-s") == 0) {
                 if (a + 1 >= argc) {
-                    exit(usage(argv));
+                    return usage(argv);
                 }
                 a += 1;
                 source_file = backslash_to_forwardslash(argv[a]);
@@ -331,7 +565,7 @@ MP_NOINLINE int main_(int argc, char **argv) {
                     mp_dynamic_compiler.nlr_buf_num_regs = MICROPY_NLR_NUM_REGS_ARM_THUMB_FP;
                     #else
                     mp_printf(&mp_stderr_print, "unable to determine host architecture for -march=host\n");
-                    exit(1);
+                    return 1;
                     #endif
                 } else {
                     return usage(argv);
@@ -344,7 +578,7 @@ MP_NOINLINE int main_(int argc, char **argv) {
         } else {
             if (input_file != NULL) {
                 mp_printf(&mp_stderr_print, "multiple input files\n");
-                exit(1);
+                return 1;
             }
             input_file = backslash_to_forwardslash(argv[a]);
         }
@@ -352,9 +586,27 @@ MP_NOINLINE int main_(int argc, char **argv) {
 
     if (input_file == NULL) {
         mp_printf(&mp_stderr_print, "no input file\n");
-        exit(1);
+        return 1;
+    }
+
+    if (batch_mode && (strcmp(input_file, "-") == 0 || (output_file != NULL && strcmp(output_file, "-") == 0))) {
+        mp_printf(&mp_stderr_print, "--batch can't use stdin or stdout\n");
+        return 1;
     }
 
+    #if MICROPY_EMIT_NATIVE
+    if (profile_file != NULL) {
+        if (mp_dynamic_compiler.native_arch == MP_NATIVE_ARCH_NONE) {
+            mp_printf(&mp_stderr_print, "--profile needs -march\n");
+            return 1;
+        }
+        if (strcmp(input_file, "-") == 0) {
+            mp_printf(&mp_stderr_print, "--profile can't be used with stdin\n");
+            return 1;
+        }
+    }
+    #endif
+
     int ret = compile_and_save(input_file, output_file, source_file);
 
     #if MICROPY_PY_MICROPYTHON_MEM_INFO
@@ -368,6 +620,74 @@ MP_NOINLINE int main_(int argc, char **argv) {
     return ret & 0xff;
 }
 
+// Compile the files given on stdin, one per line, each line being the arguments
+// for that file separated by tabs.  Once a file is done the output for it is
+// followed by \x04 and the exit code on a line of its own.  Build tools can
+// then keep a few of these processes busy instead of starting one per file.
+static int batch(char *prog, char *heap, char *heap_end) {
+    size_t line_alloc = 256;
+    char *line = malloc(line_alloc);
+    size_t argv_alloc = 16;
+    char **argv = malloc(argv_alloc * sizeof(*argv));
+    for (;;) {
+        size_t len = 0;
+        int c;
+        while ((c = getchar()) != EOF && c != '\n') {
+            if (len + 1 >= line_alloc) {
+                line_alloc *= 2;
+                line = realloc(line, line_alloc);
+            }
+            line[len++] = c;
+        }
+        if (c == EOF && len == 0) {
+            break;
+        }
+        line[len] = '\0';
+
+        int argc = 1;
+        argv[0] = prog;
+        for (char *arg = line; arg != NULL; ++argc) {
+            if ((size_t)argc + 1 >= argv_alloc) {
+                argv_alloc *= 2;
+                argv = realloc(argv, argv_alloc * sizeof(*argv));
+            }
+            argv[argc] = arg;
+            arg = strchr(arg, '\t');
+            if (arg != NULL) {
+                *arg++ = '\0';
+            }
+        }
+        argv[argc] = NULL;
+
+        int ret = compile_args(argc, argv, heap, heap_end);
+        fflush(stdout);
+        printf("\x04%d\n", ret);
+        fflush(stdout);
+    }
+    free(argv);
+    free(line);
+    return 0;
+}
+
+MP_NOINLINE int main_(int argc, char **argv) {
+    mp_stack_set_limit(40000 * (sizeof(void *) / 4));
+
+    pre_process_options(argc, argv);
+
+    char *heap = malloc(heap_size);
+    char *heap_end = heap + heap_size;
+
+    #ifdef _WIN32
+    set_fmode_binary();
+    #endif
+
+    if (argc == 2 && strcmp(argv[1], "--batch") == 0) {
+        batch_mode = true;
+        return batch(argv[0], heap, heap_end);
+    }
+    return compile_args(argc, argv, heap, heap_end);
+}
+
 int main(int argc, char **argv) {
     mp_stack_ctrl_init();
     return main_(argc, argv);
@@ -30,6 +30,7 @@ import os
 import re
 import stat
 import subprocess
+import threading
 
 NATIVE_ARCHS = {
     "NATIVE_ARCH_NONE": "",
@@ -48,7 +49,9 @@ NATIVE_ARCHS = {
 
 globals().update(NATIVE_ARCHS)
 
-__all__ = ["version", "compile", "run", "CrossCompileError"] + list(NATIVE_ARCHS.keys())
+__all__ = ["version", "compile", "compile_batch", "run", "CrossCompileError"] + list(
+    NATIVE_ARCHS.keys()
+)
 
 
 class CrossCompileError(Exception):
@@ -98,6 +101,10 @@ def compile(src, dest=None, src_path=None, opt=None, march=None, mpy_cross=None,
      - mpy_cross:  Specific mpy-cross binary to use
      - extra_args: Additional arguments to pass to mpy-cross (e.g. `["-X", "emit=native"]`)
     """
+    run(_compile_args(src, dest, src_path, opt, march, extra_args), mpy_cross)
+
+
+def _compile_args(src, dest=None, src_path=None, opt=None, march=None, extra_args=None):
     if not src:
         raise ValueError("src is required")
     if not os.path.exists(src):
@@ -122,19 +129,95 @@ def compile(src, dest=None, src_path=None, opt=None, march=None, mpy_cross=None,
 
     args += [src]
 
-    run(args, mpy_cross)
+    return args
 
 
-def run(args, mpy_cross=None):
+def compile_batch(jobs, mpy_cross=None, workers=None):
     """
-    Run mpy-cross with the specified command line arguments.
-    Prefer to use `compile()` instead.
+    Compile many .py files, using a pool of mpy-cross processes in batch mode.
 
-    Returns: Standard output from mpy-cross as a string.
+    Returns: A list with the standard output from mpy-cross for each job.
+
+    Required arguments:
+     - jobs:      A list of dicts of keyword arguments for `compile()`, e.g. `{"src": "a.py"}`
 
     Optional keyword arguments:
      - mpy_cross: Specific mpy-cross binary to use
+     - workers:   Number of mpy-cross processes to run (defaults to the number of CPUs)
+
+    If a job fails then `CrossCompileError` is raised with the output from
+    mpy-cross and the index of the job.
     """
+    job_args = []
+    for job in jobs:
+        args = _compile_args(**job)
+        if any("\t" in arg or "\n" in arg for arg in args):
+            raise ValueError("mpy-cross --batch arguments can't contain tabs or newlines")
+        job_args.append("\t".join(args).encode() + b"\n")
+
+    mpy_cross = _prepare_binary(mpy_cross)
+    results = [None] * len(jobs)
+    errors = []
+    next_job = iter(range(len(jobs)))
+    lock = threading.Lock()
+
+    def worker():
+        proc = subprocess.Popen(
+            [mpy_cross, "--batch"],
+            stdin=subprocess.PIPE,
+            stdout=subprocess.PIPE,
+            stderr=subprocess.STDOUT,
+        )
+        i = -1
+        try:
+            while True:
+                with lock:
+                    i = None if errors else next(next_job, None)
+                if i is None:
+                    break
+                proc.stdin.write(job_args[i])
+                proc.stdin.flush()
+                # the output ends with \x04 and the exit code
+                output = b""
+                while True:
+                    line = proc.stdout.readline()
+                    if not line:
+                        raise CrossCompileError(
+                            "mpy-cross --batch exited: " + output.decode(), i
+                        )
+                    end = line.find(b"\x04")
+                    if end < 0:
+                        output += line
+                    else:
+                        output += line[:end]
+                        break
+                results[i] = output.decode()
+                if int(line[end + 1 :]) != 0:
+                    raise CrossCompileError(results[i], i)
+        except CrossCompileError as er:
+            with lock:
+                errors.append(er)
+        except OSError as er:
+            with lock:
+                errors.append(CrossCompileError("mpy-cross --batch: {}".format(er), i))
+        finally:
+            proc.stdin.close()
+            proc.wait()
+
+    if workers is None:
+        workers = os.cpu_count() or 1
+    threads = [threading.Thread(target=worker) for _ in range(min(workers, len(jobs)))]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+
+    if errors:
+        raise min(errors, key=lambda er: er.args[1])
+    return results
+
+
+def _prepare_binary(mpy_cross):
     mpy_cross = _find_mpy_cross_binary(mpy_cross)
 
     if not os.path.exists(mpy_cross):
@@ -146,6 +229,21 @@ def run(args, mpy_cross=None):
     except OSError:
         pass
 
+    return mpy_cross
+
+
+def run(args, mpy_cross=None):
+    """
+    Run mpy-cross with the specified command line arguments.
+    Prefer to use `compile()` instead.
+
+    Returns: Standard output from mpy-cross as a string.
+
+    Optional keyword arguments:
+     - mpy_cross: Specific mpy-cross binary to use
+    """
+    mpy_cross = _prepare_binary(mpy_cross)
+
     try:
         return subprocess.check_output([mpy_cross] + args, stderr=subprocess.STDOUT).decode()
     except subprocess.CalledProcessError as er:
@@ -556,6 +556,12 @@ static mp_obj_t extra_coverage(void) {
         mp_obj_fun_bc_t fun_bc;
         fun_bc.context = &context;
         fun_bc.child_table = NULL;
+        #if MICROPY_OPT_INLINE_CACHE
+        fun_bc.inline_cache = NULL;
+        #endif
+        #if MICROPY_OPT_QUICKENING
+        fun_bc.quicken_count = 0;
+        #endif
         fun_bc.bytecode = (const byte *)"\x01"; // just needed for n_state
         mp_code_state_t *code_state = m_new_obj_var(mp_code_state_t, state, mp_obj_t, 1);
         code_state->fun_bc = &fun_bc;
@@ -287,7 +287,7 @@ static mp_obj_t socket_recv(size_t n_args, const mp_obj_t *args) {
         flags = MP_OBJ_SMALL_INT_VALUE(args[2]);
     }
 
-    byte *buf = m_new(byte, sz);
+    byte *buf = m_new_no_scan(byte, sz);
     ssize_t out_sz;
     MP_HAL_RETRY_SYSCALL(out_sz, recv(self->fd, buf, sz, flags), mp_raise_OSError(err));
     mp_obj_t ret = mp_obj_new_str_of_type(&mp_type_bytes, buf, out_sz);
@@ -308,7 +308,7 @@ static mp_obj_t socket_recvfrom(size_t n_args, const mp_obj_t *args) {
     struct sockaddr_storage addr;
     socklen_t addr_len = sizeof(addr);
 
-    byte *buf = m_new(byte, sz);
+    byte *buf = m_new_no_scan(byte, sz);
     ssize_t out_sz;
     MP_HAL_RETRY_SYSCALL(out_sz, recvfrom(self->fd, buf, sz, flags, (struct sockaddr *)&addr, &addr_len),
         mp_raise_OSError(err));
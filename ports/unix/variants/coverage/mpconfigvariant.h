@@ -37,6 +37,30 @@
 #define MICROPY_GC_SPLIT_HEAP          (1)
 #define MICROPY_GC_SPLIT_HEAP_N_HEAPS  (4)
 
+// Enable testing of lazy sweeping.
+#define MICROPY_GC_INCREMENTAL         (1)
+
+// Enable testing of the heap profiler.
+#define MICROPY_GC_PROFILE             (1)
+
+// Enable testing of the call profiler.
+#define MICROPY_CALL_PROFILE           (1)
+
+// Enable testing of arena allocation.
+#define MICROPY_GC_ARENA               (1)
+
+// Enable testing of per-function inline caches.
+#define MICROPY_OPT_INLINE_CACHE       (1)
+
+// Enable testing of bytecode quickening.
+#define MICROPY_OPT_QUICKENING         (1)
+
+// Enable testing of the bytecode frame cache.
+#define MICROPY_VM_FRAME_CACHE         (1)
+
+// Enable testing of shaped instance attributes.
+#define MICROPY_OPT_INSTANCE_SHAPES    (1)
+
 // Enable additional features.
 #define MICROPY_DEBUG_PARSE_RULE_NAME  (1)
 #define MICROPY_TRACKED_ALLOC          (1)
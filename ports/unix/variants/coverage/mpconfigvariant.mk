@@ -14,3 +14,6 @@ USER_C_MODULES = $(TOP)/examples/usercmodule
 
 SRC_C += coverage.c
 SRC_CXX += coveragecpp.cpp
+
+# Lay out ROM dicts in hash order, to test lookups in such tables.
+MICROPY_ROM_DICT_HASH = 1
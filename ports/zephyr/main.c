@@ -30,6 +30,8 @@
 #include <string.h>
 
 #include <zephyr/kernel.h>
+#include <zephyr/linker/linker-defs.h>
+#include <zephyr/linker/section_tags.h>
 #ifdef CONFIG_NETWORKING
 #include <zephyr/net/net_context.h>
 #endif
@@ -41,6 +43,17 @@
 #include <zephyr/storage/flash_map.h>
 #include <zephyr/drivers/gpio.h>
 
+#ifdef CONFIG_MICROPY_RETAINED_VM
+#include <zephyr/sys/crc.h>
+#include <zephyr/sys/reboot.h>
+#ifdef CONFIG_POWEROFF
+#include <zephyr/sys/poweroff.h>
+#endif
+#ifdef CONFIG_SOC_SERIES_NRF91X
+#include <nrfx.h>
+#endif
+#endif
+
 #include "py/mperrno.h"
 #include "py/builtin.h"
 #include "py/compile.h"
@@ -70,10 +83,220 @@
 #include TEST
 #endif
 
+#ifdef CONFIG_MICROPY_RETAINED_VM
+static __noinit char heap[MICROPY_HEAP_SIZE];
+#else
 static char heap[MICROPY_HEAP_SIZE];
+#endif
 
 void exec_main_py(void);
 
+#ifdef CONFIG_MICROPY_RETAINED_VM
+// zephyr.hibernate() copies the VM state next to the heap, in RAM that isn't
+// cleared by a reset, and seals both with a CRC before powering off.  If the
+// CRC still matches on the next boot the VM carries on with the same heap,
+// qstr pools and sys.modules, calling the registered wake handler instead of
+// re-running main.py.  Anything else (power loss, a new firmware image) is a
+// normal cold boot.  The heap points into the ROM qstr pools, frozen code and
+// built-in objects, so the image is identified by a CRC over all of ROM
+// rather than by anything that only changes when this file is recompiled.
+#define RETAINED_VM_MAGIC (0x4d505652)
+
+typedef struct _retained_vm_t {
+    uint32_t magic;
+    uint32_t build;
+    uint32_t crc;
+    mp_state_ctx_t state;
+} retained_vm_t;
+
+static __noinit retained_vm_t retained_vm;
+
+static uint32_t retained_vm_build_id(void) {
+    uint32_t crc = crc32_ieee((const uint8_t *)__rom_region_start, __rom_region_end - __rom_region_start);
+    return crc ^ sizeof(retained_vm) ^ sizeof(heap);
+}
+
+static uint32_t retained_vm_crc(void) {
+    uint32_t crc = crc32_ieee((const uint8_t *)&retained_vm.state, sizeof(retained_vm.state));
+    return crc32_ieee_update(crc, (const uint8_t *)heap, sizeof(heap));
+}
+
+static bool retained_vm_restore(void) {
+    bool valid = retained_vm.magic == RETAINED_VM_MAGIC
+        && retained_vm.build == retained_vm_build_id()
+        && retained_vm.crc == retained_vm_crc();
+    // A seal is only good for one wake, so a crash in the wake handler
+    // ends up in a cold boot rather than a loop.
+    retained_vm.magic = 0;
+    if (!valid) {
+        return false;
+    }
+    memcpy(&mp_state_ctx, &retained_vm.state, sizeof(mp_state_ctx));
+    return true;
+}
+
+static void retained_vm_resume(void) {
+    // The C stack the VM was sealed on is gone, so drop everything that
+    // pointed into it and go back to running at the top level of __main__.
+    MP_STATE_THREAD(nlr_top) = NULL;
+    MP_STATE_THREAD(nlr_jump_callback_top) = NULL;
+    MP_STATE_THREAD(gc_lock_depth) = 0;
+    MP_STATE_THREAD(mp_pending_exception) = MP_OBJ_NULL;
+    MP_STATE_VM(sched_state) = MP_SCHED_IDLE;
+    MP_STATE_VM(sched_len) = 0;
+    MP_STATE_VM(sched_idx) = 0;
+    mp_locals_set(&MP_STATE_VM(dict_main));
+    mp_globals_set(&MP_STATE_VM(dict_main));
+
+    #if MICROPY_PY_MACHINE
+    machine_pin_deinit();
+    #endif
+
+    mp_obj_t handler = MP_STATE_PORT(zephyr_wake_handler);
+    if (handler != MP_OBJ_NULL && handler != mp_const_none) {
+        nlr_buf_t nlr;
+        if (nlr_push(&nlr) == 0) {
+            mp_call_function_0(handler);
+            nlr_pop();
+        } else {
+            mp_obj_print_exception(&mp_plat_print, MP_OBJ_FROM_PTR(nlr.ret_val));
+        }
+    }
+}
+
+void mp_zephyr_hibernate(void) {
+    #if MICROPY_PY_MACHINE
+    // Kernel objects embedded in heap objects would be stale after the reset
+    if (MP_STATE_PORT(machine_timer_obj_head) != NULL) {
+        mp_raise_OSError(MP_EBUSY);
+    }
+    #endif
+    memcpy(&retained_vm.state, &mp_state_ctx, sizeof(mp_state_ctx));
+    retained_vm.build = retained_vm_build_id();
+    retained_vm.crc = retained_vm_crc();
+    retained_vm.magic = RETAINED_VM_MAGIC;
+
+    #ifdef CONFIG_SOC_SERIES_NRF91X
+    // Keep every RAM section powered and retained while in System OFF
+    for (size_t i = 0; i < ARRAY_SIZE(NRF_VMC->RAM); ++i) {
+        NRF_VMC->RAM[i].POWERSET = 0x000f000f;
+    }
+    #endif
+
+    #ifdef CONFIG_POWEROFF
+    sys_poweroff();
+    #else
+    sys_reboot(SYS_REBOOT_WARM);
+    #endif
+}
+#endif // CONFIG_MICROPY_RETAINED_VM
+
+#ifdef CONFIG_MICROPY_BOOT_TIMING
+uint32_t mp_zephyr_boot_times[MP_ZEPHYR_BOOT_PHASE_NUM];
+#endif
+
+#if MICROPY_VFS && !CONFIG_CONSOLE_SUBSYS
+// The start_delay setting is cached in RAM that isn't cleared by a reset, so a
+// warm boot doesn't need to touch the settings file at all.  The record is
+// re-read from the filesystem when its check word doesn't match, eg after a
+// power-on reset.
+#define BOOT_SETTINGS_MAGIC (0x4d505354)
+#define START_DELAY_DEFAULT (2)
+
+typedef struct _boot_settings_t {
+    uint32_t magic;
+    uint32_t start_delay;
+    uint32_t check;
+} boot_settings_t;
+
+static __noinit boot_settings_t boot_settings;
+static const char *boot_mount_point;
+
+static bool boot_settings_valid(void) {
+    return boot_settings.magic == BOOT_SETTINGS_MAGIC
+           && boot_settings.check == (BOOT_SETTINGS_MAGIC ^ boot_settings.start_delay);
+}
+
+static void boot_settings_store(uint32_t start_delay) {
+    boot_settings.magic = BOOT_SETTINGS_MAGIC;
+    boot_settings.start_delay = start_delay;
+    boot_settings.check = BOOT_SETTINGS_MAGIC ^ start_delay;
+}
+
+static mp_obj_t settings_path(const char *name) {
+    char path[32];
+    int len = snprintf(path, sizeof(path), "%s/settings%s", boot_mount_point, name);
+    return mp_obj_new_str(path, len);
+}
+
+static void start_delay_write(uint32_t delay) {
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        mp_vfs_mkdir(settings_path(""));
+        nlr_pop();
+    } else {
+        // Assume the directory already exists
+    }
+    char buf[4];
+    int len = snprintf(buf, sizeof(buf), "%u", (unsigned)delay);
+    mp_obj_t args[2] = {
+        settings_path("/start_delay"),
+        MP_OBJ_NEW_QSTR(MP_QSTR_wb),
+    };
+    mp_obj_t file = mp_vfs_open(MP_ARRAY_SIZE(args), &args[0], (mp_map_t *)&mp_const_empty_map);
+    int err;
+    mp_stream_write_exactly(file, buf, len, &err);
+    mp_stream_close(file);
+}
+
+static void boot_settings_load(void) {
+    uint32_t delay = 0;
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        // Open the file directly instead of stat'ing the directory and file first
+        mp_obj_t args[2] = {
+            settings_path("/start_delay"),
+            MP_OBJ_NEW_QSTR(MP_QSTR_rb),
+        };
+        mp_obj_t file = mp_vfs_open(MP_ARRAY_SIZE(args), &args[0], (mp_map_t *)&mp_const_empty_map);
+        char buf[3]; /* Limits delay to 99 seconds */
+        int err;
+        mp_uint_t len = mp_stream_read_exactly(file, &buf[0], sizeof(buf) - 1, &err);
+        mp_stream_close(file);
+        buf[len] = '\0';
+        if (sscanf(buf, "%u", (unsigned *)&delay) != 1) {
+            /* Didn't find just an unsigned int */
+            delay = 0;
+        }
+        nlr_pop();
+    } else {
+        // Assume error is ENOENT and create the file
+        printk("Creating settings delay file\n");
+        if (nlr_push(&nlr) == 0) {
+            start_delay_write(START_DELAY_DEFAULT);
+            delay = START_DELAY_DEFAULT;
+            nlr_pop();
+        }
+    }
+    boot_settings_store(delay);
+}
+
+mp_int_t mp_zephyr_start_delay_get(void) {
+    return boot_settings_valid() ? (mp_int_t)boot_settings.start_delay : -1;
+}
+
+void mp_zephyr_start_delay_set(mp_int_t delay) {
+    if (boot_mount_point == NULL) {
+        mp_raise_OSError(MP_ENODEV);
+    }
+    if (delay < 0 || delay > 99) {
+        mp_raise_ValueError(MP_ERROR_TEXT("delay out of range"));
+    }
+    start_delay_write(delay);
+    boot_settings_store(delay);
+}
+#endif // MICROPY_VFS && !CONFIG_CONSOLE_SUBSYS
+
 #if MICROPY_VFS
 STATIC void vfs_init(void) {
     mp_obj_t bdev = NULL;
@@ -116,40 +339,21 @@ STATIC void vfs_init(void) {
         if (ret != 0) {
             return;
         }
-        nlr_buf_t nlr;
-        mp_obj_t path = mp_obj_new_str("settings", strlen("settings"));
-        if (nlr_push(&nlr) == 0) {
-            mp_vfs_stat(path);
-            nlr_pop();
-        } else {
-            // Assume error is ENOENT and create the directory
-            // TODO: check the actual error
-            printk("Settings directory doesn't exist, create it\n");
-            mp_vfs_mkdir(path);
+        #if !CONFIG_CONSOLE_SUBSYS
+        boot_mount_point = mount_point_str;
+        if (!boot_settings_valid()) {
+            boot_settings_load();
         }
-        mp_vfs_chdir(path);
-        mp_obj_t filename = mp_obj_new_str("start_delay", strlen("start_delay"));
-        if (nlr_push(&nlr) == 0) {
-            mp_vfs_stat(filename);
-            nlr_pop();
-        } else {
-            // Assume error is ENOENT and create the file
-            // TODO: check the actual error
-            printk("Creating settings delay file\n");
-            mp_obj_t args[2] = {
-                filename,
-                MP_OBJ_NEW_QSTR(MP_QSTR_wb),
-            };
-            mp_obj_t file = mp_vfs_open(MP_ARRAY_SIZE(args), &args[0], (mp_map_t *)&mp_const_empty_map);
-            mp_stream_write_exactly(file, "2", 1, &ret);
-            mp_stream_close(file);
-        }
-        mp_vfs_chdir(mount_point);
+        #endif
     }
 }
 #endif // MICROPY_VFS
 
 int real_main(void) {
+    #ifdef CONFIG_MICROPY_RETAINED_VM
+    bool resume = retained_vm_restore();
+    #endif
+
     mp_stack_ctrl_init();
     // Make MicroPython's stack limit somewhat smaller than full stack available
     mp_stack_set_limit(CONFIG_MAIN_STACK_SIZE - 512);
@@ -163,11 +367,27 @@ int real_main(void) {
     printf("status: %d\n", r);
     #endif
 
+    #ifdef CONFIG_MICROPY_RETAINED_VM
+    if (resume) {
+        #ifdef CONFIG_USB_DEVICE_STACK
+        usb_enable(NULL);
+        #endif
+        retained_vm_resume();
+        goto repl;
+    }
+    #endif
+
 soft_reset:
+    MP_ZEPHYR_BOOT_PHASE(MP_ZEPHYR_BOOT_PHASE_START);
+
     #if MICROPY_ENABLE_GC
     gc_init(heap, heap + sizeof(heap));
     #endif
     mp_init();
+    #ifdef CONFIG_MICROPY_RETAINED_VM
+    MP_STATE_PORT(zephyr_wake_handler) = mp_const_none;
+    #endif
+    MP_ZEPHYR_BOOT_PHASE(MP_ZEPHYR_BOOT_PHASE_INIT);
 
     #ifdef CONFIG_USB_DEVICE_STACK
     usb_enable(NULL);
@@ -176,9 +396,13 @@ soft_reset:
     #if MICROPY_VFS
     vfs_init();
     #endif
+    MP_ZEPHYR_BOOT_PHASE(MP_ZEPHYR_BOOT_PHASE_VFS);
 
     exec_main_py();
 
+    #ifdef CONFIG_MICROPY_RETAINED_VM
+repl:
+    #endif
     for (;;) {
         if (pyexec_mode_kind == PYEXEC_MODE_RAW_REPL) {
             if (pyexec_raw_repl() != 0) {
@@ -264,40 +488,16 @@ void exec_main_py(void) {
     }
     #endif // DT_HAS_CHOSEN(micropython_skip_main)
     #if MICROPY_VFS && !CONFIG_CONSOLE_SUBSYS
-    nlr_buf_t nlr;
-    mp_obj_t filename = mp_obj_new_str("/flash/settings/start_delay", strlen("/flash/settings/start_delay"));
-    if (nlr_push(&nlr) == 0) {
-        mp_vfs_stat(filename);
-        nlr_pop();
-    } else {
-        /* There is no start_delay settings file */
-        goto start_main;
-    }
-    mp_obj_t args[2] = {
-        filename,
-        MP_OBJ_NEW_QSTR(MP_QSTR_rb),
-    };
-    mp_obj_t file = mp_vfs_open(MP_ARRAY_SIZE(args), &args[0], (mp_map_t *)&mp_const_empty_map);
-    uint8_t buf[3]; /* Limits delay to 99 seconds */
-    int ret;
-    int len = mp_stream_read_exactly(file, &buf[0], sizeof(buf) - 1, &ret);
-    mp_stream_close(file);
-    buf[len] = '\0';
-
-    uint32_t delay;
-    ret = sscanf(buf, "%u", &delay);
-    if (ret != 1) {
-        /* Didn't find just an unsigned int */
-        goto start_main;
-    }
-    printk("Press a key in the next %u seconds to stop main.py execution\n", delay);
-    if (zephyr_getchar_timeout(delay * 1000, (uint8_t *)&ret) == 0) {
-    /* Received a character. Skip main */
-        goto skip_main;
+    if (boot_settings_valid() && boot_settings.start_delay > 0) {
+        uint8_t c;
+        printk("Press a key in the next %u seconds to stop main.py execution\n", boot_settings.start_delay);
+        if (zephyr_getchar_timeout(boot_settings.start_delay * 1000, &c) == 0) {
+            /* Received a character. Skip main */
+            goto skip_main;
+        }
     }
-
-    start_main:
     #endif  // MICROPY_VFS && !CONFIG_CONSOLE_SUBSYS
+    MP_ZEPHYR_BOOT_PHASE(MP_ZEPHYR_BOOT_PHASE_MAIN);
     pyexec_file_if_exists("main.py");
     skip_main:
     #endif  // MICROPY_MODULE_FROZEN || MICROPY_VFS
@@ -0,0 +1,184 @@
+#!/usr/bin/env python
+
+# This file is part of the MicroPython project, http://micropython.org/
+#
+# The MIT License (MIT)
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+
+# Generate a delta patch for zephyr.DFU(delta=True) from the signed image that
+# is currently running (eg build/zephyr/app_update.bin of the old build) and
+# the new signed image.  See zephyr_dfu.c for the format.
+#
+# Matching is done bsdiff-style: regions of the new image are paired with a
+# region of the old one and stored as a bytewise difference, which is mostly
+# zeros (plus relocated addresses) and so compresses well with --zlib.
+
+import argparse
+import struct
+import sys
+import zlib
+
+MAGIC = b"MPD1"
+BLOCK = 8
+MIN_MATCH = 32
+
+
+def uleb128(value):
+    out = bytearray()
+    while True:
+        b = value & 0x7F
+        value >>= 7
+        if value:
+            out.append(b | 0x80)
+        else:
+            out.append(b)
+            return out
+
+
+def zigzag(value):
+    return (value << 1) if value >= 0 else ((-value << 1) - 1)
+
+
+def index_blocks(old):
+    index = {}
+    for i in range(0, len(old) - BLOCK + 1, 2):
+        index.setdefault(old[i : i + BLOCK], i)
+    return index
+
+
+def extend(old, o, new, n):
+    # Grow the match while 2 * equal - length keeps improving, so that short
+    # runs of differing bytes (eg relocated pointers) stay inside the diff.
+    score = best_score = 0
+    length = best_len = 0
+    limit = min(len(old) - o, len(new) - n)
+    while length < limit:
+        score += 1 if old[o + length] == new[n + length] else -1
+        length += 1
+        if score > best_score:
+            best_score = score
+            best_len = length
+        elif score < best_score - 64:
+            break
+    return best_len
+
+
+def find_matches(old, new):
+    index = index_blocks(old)
+    matches = []
+    n = 0
+    next_old = 0
+    while n <= len(new) - BLOCK:
+        # Prefer carrying on from where the previous match ended
+        o = next_old if new[n : n + BLOCK] == old[next_old : next_old + BLOCK] else None
+        if o is None:
+            o = index.get(new[n : n + BLOCK])
+        if o is not None:
+            length = extend(old, o, new, n)
+            if length >= MIN_MATCH:
+                matches.append((n, o, length))
+                n += length
+                next_old = o + length
+                continue
+        n += 1
+    return matches
+
+
+def make_delta(old, new):
+    out = bytearray(MAGIC + struct.pack("<I", len(new)))
+    matches = find_matches(old, new)
+    # The first record has no diff and only carries the bytes before the first match
+    new_pos = 0
+    old_pos = 0
+    diff = b""
+    for n, o, length in matches + [(len(new), old_pos, 0)]:
+        out += uleb128(len(diff))
+        out += uleb128(n - new_pos)
+        out += uleb128(zigzag(o - old_pos))
+        out += diff
+        out += new[new_pos:n]
+        diff = bytes((new[n + i] - old[o + i]) & 0xFF for i in range(length))
+        new_pos = n + length
+        old_pos = o + length
+    return bytes(out)
+
+
+def apply_delta(old, delta):
+    if delta[:4] != MAGIC:
+        raise ValueError("bad magic")
+    (size,) = struct.unpack_from("<I", delta, 4)
+    pos = 8
+    old_pos = 0
+    new = bytearray()
+
+    def read_uleb():
+        nonlocal pos
+        value = shift = 0
+        while True:
+            b = delta[pos]
+            pos += 1
+            value |= (b & 0x7F) << shift
+            shift += 7
+            if not b & 0x80:
+                return value
+
+    while pos < len(delta):
+        diff_len = read_uleb()
+        extra_len = read_uleb()
+        seek = read_uleb()
+        seek = (seek >> 1) ^ -(seek & 1)
+        new += bytes((delta[pos + i] + old[old_pos + i]) & 0xFF for i in range(diff_len))
+        pos += diff_len
+        old_pos += diff_len
+        new += delta[pos : pos + extra_len]
+        pos += extra_len
+        old_pos += seek
+    if len(new) != size:
+        raise ValueError("size mismatch")
+    return bytes(new)
+
+
+def main():
+    cmd_parser = argparse.ArgumentParser(description="Make a delta patch for zephyr.DFU.")
+    cmd_parser.add_argument("old", help="signed image currently in the primary slot")
+    cmd_parser.add_argument("new", help="new signed image")
+    cmd_parser.add_argument("output", help="output delta file")
+    cmd_parser.add_argument("--zlib", action="store_true", help="compress for deflate.DeflateIO")
+    args = cmd_parser.parse_args()
+
+    with open(args.old, "rb") as f:
+        old = f.read()
+    with open(args.new, "rb") as f:
+        new = f.read()
+
+    delta = make_delta(old, new)
+    if apply_delta(old, delta) != new:
+        print("error: delta does not reproduce the new image", file=sys.stderr)
+        sys.exit(1)
+    if args.zlib:
+        delta = zlib.compress(delta, 9)
+
+    with open(args.output, "wb") as f:
+        f.write(delta)
+    print("{}: {} bytes ({:.1%} of new image)".format(args.output, len(delta), len(delta) / len(new)))
+
+
+if __name__ == "__main__":
+    main()
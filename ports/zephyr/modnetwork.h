@@ -72,6 +72,14 @@ MP_DECLARE_CONST_FUN_OBJ_0(zephyr_network_initialize_obj);
 
 #ifdef CONFIG_PDN
 #include <modem/pdn.h>
+#include <zephyr/net/socket.h>
+
+// PDN routing table, used by the socket module. route_bind() binds fd to the
+// PDN routed for addr and returns its context ID, or 0 (the default context).
+int network_nrf91_route_bind(int fd, const struct sockaddr *addr);
+void network_nrf91_route_learn(const char *host, const struct sockaddr *addr);
+int network_nrf91_pdn_cid(int pdn_id);
+void network_nrf91_pdn_count(int cid, size_t tx, size_t rx);
 #endif
 
 #endif // MICROPY_PY_NETWORK_NRF91
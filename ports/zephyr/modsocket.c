@@ -45,6 +45,12 @@
 #include <zephyr/net/tls_credentials.h>
 #endif
 
+// Route connections through the nRF91 PDN routing table
+#define SOCKET_PDN_ROUTING (CONFIG_PDN && MICROPY_PY_NETWORK_NRF91)
+#if SOCKET_PDN_ROUTING
+#include "modnetwork.h"
+#endif
+
 #define DEBUG_PRINT 1
 #if DEBUG_PRINT // print debugging info
 #define DEBUG_printf printf
@@ -52,6 +58,23 @@
 #define DEBUG_printf(...) (void)0
 #endif
 
+#if CONFIG_MICROPY_SOCKET_STATS
+typedef struct _socket_stats_t {
+    uint32_t tx_bytes;
+    uint32_t rx_bytes;
+    uint32_t tx_calls;
+    uint32_t rx_calls;
+    uint32_t eagain;
+    // 64-bit so that the totals don't wrap after 71 minutes
+    uint64_t send_us;
+    uint64_t recv_us;
+    uint64_t connect_us;
+} socket_stats_t;
+
+// Totals over all sockets since boot
+static socket_stats_t socket_stats_total;
+#endif
+
 typedef struct _socket_obj_t {
     mp_obj_base_t base;
     int ctx;
@@ -62,6 +85,13 @@ typedef struct _socket_obj_t {
     #define STATE_PEER_CLOSED 3
     int8_t state;
     sa_family_t family;
+    #if CONFIG_MICROPY_SOCKET_STATS
+    socket_stats_t stats;
+    #endif
+    #if SOCKET_PDN_ROUTING
+    int8_t cid; // PDN context carrying the traffic
+    bool pdn_bound; // bound by hand with socket.pdn(), skip routing
+    #endif
 } socket_obj_t;
 
 STATIC const mp_obj_type_t socket_type;
@@ -71,6 +101,64 @@ STATIC const mp_obj_type_t socket_type;
 #define RAISE_ERRNO(x) { int _err = x; if (_err < 0) mp_raise_OSError(-_err); }
 #define RAISE_SOCK_ERRNO(x) { if ((int)(x) == -1) mp_raise_OSError(errno); }
 
+#if CONFIG_MICROPY_SOCKET_STATS
+#define SOCKET_STATS_START(var) uint32_t var = k_cycle_get_32()
+
+enum {
+    SOCKET_STATS_SEND,
+    SOCKET_STATS_RECV,
+    SOCKET_STATS_CONNECT,
+};
+
+// Account for one send/recv/connect call that started at cycle count start
+// and returned res, on both the socket and the global totals.
+STATIC void socket_stats_update(socket_obj_t *socket, int op, ssize_t res, uint32_t start) {
+    uint32_t us = k_cyc_to_us_floor32(k_cycle_get_32() - start);
+    bool eagain = res == -1 && errno == EAGAIN;
+    socket_stats_t *stats[2] = { &socket->stats, &socket_stats_total };
+    for (size_t i = 0; i < MP_ARRAY_SIZE(stats); ++i) {
+        socket_stats_t *s = stats[i];
+        switch (op) {
+            case SOCKET_STATS_SEND:
+                s->tx_calls++;
+                s->send_us += us;
+                if (res > 0) {
+                    s->tx_bytes += res;
+                }
+                break;
+            case SOCKET_STATS_RECV:
+                s->rx_calls++;
+                s->recv_us += us;
+                if (res > 0) {
+                    s->rx_bytes += res;
+                }
+                break;
+            default:
+                s->connect_us += us;
+                break;
+        }
+        s->eagain += eagain;
+    }
+}
+
+STATIC mp_obj_t socket_stats_tuple(const socket_stats_t *stats) {
+    mp_obj_t items[8] = {
+        mp_obj_new_int_from_uint(stats->tx_bytes),
+        mp_obj_new_int_from_uint(stats->rx_bytes),
+        mp_obj_new_int_from_uint(stats->tx_calls),
+        mp_obj_new_int_from_uint(stats->rx_calls),
+        mp_obj_new_int_from_uint(stats->eagain),
+        mp_obj_new_int_from_ull(stats->send_us),
+        mp_obj_new_int_from_ull(stats->recv_us),
+        mp_obj_new_int_from_ull(stats->connect_us),
+    };
+    return mp_obj_new_tuple(MP_ARRAY_SIZE(items), items);
+}
+#else
+#define SOCKET_STATS_START(var)
+#define socket_stats_update(socket, op, res, start)
+#endif
+
 STATIC void socket_check_closed(socket_obj_t *socket) {
     if (socket->ctx == -1) {
         // already closed
@@ -116,6 +204,13 @@ socket_obj_t *socket_new(void) {
     socket_obj_t *socket = m_new_obj_with_finaliser(socket_obj_t);
     socket->base.type = (mp_obj_t)&socket_type;
     socket->state = STATE_NEW;
+    #if CONFIG_MICROPY_SOCKET_STATS
+    memset(&socket->stats, 0, sizeof(socket->stats));
+    #endif
+    #if SOCKET_PDN_ROUTING
+    socket->cid = 0;
+    socket->pdn_bound = false;
+    #endif
     return socket;
 }
 
@@ -212,7 +307,16 @@ STATIC mp_obj_t socket_connect(mp_obj_t self_in, mp_obj_t addr_in) {
     struct sockaddr sockaddr;
     parse_inet_addr(socket, addr_in, &sockaddr);
 
+    #if SOCKET_PDN_ROUTING
+    // Binding to a PDN is only possible before connecting
+    if (!socket->pdn_bound) {
+        socket->cid = network_nrf91_route_bind(socket->ctx, &sockaddr);
+    }
+    #endif
+
+    SOCKET_STATS_START(start);
     int res = zsock_connect(socket->ctx, &sockaddr, sizeof(sockaddr));
+    socket_stats_update(socket, SOCKET_STATS_CONNECT, res, start);
     RAISE_SOCK_ERRNO(res);
 
     return mp_const_none;
@@ -265,11 +369,16 @@ STATIC mp_uint_t sock_write(mp_obj_t self_in, const void *buf, mp_uint_t size, i
         return MP_STREAM_ERROR;
     }
 
+    SOCKET_STATS_START(start);
     ssize_t len = zsock_send(socket->ctx, buf, size, 0);
+    socket_stats_update(socket, SOCKET_STATS_SEND, len, start);
     if (len == -1) {
         *errcode = errno;
         return MP_STREAM_ERROR;
     }
+    #if SOCKET_PDN_ROUTING
+    network_nrf91_pdn_count(socket->cid, len, 0);
+    #endif
 
     return len;
 }
@@ -294,11 +403,16 @@ STATIC mp_uint_t sock_read(mp_obj_t self_in, void *buf, mp_uint_t max_len, int *
         return MP_STREAM_ERROR;
     }
 
+    SOCKET_STATS_START(start);
     ssize_t recv_len = zsock_recv(socket->ctx, buf, max_len, 0);
+    socket_stats_update(socket, SOCKET_STATS_RECV, recv_len, start);
     if (recv_len == -1) {
         *errcode = errno;
         return MP_STREAM_ERROR;
     }
+    #if SOCKET_PDN_ROUTING
+    network_nrf91_pdn_count(socket->cid, 0, recv_len);
+    #endif
 
     return recv_len;
 }
@@ -308,6 +422,7 @@ STATIC mp_obj_t socket_recv(mp_obj_t self_in, mp_obj_t len_in) {
     vstr_t vstr;
     // +1 to accommodate for trailing \0
     vstr_init_len(&vstr, max_len + 1);
+    m_set_no_scan(vstr.buf);
 
     int err;
     mp_uint_t len = sock_read(self_in, vstr.buf, max_len, &err);
@@ -352,6 +467,14 @@ STATIC mp_obj_t socket_setblocking(mp_obj_t self_in, mp_obj_t blocking) {
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_2(socket_setblocking_obj, socket_setblocking);
 
+#if CONFIG_MICROPY_SOCKET_STATS
+STATIC mp_obj_t socket_stats(mp_obj_t self_in) {
+    socket_obj_t *socket = self_in;
+    return socket_stats_tuple(&socket->stats);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(socket_stats_obj, socket_stats);
+#endif
+
 STATIC mp_obj_t socket_makefile(size_t n_args, const mp_obj_t *args) {
     (void)n_args;
     return args[0];
@@ -391,6 +514,10 @@ STATIC mp_obj_t socket_pdn(mp_obj_t self_in, mp_obj_t id) {
     if (ret) {
         mp_raise_OSError(ret);
     }
+    #if SOCKET_PDN_ROUTING
+    socket->cid = network_nrf91_pdn_cid(pdn_id);
+    socket->pdn_bound = true;
+    #endif
     return mp_const_none;
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_2(socket_pdn_obj, socket_pdn);
@@ -407,6 +534,9 @@ STATIC const mp_rom_map_elem_t socket_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_recv), MP_ROM_PTR(&socket_recv_obj) },
     { MP_ROM_QSTR(MP_QSTR_setsockopt), MP_ROM_PTR(&socket_setsockopt_obj) },
     { MP_ROM_QSTR(MP_QSTR_setblocking), MP_ROM_PTR(&socket_setblocking_obj) },
+    #if CONFIG_MICROPY_SOCKET_STATS
+    { MP_ROM_QSTR(MP_QSTR_stats), MP_ROM_PTR(&socket_stats_obj) },
+    #endif
 
     { MP_ROM_QSTR(MP_QSTR_read), MP_ROM_PTR(&mp_stream_read_obj) },
     { MP_ROM_QSTR(MP_QSTR_readinto), MP_ROM_PTR(&mp_stream_readinto_obj) },
@@ -512,15 +642,19 @@ STATIC mp_obj_t mod_getaddrinfo(size_t n_args, const mp_obj_t *args) {
 
     RAISE_ERRNO(getaddrinfo(host, NULL, &hints, &ai));
 
-    do {
+    for (struct addrinfo *cur = ai; cur != NULL; cur = cur->ai_next) {
         mp_obj_tuple_t *tuple = mp_obj_new_tuple(5, NULL);
-        tuple->items[0] = MP_OBJ_NEW_SMALL_INT(ai->ai_addr->sa_family);
-        tuple->items[1] = MP_OBJ_NEW_SMALL_INT(ai->ai_socktype);
-        tuple->items[2] = MP_OBJ_NEW_SMALL_INT(ai->ai_protocol);
+        tuple->items[0] = MP_OBJ_NEW_SMALL_INT(cur->ai_addr->sa_family);
+        tuple->items[1] = MP_OBJ_NEW_SMALL_INT(cur->ai_socktype);
+        tuple->items[2] = MP_OBJ_NEW_SMALL_INT(cur->ai_protocol);
         tuple->items[3] = MP_OBJ_NEW_QSTR(MP_QSTR_);
-        tuple->items[4] = format_inet_addr(ai->ai_addr, state.port);
+        tuple->items[4] = format_inet_addr(cur->ai_addr, state.port);
         mp_obj_list_append(state.result, MP_OBJ_FROM_PTR(tuple));
-    } while (ai->ai_next != NULL);
+        #if SOCKET_PDN_ROUTING
+        // Hostname routes apply to the addresses the name resolved to
+        network_nrf91_route_learn(host, cur->ai_addr);
+        #endif
+    }
     freeaddrinfo(ai);
     #endif // !CONFIG_NET_SOCKETS_OFFLOAD
     return state.result;
@@ -542,6 +676,13 @@ STATIC mp_obj_t pkt_get_info(void) {
 STATIC MP_DEFINE_CONST_FUN_OBJ_0(pkt_get_info_obj, pkt_get_info);
 #endif
 
+#if CONFIG_MICROPY_SOCKET_STATS
+STATIC mp_obj_t mod_stats(void) {
+    return socket_stats_tuple(&socket_stats_total);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(mod_stats_obj, mod_stats);
+#endif
+
 STATIC const mp_rom_map_elem_t mp_module_socket_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_socket) },
     // objects
@@ -565,6 +706,9 @@ STATIC const mp_rom_map_elem_t mp_module_socket_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR_SO_REUSEADDR), MP_ROM_INT(2) },
 
     { MP_ROM_QSTR(MP_QSTR_getaddrinfo), MP_ROM_PTR(&mod_getaddrinfo_obj) },
+    #if CONFIG_MICROPY_SOCKET_STATS
+    { MP_ROM_QSTR(MP_QSTR_stats), MP_ROM_PTR(&mod_stats_obj) },
+    #endif
     #if !CONFIG_NET_SOCKETS_OFFLOAD
     { MP_ROM_QSTR(MP_QSTR_pkt_get_info), MP_ROM_PTR(&pkt_get_info_obj) },
     #endif
@@ -105,6 +105,48 @@ STATIC mp_obj_t console_is_enabled() {
 STATIC MP_DEFINE_CONST_FUN_OBJ_0(console_is_enabled_obj, console_is_enabled);
 #endif
 
+#ifdef CONFIG_MICROPY_BOOT_TIMING
+STATIC mp_obj_t mod_boot_times(void) {
+    mp_obj_t items[MP_ZEPHYR_BOOT_PHASE_NUM];
+    for (size_t i = 0; i < MP_ZEPHYR_BOOT_PHASE_NUM; ++i) {
+        items[i] = mp_obj_new_int_from_uint(mp_zephyr_boot_times[i]);
+    }
+    return mp_obj_new_tuple(MP_ZEPHYR_BOOT_PHASE_NUM, items);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(mod_boot_times_obj, mod_boot_times);
+#endif
+
+#ifdef CONFIG_MICROPY_RETAINED_VM
+STATIC mp_obj_t mod_wake_handler(size_t n_args, const mp_obj_t *args) {
+    if (n_args == 0) {
+        return MP_STATE_PORT(zephyr_wake_handler);
+    }
+    if (args[0] != mp_const_none && !mp_obj_is_callable(args[0])) {
+        mp_raise_ValueError(MP_ERROR_TEXT("invalid handler"));
+    }
+    MP_STATE_PORT(zephyr_wake_handler) = args[0];
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mod_wake_handler_obj, 0, 1, mod_wake_handler);
+
+STATIC mp_obj_t mod_hibernate(void) {
+    mp_zephyr_hibernate();
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(mod_hibernate_obj, mod_hibernate);
+#endif
+
+#if MICROPY_VFS && !CONFIG_CONSOLE_SUBSYS
+STATIC mp_obj_t mod_start_delay(size_t n_args, const mp_obj_t *args) {
+    if (n_args == 0) {
+        return mp_obj_new_int(mp_zephyr_start_delay_get());
+    }
+    mp_zephyr_start_delay_set(mp_obj_get_int(args[0]));
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mod_start_delay_obj, 0, 1, mod_start_delay);
+#endif
+
 STATIC const mp_rom_map_elem_t mp_module_time_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_zephyr) },
     { MP_ROM_QSTR(MP_QSTR_is_preempt_thread), MP_ROM_PTR(&mod_is_preempt_thread_obj) },
@@ -121,6 +163,19 @@ STATIC const mp_rom_map_elem_t mp_module_time_globals_table[] = {
     #ifdef CONFIG_FLASH_MAP
     { MP_ROM_QSTR(MP_QSTR_FlashArea), MP_ROM_PTR(&zephyr_flash_area_type) },
     #endif
+    #ifdef CONFIG_IMG_MANAGER
+    { MP_ROM_QSTR(MP_QSTR_DFU), MP_ROM_PTR(&zephyr_dfu_type) },
+    #endif
+    #ifdef CONFIG_MICROPY_BOOT_TIMING
+    { MP_ROM_QSTR(MP_QSTR_boot_times), MP_ROM_PTR(&mod_boot_times_obj) },
+    #endif
+    #ifdef CONFIG_MICROPY_RETAINED_VM
+    { MP_ROM_QSTR(MP_QSTR_wake_handler), MP_ROM_PTR(&mod_wake_handler_obj) },
+    { MP_ROM_QSTR(MP_QSTR_hibernate), MP_ROM_PTR(&mod_hibernate_obj) },
+    #endif
+    #if MICROPY_VFS && !CONFIG_CONSOLE_SUBSYS
+    { MP_ROM_QSTR(MP_QSTR_start_delay), MP_ROM_PTR(&mod_start_delay_obj) },
+    #endif
     #if defined(CONFIG_PM_DEVICE) && !defined(CONFIG_CONSOLE_SUBSYS)
     { MP_ROM_QSTR(MP_QSTR_console_disable), MP_ROM_PTR(&console_disable_obj) },
     { MP_ROM_QSTR(MP_QSTR_console_enable), MP_ROM_PTR(&console_enable_obj) },
@@ -137,4 +192,8 @@ const mp_obj_module_t mp_module_zephyr = {
 
 MP_REGISTER_MODULE(MP_QSTR_zephyr, mp_module_zephyr);
 
+#ifdef CONFIG_MICROPY_RETAINED_VM
+MP_REGISTER_ROOT_POINTER(mp_obj_t zephyr_wake_handler);
+#endif
+
 #endif // MICROPY_PY_ZEPHYR
@@ -37,4 +37,34 @@ extern const mp_obj_type_t zephyr_disk_access_type;
 extern const mp_obj_type_t zephyr_flash_area_type;
 #endif
 
+#ifdef CONFIG_IMG_MANAGER
+extern const mp_obj_type_t zephyr_dfu_type;
+#endif
+
+// Boot phases timestamped (in microseconds of uptime) for zephyr.boot_times().
+enum {
+    MP_ZEPHYR_BOOT_PHASE_START,
+    MP_ZEPHYR_BOOT_PHASE_INIT,
+    MP_ZEPHYR_BOOT_PHASE_VFS,
+    MP_ZEPHYR_BOOT_PHASE_MAIN,
+    MP_ZEPHYR_BOOT_PHASE_MODEM,
+    MP_ZEPHYR_BOOT_PHASE_NUM,
+};
+
+#ifdef CONFIG_MICROPY_BOOT_TIMING
+extern uint32_t mp_zephyr_boot_times[MP_ZEPHYR_BOOT_PHASE_NUM];
+#define MP_ZEPHYR_BOOT_PHASE(phase) (mp_zephyr_boot_times[(phase)] = (uint32_t)k_ticks_to_us_floor64(k_uptime_ticks()))
+#else
+#define MP_ZEPHYR_BOOT_PHASE(phase)
+#endif
+
+#ifdef CONFIG_MICROPY_RETAINED_VM
+void mp_zephyr_hibernate(void);
+#endif
+
+#if MICROPY_VFS && !CONFIG_CONSOLE_SUBSYS
+mp_int_t mp_zephyr_start_delay_get(void);
+void mp_zephyr_start_delay_set(mp_int_t delay);
+#endif
+
 #endif // MICROPY_INCLUDED_ZEPHYR_MODZEPHYR_H
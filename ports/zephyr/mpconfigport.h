@@ -70,11 +70,14 @@
 #define MICROPY_STACK_CHECK         (1)
 #define MICROPY_ENABLE_GC           (1)
 #define MICROPY_ENABLE_FINALISER    (MICROPY_VFS)
+#define MICROPY_VM_FRAME_CACHE      (1)
+#define MICROPY_OPT_INSTANCE_SHAPES (1)
 #define MICROPY_REPL_AUTO_INDENT    (1)
 #define MICROPY_CPYTHON_COMPAT      (1)
 #define MICROPY_PY_ASYNC_AWAIT      (0)
 #define MICROPY_PY_ATTRTUPLE        (0)
 #define MICROPY_PY_BUILTINS_BYTES_HEX (1)
+#define MICROPY_PY_ARRAY_BULK       (1)
 #define MICROPY_PY_BUILTINS_ENUMERATE (0)
 #define MICROPY_PY_BUILTINS_FILTER  (0)
 #define MICROPY_PY_BUILTINS_MIN_MAX (0)
@@ -148,6 +151,9 @@ extern const struct _mp_obj_type_t zephyr_network_cell_type;
 #define MICROPY_PY_BUILTINS_COMPLEX (0)
 #define MICROPY_VFS                 (1)
 #define MICROPY_READER_VFS          (MICROPY_VFS)
+#ifdef CONFIG_MICROPY_ROMFS
+#define MICROPY_VFS_ROM             (1)
+#endif
 
 // fatfs configuration used in ffconf.h
 #define MICROPY_FATFS_ENABLE_LFN (1)
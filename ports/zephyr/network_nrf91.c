@@ -25,6 +25,7 @@
  */
 
 #include <string.h>
+#include <strings.h>
 
 #include <zephyr/kernel.h>
 #include "py/objlist.h"
@@ -32,9 +33,11 @@
 #include "py/mphal.h"
 #include "extmod/modnetwork.h"
 #include "modnetwork.h"
+#include "modzephyr.h"
 
 #if MICROPY_PY_NETWORK_NRF91
 #include <stdio.h>
+#include <stdlib.h>
 #include <modem/nrf_modem_lib.h>
 #include <nrf_modem_at.h>
 #include <modem/lte_lc.h>
@@ -284,10 +287,238 @@ static void location_event_handler(const struct location_event_data *event_data)
 }
 #endif // CONFIG_MICROPY_NRF91_LOCATION
 
+#ifdef CONFIG_MICROPY_NRF91_MODEM_EARLY_INIT
+// The modem library takes hundreds of ms to initialise, most of it waiting on
+// the modem.  Start it from a thread with a higher priority than main so that
+// it gets going straight away, then yields to main (mounting the filesystem,
+// running main.py) while it blocks.
+static K_SEM_DEFINE(modem_init_sem, 0, 1);
+
+static void modem_init_thread(void *p1, void *p2, void *p3) {
+    int ret = nrf_modem_lib_init();
+    if (ret) {
+        LOG_ERR("Modem library init failed: %d", ret);
+    }
+    MP_ZEPHYR_BOOT_PHASE(MP_ZEPHYR_BOOT_PHASE_MODEM);
+    k_sem_give(&modem_init_sem);
+}
+K_THREAD_DEFINE(modem_init_tid, CONFIG_MICROPY_NRF91_MODEM_INIT_STACK_SIZE, modem_init_thread,
+    NULL, NULL, NULL, CONFIG_MAIN_THREAD_PRIORITY - 1, 0, 0);
+#endif // CONFIG_MICROPY_NRF91_MODEM_EARLY_INIT
+
+#ifdef CONFIG_PDN
+// PDN routing: new sockets are bound to a PDN picked by their destination.
+// Routes match either an address prefix ("10.0.0.0/8") or a hostname pattern
+// ("*.example.com"); hostname routes apply to the addresses getaddrinfo()
+// returned for a matching name.  When the PDN of a route is down its
+// fallback is used instead.
+#define PDN_CID_MAX         (16)
+#define PDN_ROUTES_MAX      (CONFIG_MICROPY_NRF91_PDN_ROUTES)
+#define PDN_HOST_CACHE_MAX  (8)
+#define PDN_ROUTE_DEST_LEN  (48)
+#define PDN_ID_UNKNOWN      (-2)
+
+typedef struct _pdn_route_t {
+    int8_t cid;                 // -1 for an unused entry
+    int8_t fallback;            // -1 for none
+    uint8_t family;             // AF_INET/AF_INET6 for a prefix, 0 for a hostname pattern
+    uint8_t prefix_len;
+    uint8_t addr[16];
+    char dest[PDN_ROUTE_DEST_LEN];
+} pdn_route_t;
+
+typedef struct _pdn_host_addr_t {
+    int8_t route;               // index into pdn_routes, -1 for an unused entry
+    uint8_t family;
+    uint8_t addr[16];
+} pdn_host_addr_t;
+
+typedef struct _pdn_counters_t {
+    uint32_t tx_bytes;
+    uint32_t rx_bytes;
+} pdn_counters_t;
+
+static pdn_route_t pdn_routes[PDN_ROUTES_MAX] = { [0 ... PDN_ROUTES_MAX - 1] = { .cid = -1 } };
+static pdn_host_addr_t pdn_host_cache[PDN_HOST_CACHE_MAX] = { [0 ... PDN_HOST_CACHE_MAX - 1] = { .route = -1 } };
+static size_t pdn_host_cache_next;
+static pdn_counters_t pdn_counters[PDN_CID_MAX];
+// The state below is updated both from the PDN library's event callback and
+// from the socket path, so it is kept in atomics.
+// Bit n is set while context n is deactivated or detached.
+static atomic_t pdn_down_mask;
+// PDN id of each context in the low byte, -1 if it has none, and above it a
+// count of the times the context changed state.  The id is looked up with an
+// AT command on first use and forgotten whenever the context changes state.
+#define PDN_ID_ENTRY(gen, pdn_id) (((gen) & 0xff00) | (uint8_t)(pdn_id))
+#define PDN_ID_GEN (0x100)
+static atomic_t pdn_ids[PDN_CID_MAX] = { [0 ... PDN_CID_MAX - 1] = ATOMIC_INIT(PDN_ID_ENTRY(0, PDN_ID_UNKNOWN)) };
+
+static int pdn_id_cached(int cid) {
+    atomic_val_t entry = atomic_get(&pdn_ids[cid]);
+    int pdn_id = (int8_t)entry;
+    if (pdn_id == PDN_ID_UNKNOWN) {
+        pdn_id = pdn_id_get(cid);
+        if (pdn_id < 0 || pdn_id > INT8_MAX) {
+            pdn_id = -1;
+        }
+        // Only keep the id if the context didn't change state during the lookup
+        atomic_cas(&pdn_ids[cid], entry, PDN_ID_ENTRY(entry, pdn_id));
+    }
+    return pdn_id;
+}
+
+static void pdn_id_forget(int cid) {
+    atomic_val_t entry;
+    do {
+        entry = atomic_get(&pdn_ids[cid]);
+    } while (!atomic_cas(&pdn_ids[cid], entry, PDN_ID_ENTRY(entry + PDN_ID_GEN, PDN_ID_UNKNOWN)));
+}
+
+static void pdn_event_handler(uint8_t cid, enum pdn_event event, int reason) {
+    if (cid >= PDN_CID_MAX) {
+        return;
+    }
+    pdn_id_forget(cid);
+    switch (event) {
+        case PDN_EVENT_ACTIVATED:
+            atomic_clear_bit(&pdn_down_mask, cid);
+            break;
+        case PDN_EVENT_DEACTIVATED:
+        case PDN_EVENT_NETWORK_DETACH:
+        case PDN_EVENT_CTX_DESTROYED:
+            LOG_DBG("PDN %d down, event %d reason %d", cid, event, reason);
+            atomic_set_bit(&pdn_down_mask, cid);
+            break;
+        default:
+            break;
+    }
+}
+
+static bool pdn_is_up(int cid) {
+    return cid >= 0 && cid < PDN_CID_MAX && !atomic_test_bit(&pdn_down_mask, cid);
+}
+
+static int pdn_route_select(const pdn_route_t *route) {
+    if (!pdn_is_up(route->cid) && pdn_is_up(route->fallback)) {
+        return route->fallback;
+    }
+    return route->cid;
+}
+
+static const uint8_t *pdn_sockaddr_bytes(const struct sockaddr *addr) {
+    if (addr->sa_family == AF_INET) {
+        return (const uint8_t *)&((const struct sockaddr_in *)addr)->sin_addr;
+    }
+    return (const uint8_t *)&((const struct sockaddr_in6 *)addr)->sin6_addr;
+}
+
+static size_t pdn_addr_len(int family) {
+    return family == AF_INET ? 4 : 16;
+}
+
+static bool pdn_prefix_match(const pdn_route_t *route, const uint8_t *addr) {
+    size_t bytes = route->prefix_len / 8;
+    size_t bits = route->prefix_len % 8;
+    if (memcmp(route->addr, addr, bytes) != 0) {
+        return false;
+    }
+    return bits == 0 || ((route->addr[bytes] ^ addr[bytes]) & (0xff << (8 - bits))) == 0;
+}
+
+static bool pdn_host_match(const char *pattern, const char *host) {
+    if (pattern[0] == '*' && pattern[1] == '.') {
+        // "*.example.com" matches any name ending in ".example.com"
+        size_t plen = strlen(pattern + 1);
+        size_t hlen = strlen(host);
+        return hlen > plen && strcasecmp(host + hlen - plen, pattern + 1) == 0;
+    }
+    return strcasecmp(pattern, host) == 0;
+}
+
+// Returns the context that traffic to addr should use, or -1 if no route matches.
+static int pdn_route_lookup(const struct sockaddr *addr) {
+    const uint8_t *bytes = pdn_sockaddr_bytes(addr);
+    const pdn_route_t *best = NULL;
+    // Longest matching prefix wins
+    for (size_t i = 0; i < PDN_ROUTES_MAX; ++i) {
+        const pdn_route_t *route = &pdn_routes[i];
+        if (route->cid >= 0 && route->family == addr->sa_family && pdn_prefix_match(route, bytes)
+            && (best == NULL || route->prefix_len > best->prefix_len)) {
+            best = route;
+        }
+    }
+    if (best == NULL) {
+        for (size_t i = 0; i < PDN_HOST_CACHE_MAX; ++i) {
+            const pdn_host_addr_t *entry = &pdn_host_cache[i];
+            if (entry->route >= 0 && entry->family == addr->sa_family
+                && memcmp(entry->addr, bytes, pdn_addr_len(entry->family)) == 0) {
+                best = &pdn_routes[entry->route];
+                break;
+            }
+        }
+    }
+    return best == NULL ? -1 : pdn_route_select(best);
+}
+
+int network_nrf91_route_bind(int fd, const struct sockaddr *addr) {
+    int cid = pdn_route_lookup(addr);
+    if (cid < 0) {
+        return 0;
+    }
+    int pdn_id = pdn_id_cached(cid);
+    if (pdn_id < 0 || setsockopt(fd, SOL_SOCKET, SO_BINDTOPDN, &pdn_id, sizeof(pdn_id)) != 0) {
+        // Leave the socket on the default PDN rather than failing the connect
+        LOG_WRN("can't bind to PDN %d", cid);
+        return 0;
+    }
+    return cid;
+}
+
+void network_nrf91_route_learn(const char *host, const struct sockaddr *addr) {
+    for (size_t i = 0; i < PDN_ROUTES_MAX; ++i) {
+        const pdn_route_t *route = &pdn_routes[i];
+        if (route->cid >= 0 && route->family == 0 && pdn_host_match(route->dest, host)) {
+            pdn_host_addr_t *entry = &pdn_host_cache[pdn_host_cache_next];
+            pdn_host_cache_next = (pdn_host_cache_next + 1) % PDN_HOST_CACHE_MAX;
+            entry->route = i;
+            entry->family = addr->sa_family;
+            memcpy(entry->addr, pdn_sockaddr_bytes(addr), pdn_addr_len(addr->sa_family));
+            return;
+        }
+    }
+}
+
+int network_nrf91_pdn_cid(int pdn_id) {
+    if (pdn_id < 0) {
+        return 0;
+    }
+    for (int cid = 0; cid < PDN_CID_MAX; ++cid) {
+        if (pdn_id_cached(cid) == pdn_id) {
+            return cid;
+        }
+    }
+    return 0;
+}
+
+void network_nrf91_pdn_count(int cid, size_t tx, size_t rx) {
+    if (cid >= 0 && cid < PDN_CID_MAX) {
+        pdn_counters[cid].tx_bytes += tx;
+        pdn_counters[cid].rx_bytes += rx;
+    }
+}
+#endif // CONFIG_PDN
+
 STATIC mp_obj_t network_cell_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
     mp_arg_check_num(n_args, n_kw, 0, 1, false);
 
     int ret;
+    #ifdef CONFIG_MICROPY_NRF91_MODEM_EARLY_INIT
+    // Wait for the background init to finish; the semaphore is given back so
+    // that later constructions (and soft resets) don't block
+    if (k_sem_take(&modem_init_sem, K_FOREVER) == 0) {
+        k_sem_give(&modem_init_sem);
+    }
+    #endif
     if (!nrf_modem_is_initialized()) {
 		ret = nrf_modem_lib_init();
 		if (ret) {
@@ -300,6 +531,14 @@ STATIC mp_obj_t network_cell_make_new(const mp_obj_type_t *type, size_t n_args,
     // The LC library doesn't re-register the same handler, so we can safely call it 
     // multiple times. Init can also be called again and will return 0
     lte_lc_register_handler(lte_handler);
+#ifdef CONFIG_PDN
+    // Unlike lte_lc, the PDN library adds a new entry on every registration
+    static bool pdn_cb_registered;
+    if (!pdn_cb_registered) {
+        pdn_default_ctx_cb_reg(pdn_event_handler);
+        pdn_cb_registered = true;
+    }
+#endif
     return MP_OBJ_FROM_PTR(&cell_if);
 }
 
@@ -666,6 +905,51 @@ STATIC mp_obj_t network_cell_at(mp_obj_t self_in, mp_obj_t at_string) {
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_2(network_cell_at_obj, network_cell_at);
 
+STATIC void stats_store(mp_obj_t dict, qstr key, mp_int_t value) {
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(key), mp_obj_new_int(value));
+}
+
+STATIC mp_obj_t network_cell_stats(size_t n_args, const mp_obj_t *args) {
+    int ret;
+    if (n_args == 2) {
+        // Start (which also resets) or stop collecting connection statistics
+        CHECK_RET(nrf_modem_at_printf("AT%%XCONNSTAT=%d", mp_obj_is_true(args[1])));
+        return mp_const_none;
+    }
+    mp_obj_t dict = mp_obj_new_dict(0);
+
+    // %XCONNSTAT: <SMS Tx>,<SMS Rx>,<Data Tx kB>,<Data Rx kB>,<Packet max>,<Packet average>
+    uint32_t conn[6];
+    if (nrf_modem_at_scanf("AT%XCONNSTAT?", "%%XCONNSTAT: %u,%u,%u,%u,%u,%u",
+        &conn[0], &conn[1], &conn[2], &conn[3], &conn[4], &conn[5]) == 6) {
+        stats_store(dict, MP_QSTR_sms_tx, conn[0]);
+        stats_store(dict, MP_QSTR_sms_rx, conn[1]);
+        stats_store(dict, MP_QSTR_tx_kbytes, conn[2]);
+        stats_store(dict, MP_QSTR_rx_kbytes, conn[3]);
+        stats_store(dict, MP_QSTR_packet_max, conn[4]);
+        stats_store(dict, MP_QSTR_packet_avg, conn[5]);
+    }
+
+    // %XMONITOR: <reg_status>,<full_name>,<short_name>,<plmn>,<tac>,<AcT>,<band>,
+    //            <cell_id>,<phys_cell_id>,<EARFCN>,<rsrp>,<snr>,...
+    // Only reg_status is present when not registered.
+    int mon[5];
+    ret = nrf_modem_at_scanf("AT%XMONITOR",
+        "%%XMONITOR: %d,%*[^,],%*[^,],%*[^,],%*[^,],%d,%d,%*[^,],%*[^,],%*[^,],%d,%d",
+        &mon[0], &mon[1], &mon[2], &mon[3], &mon[4]);
+    if (ret >= 1) {
+        stats_store(dict, MP_QSTR_reg_status, mon[0]);
+    }
+    if (ret == 5) {
+        stats_store(dict, MP_QSTR_act, mon[1]);
+        stats_store(dict, MP_QSTR_band, mon[2]);
+        stats_store(dict, MP_QSTR_rsrp, RSRP_IDX_TO_DBM(mon[3]));
+        stats_store(dict, MP_QSTR_snr, mon[4] - 24);
+    }
+    return dict;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(network_cell_stats_obj, 1, 2, network_cell_stats);
+
 STATIC mp_obj_t network_cell_irq(size_t n_args, const mp_obj_t *args, mp_map_t *kwargs) {
     if (n_args > 1) {
         mp_raise_ValueError(MP_ERROR_TEXT("Arguments must be keyword based"));
@@ -962,10 +1246,15 @@ STATIC mp_obj_t network_cell_pdn_create(size_t n_args, const mp_obj_t *pos_args,
     uint8_t cid = -1;
     int ret;
 
-    ret = pdn_ctx_create(&cid, NULL);
+    ret = pdn_ctx_create(&cid, pdn_event_handler);
     if (ret) {
         goto fail;
     }
+    // Not usable for routing until the activation event arrives
+    if (cid < PDN_CID_MAX) {
+        atomic_set_bit(&pdn_down_mask, cid);
+        pdn_id_forget(cid);
+    }
     
     if (args[ARG_ip4_addr_alloc].u_int != 0 || args[ARG_nslpi].u_int != 0 || args[ARG_secure_pco].u_int != 0) {
         struct pdn_pdp_opt opts = {
@@ -1030,6 +1319,133 @@ STATIC mp_obj_t network_cell_pdn_default_apn(mp_obj_t self_in) {
     return mp_obj_new_str(buf, strlen(buf));
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(network_cell_pdn_default_apn_obj, network_cell_pdn_default_apn);
+
+// CELL.pdn_route(dest, cid[, fallback]): add or replace the route for dest.
+// A cid of None removes the route.
+STATIC mp_obj_t network_cell_pdn_route(size_t n_args, const mp_obj_t *args) {
+    size_t dest_len;
+    const char *dest = mp_obj_str_get_data(args[1], &dest_len);
+    if (dest_len == 0 || dest_len >= PDN_ROUTE_DEST_LEN) {
+        mp_raise_ValueError(MP_ERROR_TEXT("invalid destination"));
+    }
+
+    pdn_route_t *route = NULL;
+    pdn_route_t *free_route = NULL;
+    for (size_t i = 0; i < PDN_ROUTES_MAX; ++i) {
+        if (pdn_routes[i].cid < 0) {
+            if (free_route == NULL) {
+                free_route = &pdn_routes[i];
+            }
+        } else if (strcmp(pdn_routes[i].dest, dest) == 0) {
+            route = &pdn_routes[i];
+        }
+    }
+
+    // Cached hostname addresses may point at the entry being changed
+    for (size_t i = 0; i < PDN_HOST_CACHE_MAX; ++i) {
+        pdn_host_cache[i].route = -1;
+    }
+
+    if (args[2] == mp_const_none) {
+        if (route != NULL) {
+            route->cid = -1;
+        }
+        return mp_const_none;
+    }
+
+    // Range-check before narrowing to the int8_t fields of the entry
+    mp_int_t cid = mp_obj_get_int(args[2]);
+    mp_int_t fallback = n_args > 3 && args[3] != mp_const_none ? mp_obj_get_int(args[3]) : -1;
+    if (cid < 0 || cid >= PDN_CID_MAX || fallback < -1 || fallback >= PDN_CID_MAX) {
+        mp_raise_ValueError(MP_ERROR_TEXT("invalid CID"));
+    }
+    pdn_route_t new_route = {
+        .cid = cid,
+        .fallback = fallback,
+    };
+    memcpy(new_route.dest, dest, dest_len + 1);
+
+    // An address with an optional "/prefix", otherwise a hostname pattern
+    char addr[PDN_ROUTE_DEST_LEN];
+    const char *slash = strchr(dest, '/');
+    size_t addr_len = slash ? (size_t)(slash - dest) : dest_len;
+    memcpy(addr, dest, addr_len);
+    addr[addr_len] = '\0';
+    if (net_addr_pton(AF_INET, addr, new_route.addr) == 0) {
+        new_route.family = AF_INET;
+    } else if (net_addr_pton(AF_INET6, addr, new_route.addr) == 0) {
+        new_route.family = AF_INET6;
+    } else if (slash != NULL) {
+        mp_raise_ValueError(MP_ERROR_TEXT("invalid destination"));
+    }
+    if (new_route.family != 0) {
+        int max_len = pdn_addr_len(new_route.family) * 8;
+        int prefix_len = slash ? atoi(slash + 1) : max_len;
+        if (prefix_len < 0 || prefix_len > max_len) {
+            mp_raise_ValueError(MP_ERROR_TEXT("invalid prefix length"));
+        }
+        new_route.prefix_len = prefix_len;
+    }
+
+    if (route == NULL) {
+        route = free_route;
+        if (route == NULL) {
+            mp_raise_OSError(MP_ENOMEM);
+        }
+    }
+    *route = new_route;
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(network_cell_pdn_route_obj, 3, 4, network_cell_pdn_route);
+
+// CELL.pdn_routes(): list of (dest, cid, fallback, cid in use)
+STATIC mp_obj_t network_cell_pdn_routes(mp_obj_t self_in) {
+    mp_obj_t list = mp_obj_new_list(0, NULL);
+    for (size_t i = 0; i < PDN_ROUTES_MAX; ++i) {
+        const pdn_route_t *route = &pdn_routes[i];
+        if (route->cid < 0) {
+            continue;
+        }
+        mp_obj_t items[4] = {
+            mp_obj_new_str(route->dest, strlen(route->dest)),
+            MP_OBJ_NEW_SMALL_INT(route->cid),
+            route->fallback < 0 ? mp_const_none : MP_OBJ_NEW_SMALL_INT(route->fallback),
+            MP_OBJ_NEW_SMALL_INT(pdn_route_select(route)),
+        };
+        mp_obj_list_append(list, mp_obj_new_tuple(4, items));
+    }
+    return list;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(network_cell_pdn_routes_obj, network_cell_pdn_routes);
+
+// CELL.pdn_stats(): {cid: (tx_bytes, rx_bytes, up)} for every context that
+// carried traffic or is used by a route
+STATIC mp_obj_t network_cell_pdn_stats(mp_obj_t self_in) {
+    uint32_t used = BIT(0);
+    for (size_t i = 0; i < PDN_ROUTES_MAX; ++i) {
+        if (pdn_routes[i].cid >= 0) {
+            used |= BIT(pdn_routes[i].cid);
+            if (pdn_routes[i].fallback >= 0) {
+                used |= BIT(pdn_routes[i].fallback);
+            }
+        }
+    }
+    mp_obj_t dict = mp_obj_new_dict(0);
+    for (int cid = 0; cid < PDN_CID_MAX; ++cid) {
+        const pdn_counters_t *c = &pdn_counters[cid];
+        if (!(used & BIT(cid)) && c->tx_bytes == 0 && c->rx_bytes == 0) {
+            continue;
+        }
+        mp_obj_t items[3] = {
+            mp_obj_new_int_from_uint(c->tx_bytes),
+            mp_obj_new_int_from_uint(c->rx_bytes),
+            mp_obj_new_bool(pdn_is_up(cid)),
+        };
+        mp_obj_dict_store(dict, MP_OBJ_NEW_SMALL_INT(cid), mp_obj_new_tuple(3, items));
+    }
+    return dict;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(network_cell_pdn_stats_obj, network_cell_pdn_stats);
 #endif
 
 STATIC const mp_rom_map_elem_t cell_if_locals_dict_table[] = {
@@ -1041,6 +1457,7 @@ STATIC const mp_rom_map_elem_t cell_if_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_status), MP_ROM_PTR(&network_cell_status_obj) },
     { MP_ROM_QSTR(MP_QSTR_at), MP_ROM_PTR(&network_cell_at_obj) },
     { MP_ROM_QSTR(MP_QSTR_irq), MP_ROM_PTR(&network_cell_irq_obj) },
+    { MP_ROM_QSTR(MP_QSTR_stats), MP_ROM_PTR(&network_cell_stats_obj) },
 // Certificate management
     { MP_ROM_QSTR(MP_QSTR_cert), MP_ROM_PTR(&network_cell_cert_obj) },
     #ifdef CONFIG_MICROPY_NRF91_LOCATION
@@ -1055,6 +1472,9 @@ STATIC const mp_rom_map_elem_t cell_if_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_pdn_activate), MP_ROM_PTR(&network_cell_pdn_activate_obj) },
     { MP_ROM_QSTR(MP_QSTR_pdn_destroy), MP_ROM_PTR(&network_cell_pdn_destroy_obj) },
     { MP_ROM_QSTR(MP_QSTR_pdn_default_apn), MP_ROM_PTR(&network_cell_pdn_default_apn_obj) },
+    { MP_ROM_QSTR(MP_QSTR_pdn_route), MP_ROM_PTR(&network_cell_pdn_route_obj) },
+    { MP_ROM_QSTR(MP_QSTR_pdn_routes), MP_ROM_PTR(&network_cell_pdn_routes_obj) },
+    { MP_ROM_QSTR(MP_QSTR_pdn_stats), MP_ROM_PTR(&network_cell_pdn_stats_obj) },
     #endif
 };
 STATIC MP_DEFINE_CONST_DICT(cell_if_locals_dict, cell_if_locals_dict_table);
@@ -0,0 +1,142 @@
+/*
+ * This file is part of the MicroPython project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "py/mperrno.h"
+#include "py/objarray.h"
+#include "py/runtime.h"
+#include "extmod/vfs.h"
+
+#if MICROPY_VFS_ROM_IOCTL
+
+#include <zephyr/cache.h>
+#include <zephyr/drivers/flash.h>
+#include <zephyr/storage/flash_map.h>
+
+// The ROMFS partition is the mp_romfs partition when using the partition
+// manager, otherwise the partition chosen as micropython,romfs.
+#if defined(CONFIG_PARTITION_MANAGER_ENABLED)
+#define ROMFS_PARTITION_ID FIXED_PARTITION_ID(mp_romfs)
+#elif DT_HAS_CHOSEN(micropython_romfs)
+#define ROMFS_PARTITION_ID DT_FIXED_PARTITION_ID(DT_CHOSEN(micropython_romfs))
+#else
+#error "CONFIG_MICROPY_ROMFS needs a micropython,romfs partition"
+#endif
+
+// ROMFS is imported in place, so the partition is only usable if its flash is
+// memory-mapped: internal flash is at CONFIG_FLASH_BASE_ADDRESS, and an
+// external NOR flash must be mapped for XIP at CONFIG_MICROPY_ROMFS_XIP_BASE.
+STATIC const struct flash_area *romfs_area;
+STATIC mp_obj_array_t romfs_obj = {{&mp_type_memoryview}, 'B', 0, 0, NULL};
+
+STATIC bool romfs_open(void) {
+    if (romfs_area != NULL) {
+        return romfs_obj.items != NULL;
+    }
+    if (flash_area_open(ROMFS_PARTITION_ID, &romfs_area) != 0) {
+        romfs_area = NULL;
+        return false;
+    }
+    uintptr_t base = 0;
+    if (CONFIG_MICROPY_ROMFS_XIP_BASE != 0) {
+        base = CONFIG_MICROPY_ROMFS_XIP_BASE;
+    #if DT_HAS_CHOSEN(zephyr_flash_controller)
+    } else if (flash_area_get_device(romfs_area) == DEVICE_DT_GET(DT_CHOSEN(zephyr_flash_controller))) {
+        base = CONFIG_FLASH_BASE_ADDRESS;
+    #endif
+    } else {
+        // not memory-mapped
+        return false;
+    }
+    romfs_obj.len = romfs_area->fa_size;
+    romfs_obj.items = (void *)(base + romfs_area->fa_off);
+    return true;
+}
+
+mp_obj_t mp_vfs_rom_ioctl(size_t n_args, const mp_obj_t *args) {
+    mp_int_t cmd = mp_obj_get_int(args[0]);
+    if (cmd == MP_VFS_ROM_IOCTL_GET_NUMBER_OF_SEGMENTS) {
+        return MP_OBJ_NEW_SMALL_INT(romfs_open() ? 1 : 0);
+    }
+
+    if (n_args < 2 || mp_obj_get_int(args[1]) != 0) {
+        return MP_OBJ_NEW_SMALL_INT(-MP_EINVAL);
+    }
+    if (!romfs_open()) {
+        return MP_OBJ_NEW_SMALL_INT(-MP_ENODEV);
+    }
+
+    switch (cmd) {
+        case MP_VFS_ROM_IOCTL_GET_SEGMENT:
+            return MP_OBJ_FROM_PTR(&romfs_obj);
+
+        case MP_VFS_ROM_IOCTL_WRITE_PREPARE: {
+            // Erase the pages that the image will occupy
+            if (n_args < 3) {
+                return MP_OBJ_NEW_SMALL_INT(-MP_EINVAL);
+            }
+            size_t len = mp_obj_get_int(args[2]);
+            if (len > romfs_obj.len) {
+                return MP_OBJ_NEW_SMALL_INT(-MP_EINVAL);
+            }
+            const struct device *dev = flash_area_get_device(romfs_area);
+            for (size_t offset = 0; offset < len;) {
+                struct flash_pages_info info;
+                int ret = flash_get_page_info_by_offs(dev, romfs_area->fa_off + offset, &info);
+                if (ret == 0) {
+                    ret = flash_area_erase(romfs_area, offset, info.size);
+                }
+                if (ret != 0) {
+                    return MP_OBJ_NEW_SMALL_INT(-MP_EIO);
+                }
+                offset += info.size;
+            }
+            // minimum write size
+            return MP_OBJ_NEW_SMALL_INT(MAX(flash_area_align(romfs_area), 4));
+        }
+
+        case MP_VFS_ROM_IOCTL_WRITE: {
+            if (n_args < 4) {
+                return MP_OBJ_NEW_SMALL_INT(-MP_EINVAL);
+            }
+            mp_int_t offset = mp_obj_get_int(args[2]);
+            mp_buffer_info_t bufinfo;
+            mp_get_buffer_raise(args[3], &bufinfo, MP_BUFFER_READ);
+            if (offset < 0 || offset + bufinfo.len > romfs_obj.len) {
+                return MP_OBJ_NEW_SMALL_INT(-MP_EINVAL);
+            }
+            int ret = flash_area_write(romfs_area, offset, bufinfo.buf, bufinfo.len);
+            return MP_OBJ_NEW_SMALL_INT(ret == 0 ? 0 : -MP_EIO);
+        }
+
+        case MP_VFS_ROM_IOCTL_WRITE_COMPLETE:
+            // Don't let the CPU see stale cached contents of the mapped flash
+            sys_cache_data_invd_range(romfs_obj.items, romfs_obj.len);
+            return MP_OBJ_NEW_SMALL_INT(0);
+
+        default:
+            return MP_OBJ_NEW_SMALL_INT(-MP_EINVAL);
+    }
+}
+
+#endif // MICROPY_VFS_ROM_IOCTL
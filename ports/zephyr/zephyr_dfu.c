@@ -0,0 +1,344 @@
+/*
+ * This file is part of the MicroPython project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "modzephyr.h"
+#include "py/runtime.h"
+#include "py/stream.h"
+
+#ifdef CONFIG_IMG_MANAGER
+#include <string.h>
+#include <zephyr/dfu/flash_img.h>
+#include <zephyr/dfu/mcuboot.h>
+#include <zephyr/storage/flash_map.h>
+
+#ifdef CONFIG_PARTITION_MANAGER_ENABLED
+#define DFU_SOURCE_PARTITION_ID FIXED_PARTITION_ID(mcuboot_primary)
+#else
+#define DFU_SOURCE_PARTITION_ID FIXED_PARTITION_ID(slot0_partition)
+#endif
+
+// A delta patch is a sequence of bsdiff-style control records applied to the
+// image in the primary (running) slot:
+//
+//   header:  "MPD1" <size of the new image: u32 LE>
+//   record:  <diff len: uleb128> <extra len: uleb128> <seek: zigzag uleb128>
+//            <diff bytes> <extra bytes>
+//
+// Each diff byte is added to the byte at the current position in the running
+// image, extra bytes are copied as-is, then the position in the running image
+// moves by seek.  ports/zephyr/make-dfu-delta.py generates them.
+#define DFU_DELTA_MAGIC "MPD1"
+#define DFU_DELTA_HEADER_LEN (8)
+
+enum {
+    DFU_STATE_IMAGE,
+    DFU_STATE_HEADER,
+    DFU_STATE_CTRL,
+    DFU_STATE_DIFF,
+    DFU_STATE_EXTRA,
+    DFU_STATE_CLOSED,
+};
+
+typedef struct _zephyr_dfu_obj_t {
+    mp_obj_base_t base;
+    uint8_t state;
+    uint8_t ctrl_idx;
+    uint8_t shift;
+    uint8_t header_len;
+    uint8_t header[DFU_DELTA_HEADER_LEN];
+    uint32_t ctrl[3];
+    uint32_t remaining;
+    uint32_t new_size;
+    off_t src_pos;
+    const struct flash_area *src;
+    struct flash_img_context ctx;
+} zephyr_dfu_obj_t;
+
+STATIC void zephyr_dfu_check_open(zephyr_dfu_obj_t *self) {
+    if (self->state == DFU_STATE_CLOSED) {
+        mp_raise_OSError(MP_EBADF);
+    }
+}
+
+STATIC void zephyr_dfu_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind) {
+    zephyr_dfu_obj_t *self = self_in;
+    mp_printf(print, "DFU(written=%u)", flash_img_bytes_written(&self->ctx));
+}
+
+STATIC mp_obj_t zephyr_dfu_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *all_args) {
+    enum { ARG_delta };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_delta, MP_ARG_KW_ONLY | MP_ARG_BOOL, {.u_bool = false} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all_kw_array(n_args, n_kw, all_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    zephyr_dfu_obj_t *self = mp_obj_malloc_with_finaliser(zephyr_dfu_obj_t, type);
+    self->state = DFU_STATE_CLOSED;
+    self->ctrl_idx = 0;
+    self->shift = 0;
+    self->header_len = 0;
+    memset(self->ctrl, 0, sizeof(self->ctrl));
+    self->src_pos = 0;
+    self->src = NULL;
+
+    int ret = flash_img_init(&self->ctx);
+    if (ret) {
+        mp_raise_OSError(-ret);
+    }
+
+    #ifndef CONFIG_IMG_ERASE_PROGRESSIVELY
+    // Without progressive erase stream_flash expects the slot to be blank
+    ret = flash_area_erase(self->ctx.flash_area, 0, self->ctx.flash_area->fa_size);
+    if (ret) {
+        mp_raise_OSError(-ret);
+    }
+    #endif
+
+    if (args[ARG_delta].u_bool) {
+        ret = flash_area_open(DFU_SOURCE_PARTITION_ID, &self->src);
+        if (ret) {
+            mp_raise_OSError(-ret);
+        }
+        self->state = DFU_STATE_HEADER;
+    } else {
+        self->state = DFU_STATE_IMAGE;
+    }
+
+    return MP_OBJ_FROM_PTR(self);
+}
+
+// Move on from diff and extra runs that are complete (possibly empty ones)
+STATIC void zephyr_dfu_delta_advance(zephyr_dfu_obj_t *self) {
+    if (self->state == DFU_STATE_DIFF && self->remaining == 0) {
+        self->remaining = self->ctrl[1];
+        self->state = DFU_STATE_EXTRA;
+    }
+    if (self->state == DFU_STATE_EXTRA && self->remaining == 0) {
+        uint32_t seek = self->ctrl[2];
+        self->src_pos += (int32_t)(seek >> 1) ^ -(int32_t)(seek & 1);
+        memset(self->ctrl, 0, sizeof(self->ctrl));
+        self->state = DFU_STATE_CTRL;
+    }
+}
+
+STATIC int zephyr_dfu_delta_write(zephyr_dfu_obj_t *self, const uint8_t *buf, size_t len) {
+    int ret = 0;
+    while (len > 0 && ret == 0) {
+        switch (self->state) {
+            case DFU_STATE_HEADER:
+                self->header[self->header_len++] = *buf++;
+                len--;
+                if (self->header_len == DFU_DELTA_HEADER_LEN) {
+                    if (memcmp(self->header, DFU_DELTA_MAGIC, 4) != 0) {
+                        return -EINVAL;
+                    }
+                    self->new_size = self->header[4] | self->header[5] << 8 | self->header[6] << 16 | self->header[7] << 24;
+                    self->state = DFU_STATE_CTRL;
+                }
+                break;
+
+            case DFU_STATE_CTRL: {
+                uint8_t b = *buf++;
+                len--;
+                if (self->shift == 28 && (b & 0xf0)) {
+                    // the fifth byte may only hold the top 4 bits of a 32-bit value
+                    return -EINVAL;
+                }
+                self->ctrl[self->ctrl_idx] |= (uint32_t)(b & 0x7f) << self->shift;
+                self->shift += 7;
+                if (b & 0x80) {
+                    break;
+                }
+                self->shift = 0;
+                if (++self->ctrl_idx == 3) {
+                    self->ctrl_idx = 0;
+                    self->remaining = self->ctrl[0];
+                    self->state = DFU_STATE_DIFF;
+                    zephyr_dfu_delta_advance(self);
+                }
+                break;
+            }
+
+            case DFU_STATE_DIFF: {
+                uint8_t old[64];
+                size_t n = MIN(MIN(len, self->remaining), sizeof(old));
+                ret = flash_area_read(self->src, self->src_pos, old, n);
+                if (ret) {
+                    break;
+                }
+                for (size_t i = 0; i < n; ++i) {
+                    old[i] += buf[i];
+                }
+                ret = flash_img_buffered_write(&self->ctx, old, n, false);
+                buf += n;
+                len -= n;
+                self->src_pos += n;
+                self->remaining -= n;
+                zephyr_dfu_delta_advance(self);
+                break;
+            }
+
+            case DFU_STATE_EXTRA: {
+                size_t n = MIN(len, self->remaining);
+                ret = flash_img_buffered_write(&self->ctx, buf, n, false);
+                buf += n;
+                len -= n;
+                self->remaining -= n;
+                zephyr_dfu_delta_advance(self);
+                break;
+            }
+        }
+    }
+    return ret;
+}
+
+STATIC mp_uint_t zephyr_dfu_write(mp_obj_t self_in, const void *buf, mp_uint_t size, int *errcode) {
+    zephyr_dfu_obj_t *self = self_in;
+    int ret;
+    if (self->state == DFU_STATE_CLOSED) {
+        *errcode = MP_EBADF;
+        return MP_STREAM_ERROR;
+    } else if (self->state == DFU_STATE_IMAGE) {
+        ret = flash_img_buffered_write(&self->ctx, buf, size, false);
+    } else {
+        ret = zephyr_dfu_delta_write(self, buf, size);
+    }
+    if (ret) {
+        *errcode = -ret;
+        return MP_STREAM_ERROR;
+    }
+    return size;
+}
+
+STATIC mp_uint_t zephyr_dfu_ioctl(mp_obj_t self_in, mp_uint_t request, uintptr_t arg, int *errcode) {
+    zephyr_dfu_obj_t *self = self_in;
+    (void)arg;
+    switch (request) {
+        case MP_STREAM_CLOSE:
+            if (self->src != NULL) {
+                flash_area_close(self->src);
+                self->src = NULL;
+            }
+            self->state = DFU_STATE_CLOSED;
+            return 0;
+
+        default:
+            *errcode = MP_EINVAL;
+            return MP_STREAM_ERROR;
+    }
+}
+
+// DFU.write_from(stream) -- copy a stream (eg a socket, or a
+// deflate.DeflateIO wrapping one) into the image until EOF.
+STATIC mp_obj_t zephyr_dfu_write_from(mp_obj_t self_in, mp_obj_t stream_in) {
+    zephyr_dfu_obj_t *self = self_in;
+    zephyr_dfu_check_open(self);
+    const mp_stream_p_t *stream_p = mp_get_stream_raise(stream_in, MP_STREAM_OP_READ);
+    uint8_t buf[256];
+    mp_uint_t total = 0;
+    for (;;) {
+        int errcode;
+        mp_uint_t n = stream_p->read(stream_in, buf, sizeof(buf), &errcode);
+        if (n == MP_STREAM_ERROR) {
+            mp_raise_OSError(errcode);
+        }
+        if (n == 0) {
+            break;
+        }
+        if (zephyr_dfu_write(self, buf, n, &errcode) == MP_STREAM_ERROR) {
+            mp_raise_OSError(errcode);
+        }
+        total += n;
+    }
+    return mp_obj_new_int_from_uint(total);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(zephyr_dfu_write_from_obj, zephyr_dfu_write_from);
+
+STATIC mp_obj_t zephyr_dfu_finish(size_t n_args, const mp_obj_t *args) {
+    zephyr_dfu_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    zephyr_dfu_check_open(self);
+    bool permanent = n_args > 1 && mp_obj_is_true(args[1]);
+
+    int ret = flash_img_buffered_write(&self->ctx, NULL, 0, true);
+    if (ret) {
+        mp_raise_OSError(-ret);
+    }
+    size_t written = flash_img_bytes_written(&self->ctx);
+    if (self->state != DFU_STATE_IMAGE
+        && (self->state != DFU_STATE_CTRL || self->ctrl_idx != 0 || self->shift != 0 || written != self->new_size)) {
+        mp_raise_ValueError(MP_ERROR_TEXT("incomplete delta"));
+    }
+    mp_stream_close(MP_OBJ_FROM_PTR(self));
+
+    ret = boot_request_upgrade(permanent ? BOOT_UPGRADE_PERMANENT : BOOT_UPGRADE_TEST);
+    if (ret) {
+        mp_raise_OSError(-ret);
+    }
+    return mp_obj_new_int_from_uint(written);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(zephyr_dfu_finish_obj, 1, 2, zephyr_dfu_finish);
+
+STATIC mp_obj_t zephyr_dfu_confirm(void) {
+    int ret = boot_write_img_confirmed();
+    if (ret) {
+        mp_raise_OSError(-ret);
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(zephyr_dfu_confirm_fun_obj, zephyr_dfu_confirm);
+STATIC MP_DEFINE_CONST_STATICMETHOD_OBJ(zephyr_dfu_confirm_obj, MP_ROM_PTR(&zephyr_dfu_confirm_fun_obj));
+
+STATIC mp_obj_t zephyr_dfu_is_confirmed(void) {
+    return mp_obj_new_bool(boot_is_img_confirmed());
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(zephyr_dfu_is_confirmed_fun_obj, zephyr_dfu_is_confirmed);
+STATIC MP_DEFINE_CONST_STATICMETHOD_OBJ(zephyr_dfu_is_confirmed_obj, MP_ROM_PTR(&zephyr_dfu_is_confirmed_fun_obj));
+
+STATIC const mp_rom_map_elem_t zephyr_dfu_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___del__), MP_ROM_PTR(&mp_stream_close_obj) },
+    { MP_ROM_QSTR(MP_QSTR_close), MP_ROM_PTR(&mp_stream_close_obj) },
+    { MP_ROM_QSTR(MP_QSTR_write), MP_ROM_PTR(&mp_stream_write_obj) },
+    { MP_ROM_QSTR(MP_QSTR_write_from), MP_ROM_PTR(&zephyr_dfu_write_from_obj) },
+    { MP_ROM_QSTR(MP_QSTR_finish), MP_ROM_PTR(&zephyr_dfu_finish_obj) },
+    { MP_ROM_QSTR(MP_QSTR_confirm), MP_ROM_PTR(&zephyr_dfu_confirm_obj) },
+    { MP_ROM_QSTR(MP_QSTR_is_confirmed), MP_ROM_PTR(&zephyr_dfu_is_confirmed_obj) },
+};
+STATIC MP_DEFINE_CONST_DICT(zephyr_dfu_locals_dict, zephyr_dfu_locals_dict_table);
+
+STATIC const mp_stream_p_t zephyr_dfu_stream_p = {
+    .write = zephyr_dfu_write,
+    .ioctl = zephyr_dfu_ioctl,
+};
+
+MP_DEFINE_CONST_OBJ_TYPE(
+    zephyr_dfu_type,
+    MP_QSTR_DFU,
+    MP_TYPE_FLAG_NONE,
+    make_new, zephyr_dfu_make_new,
+    print, zephyr_dfu_print,
+    protocol, &zephyr_dfu_stream_p,
+    locals_dict, &zephyr_dfu_locals_dict
+    );
+#endif // CONFIG_IMG_MANAGER
@@ -90,6 +90,12 @@ static void asm_thumb_write_word32(asm_thumb_t *as, int w32) {
 #define OP_POP_RLIST(rlolist)       (0xbc00 | (rlolist))
 #define OP_POP_RLIST_PC(rlolist)    (0xbc00 | 0x0100 | (rlolist))
 
+// rlist is a bit map indicating desired registers, excluding sp, lr and pc
+#define OP_PUSH_W_RLIST_LR_HI       (0xe92d)
+#define OP_PUSH_W_RLIST_LR_LO(rlist) (0x4000 | (rlist))
+#define OP_POP_W_RLIST_PC_HI        (0xe8bd)
+#define OP_POP_W_RLIST_PC_LO(rlist) (0x8000 | (rlist))
+
 // The number of words must fit in 7 unsigned bits
 #define OP_ADD_SP(num_words) (0xb000 | (num_words))
 #define OP_SUB_SP(num_words) (0xb080 | (num_words))
@@ -105,7 +111,7 @@ static void asm_thumb_write_word32(asm_thumb_t *as, int w32) {
 //  ^                ^
 //  | low address    | high address in RAM
 
-void asm_thumb_entry(asm_thumb_t *as, int num_locals) {
+void asm_thumb_entry(asm_thumb_t *as, int num_locals, bool save_high_regs) {
     assert(num_locals >= 0);
 
     // If this Thumb machine code is run from ARM state then add a prelude
@@ -157,7 +163,14 @@ void asm_thumb_entry(asm_thumb_t *as, int num_locals) {
             stack_adjust = ((num_locals - 3) + 1) & (~1);
             break;
     }
-    asm_thumb_op16(as, OP_PUSH_RLIST_LR(reglist));
+    if (save_high_regs && asm_thumb_allow_armv7m(as)) {
+        // also save r10 and r11, which the native emitter uses for locals; this
+        // keeps the stack aligned and the lo-registers in the same place
+        reglist |= 1 << ASM_THUMB_REG_R10 | 1 << ASM_THUMB_REG_R11;
+        asm_thumb_op32(as, OP_PUSH_W_RLIST_LR_HI, OP_PUSH_W_RLIST_LR_LO(reglist));
+    } else {
+        asm_thumb_op16(as, OP_PUSH_RLIST_LR(reglist));
+    }
     if (stack_adjust > 0) {
         if (asm_thumb_allow_armv7m(as)) {
             if (UNSIGNED_FIT7(stack_adjust)) {
@@ -197,7 +210,11 @@ void asm_thumb_exit(asm_thumb_t *as) {
             asm_thumb_op16(as, OP_ADD_SP(adj));
         }
     }
-    asm_thumb_op16(as, OP_POP_RLIST_PC(as->push_reglist));
+    if (as->push_reglist > 0xff) {
+        asm_thumb_op32(as, OP_POP_W_RLIST_PC_HI, OP_POP_W_RLIST_PC_LO(as->push_reglist));
+    } else {
+        asm_thumb_op16(as, OP_POP_RLIST_PC(as->push_reglist));
+    }
 }
 
 static mp_uint_t get_label_dest(asm_thumb_t *as, uint label) {
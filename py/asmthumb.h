@@ -90,7 +90,7 @@ static inline void asm_thumb_end_pass(asm_thumb_t *as) {
     (void)as;
 }
 
-void asm_thumb_entry(asm_thumb_t *as, int num_locals);
+void asm_thumb_entry(asm_thumb_t *as, int num_locals, bool save_high_regs);
 void asm_thumb_exit(asm_thumb_t *as);
 
 // argument order follows ARM, in general dest is first
@@ -371,13 +371,18 @@ void asm_thumb_b_rel12(asm_thumb_t *as, int rel);
 #define REG_LOCAL_1 ASM_THUMB_REG_R4
 #define REG_LOCAL_2 ASM_THUMB_REG_R5
 #define REG_LOCAL_3 ASM_THUMB_REG_R6
-#define REG_LOCAL_NUM (3)
+// Only used on ARMv7-M.  Most instructions can't access these high registers, so
+// locals kept in them are moved through a lo-register when used.
+#define REG_LOCAL_4 ASM_THUMB_REG_R10
+#define REG_LOCAL_5 ASM_THUMB_REG_R11
+#define REG_LOCAL_NUM (5)
+#define REG_LOCAL_IS_HIGH(reg) ((reg) >= ASM_THUMB_REG_R8)
 
 #define REG_FUN_TABLE ASM_THUMB_REG_FUN_TABLE
 
 #define ASM_T               asm_thumb_t
 #define ASM_END_PASS        asm_thumb_end_pass
-#define ASM_ENTRY           asm_thumb_entry
+#define ASM_ENTRY(as, num_locals) asm_thumb_entry((as), (num_locals), true)
 #define ASM_EXIT            asm_thumb_exit
 
 #define ASM_JUMP            asm_thumb_b_label
@@ -244,8 +244,10 @@ typedef struct _mp_code_state_t {
     #if MICROPY_STACKLESS
     struct _mp_code_state_t *prev;
     #endif
-    #if MICROPY_PY_SYS_SETTRACE
+    #if MICROPY_TRACK_CODE_STATE
     struct _mp_code_state_t *prev_state;
+    #endif
+    #if MICROPY_PY_SYS_SETTRACE
     struct _mp_obj_frame_t *frame;
     #endif
     // Variable-length
@@ -278,6 +280,9 @@ mp_vm_return_kind_t mp_execute_bytecode(mp_code_state_t *code_state,
     volatile
 #endif
     mp_obj_t inject_exc);
+#if MICROPY_OPT_QUICKENING
+byte mp_bc_quicken_generic(byte op);
+#endif
 mp_code_state_t *mp_obj_fun_bc_prepare_codestate(mp_obj_t func, size_t n_args, size_t n_kw, const mp_obj_t *args);
 void mp_setup_code_state(mp_code_state_t *code_state, size_t n_args, size_t n_kw, const mp_obj_t *args);
 void mp_setup_code_state_native(mp_code_state_native_t *code_state, size_t n_args, size_t n_kw, const mp_obj_t *args);
@@ -335,4 +340,6 @@ static inline size_t mp_bytecode_get_source_line(const byte *line_info, const by
     return source_line;
 }
 
+size_t mp_bytecode_get_first_line(const byte *ip);
+
 #endif // MICROPY_INCLUDED_PY_BC_H
@@ -53,10 +53,10 @@
 
 // Load, Store, Delete, Import, Make, Build, Unpack, Call, Jump, Exception, For, sTack, Return, Yield, Op
 #define MP_BC_BASE_RESERVED                 (0x00) // ----------------
-#define MP_BC_BASE_QSTR_O                   (0x10) // LLLLLLSSSDDII---
+#define MP_BC_BASE_QSTR_O                   (0x10) // LLLLLLSSSDDII--L
 #define MP_BC_BASE_VINT_E                   (0x20) // MMLLLLSSDDBBBBBB
-#define MP_BC_BASE_VINT_O                   (0x30) // UUMMCCCC--------
-#define MP_BC_BASE_JUMP_E                   (0x40) // J-JJJJJEEEEF----
+#define MP_BC_BASE_VINT_O                   (0x30) // UUMMCCCCOOL-----
+#define MP_BC_BASE_JUMP_E                   (0x40) // JJJJJJJEEEEF----
 #define MP_BC_BASE_BYTE_O                   (0x50) // LLLLSSDTTTTTEEFF
 #define MP_BC_BASE_BYTE_E                   (0x60) // --BREEEYYI------
 #define MP_BC_LOAD_CONST_SMALL_INT_MULTI    (0x70) // LLLLLLLLLLLLLLLL
@@ -159,4 +159,47 @@
 #define MP_BC_IMPORT_FROM                   (MP_BC_BASE_QSTR_O + 0x0c) // qstr
 #define MP_BC_IMPORT_STAR                   (MP_BC_BASE_BYTE_E + 0x09)
 
+// Superinstructions, each equivalent to a short sequence of the opcodes above.
+// They are emitted by the compiler when MICROPY_COMP_PEEPHOLE is enabled, but
+// the VM always supports them so it can run any .mpy file of this version.
+#define MP_BC_LOAD_FAST_0_ATTR              (MP_BC_BASE_QSTR_O + 0x0f) // qstr; LOAD_FAST 0, LOAD_ATTR
+#define MP_BC_LOAD_FAST_2                   (MP_BC_BASE_VINT_O + 0x0a) // uint (a << 4 | b); LOAD_FAST a, LOAD_FAST b
+#define MP_BC_INPLACE_ADD_FAST              (MP_BC_BASE_VINT_O + 0x08) // uint (k << 4 | n); n += k for small int k >= 0
+#define MP_BC_INPLACE_SUBTRACT_FAST         (MP_BC_BASE_VINT_O + 0x09) // uint (k << 4 | n); n -= k for small int k >= 0
+#define MP_BC_BINARY_OP_POP_JUMP_IF         (MP_BC_BASE_JUMP_E + 0x01) // signed relative bytecode offset; then a byte
+
+// The byte following MP_BC_BINARY_OP_POP_JUMP_IF is the binary op, with this
+// bit set if the jump is taken when the result is true (otherwise when false).
+#define MP_BC_BINARY_OP_POP_JUMP_IF_TRUE_FLAG (0x80)
+
+// Specialised opcodes, only ever written over the generic opcode they are
+// derived from by the VM when MICROPY_OPT_QUICKENING is enabled.  They are
+// never emitted by the compiler, are mapped back by mp_bc_quicken_generic() when
+// a function is saved, so never appear in .mpy files, and each has the same
+// format as the opcode it replaces.
+#define MP_BC_LOAD_ATTR_INSTANCE            (MP_BC_BASE_QSTR_O + 0x0d) // qstr
+#define MP_BC_LOAD_ATTR_UNSPECIALISED       (MP_BC_BASE_QSTR_O + 0x0e) // qstr
+#define MP_BC_LOAD_SUBSCR_SEQ               (MP_BC_BASE_BYTE_E + 0x0a)
+#define MP_BC_STORE_SUBSCR_LIST             (MP_BC_BASE_BYTE_E + 0x0b)
+#define MP_BC_BINARY_OP_SMALL_INT_ADD       (MP_BC_BASE_RESERVED + 0x02)
+#define MP_BC_BINARY_OP_SMALL_INT_SUBTRACT  (MP_BC_BASE_RESERVED + 0x03)
+#define MP_BC_BINARY_OP_SMALL_INT_INPLACE_ADD (MP_BC_BASE_RESERVED + 0x04)
+#define MP_BC_BINARY_OP_SMALL_INT_INPLACE_SUBTRACT (MP_BC_BASE_RESERVED + 0x05)
+#define MP_BC_BINARY_OP_SMALL_INT_LESS      (MP_BC_BASE_RESERVED + 0x06)
+#define MP_BC_BINARY_OP_SMALL_INT_MORE      (MP_BC_BASE_RESERVED + 0x07)
+#define MP_BC_BINARY_OP_SMALL_INT_EQUAL     (MP_BC_BASE_RESERVED + 0x08)
+#define MP_BC_BINARY_OP_SMALL_INT_LESS_EQUAL (MP_BC_BASE_RESERVED + 0x09)
+#define MP_BC_BINARY_OP_SMALL_INT_MORE_EQUAL (MP_BC_BASE_RESERVED + 0x0a)
+#define MP_BC_BINARY_OP_SMALL_INT_NOT_EQUAL (MP_BC_BASE_RESERVED + 0x0b)
+#define MP_BC_BINARY_OP_FLOAT_ADD           (MP_BC_BASE_RESERVED + 0x0c)
+#define MP_BC_BINARY_OP_FLOAT_SUBTRACT      (MP_BC_BASE_RESERVED + 0x0d)
+#define MP_BC_BINARY_OP_FLOAT_MULTIPLY      (MP_BC_BASE_RESERVED + 0x0e)
+#define MP_BC_BINARY_OP_FLOAT_TRUE_DIVIDE   (MP_BC_BASE_RESERVED + 0x0f)
+#define MP_BC_BINARY_OP_FLOAT_INPLACE_ADD   (MP_BC_BINARY_OP_MULTI + MP_BC_BINARY_OP_MULTI_NUM + 0x00)
+#define MP_BC_BINARY_OP_FLOAT_INPLACE_SUBTRACT (MP_BC_BINARY_OP_MULTI + MP_BC_BINARY_OP_MULTI_NUM + 0x01)
+#define MP_BC_BINARY_OP_FLOAT_INPLACE_MULTIPLY (MP_BC_BINARY_OP_MULTI + MP_BC_BINARY_OP_MULTI_NUM + 0x02)
+#define MP_BC_BINARY_OP_FLOAT_INPLACE_TRUE_DIVIDE (MP_BC_BINARY_OP_MULTI + MP_BC_BINARY_OP_MULTI_NUM + 0x03)
+#define MP_BC_BINARY_OP_FLOAT_LESS          (MP_BC_BINARY_OP_MULTI + MP_BC_BINARY_OP_MULTI_NUM + 0x04)
+#define MP_BC_BINARY_OP_FLOAT_MORE          (MP_BC_BINARY_OP_MULTI + MP_BC_BINARY_OP_MULTI_NUM + 0x05)
+
 #endif // MICROPY_INCLUDED_PY_BC0_H
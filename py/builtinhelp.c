@@ -55,7 +55,6 @@ static void mp_help_print_info_about_object(mp_obj_t name_o, mp_obj_t value) {
     mp_print_str(MP_PYTHON_PRINTER, "\n");
 }
 
-#if MICROPY_PY_BUILTINS_HELP_MODULES
 static void mp_help_add_from_map(mp_obj_t list, const mp_map_t *map) {
     for (size_t i = 0; i < map->alloc; i++) {
         if (mp_map_slot_is_filled(map, i)) {
@@ -64,6 +63,7 @@ static void mp_help_add_from_map(mp_obj_t list, const mp_map_t *map) {
     }
 }
 
+#if MICROPY_PY_BUILTINS_HELP_MODULES
 #if MICROPY_MODULE_FROZEN
 static void mp_help_add_from_names(mp_obj_t list, const char *name) {
     while (*name) {
@@ -149,11 +149,20 @@ static void mp_help_print_obj(const mp_obj_t obj) {
         }
     }
     if (map != NULL) {
-        for (uint i = 0; i < map->alloc; i++) {
-            mp_obj_t key = map->table[i].key;
-            if (key != MP_OBJ_NULL) {
-                mp_help_print_info_about_object(key, map->table[i].value);
-            }
+        mp_obj_t list = mp_obj_new_list(0, NULL);
+        mp_help_add_from_map(list, map);
+
+        // ROM tables may be laid out in hash order (see tools/cc1), so sort the
+        // names to print them in alphabetical order; other keys can't be sorted
+        if (map->all_keys_are_qstrs) {
+            mp_obj_list_sort(1, &list, (mp_map_t *)&mp_const_empty_map);
+        }
+
+        size_t len;
+        mp_obj_t *items;
+        mp_obj_list_get(list, &len, &items);
+        for (size_t i = 0; i < len; i++) {
+            mp_help_print_info_about_object(items[i], mp_map_lookup(map, items[i], MP_MAP_LOOKUP)->value);
         }
     }
 }
@@ -0,0 +1,133 @@
+/*
+ * This file is part of the MicroPython project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "py/mphal.h"
+#include "py/objfun.h"
+#include "py/runtime.h"
+
+#if MICROPY_CALL_PROFILE
+
+// Call profiler.  While it's enabled every call of a bytecode function through
+// fun_bc_call is counted, and the time from entry to return less the time
+// spent in the bytecode functions it called is added to the function's total.
+// Functions are identified by their source file, name and the line of their
+// first statement, which mpy-cross can work out for itself when it compiles
+// the same source (see mpy-cross --profile).  Generators aren't counted, and
+// with MICROPY_STACKLESS neither are calls made directly by the VM.
+//
+// A snapshot is a compact binary record:
+//   "MPCP" version:u8
+//   n_funs:uleb { file:str name:str line:uleb calls:uleb us:uleb }
+// where str is a uleb length followed by that many bytes.  When the table of
+// functions fills, further functions are counted in a last entry with an empty
+// file and name.
+
+#define CALL_PROFILE_VERSION (1)
+
+void mp_call_profile_start(bool enable) {
+    MP_STATE_VM(call_profile_enabled) = enable;
+    if (enable) {
+        MP_STATE_VM(call_profile_callee_us) = 0;
+        MP_STATE_VM(call_profile_n_funs) = 0;
+    }
+}
+
+void mp_call_profile_enter(mp_call_profile_frame_t *frame) {
+    frame->enabled = MP_STATE_VM(call_profile_enabled);
+    if (frame->enabled) {
+        frame->outer_callee_us = MP_STATE_VM(call_profile_callee_us);
+        MP_STATE_VM(call_profile_callee_us) = 0;
+        frame->start_us = mp_hal_ticks_us();
+    }
+}
+
+static size_t call_profile_add_us(size_t a, size_t b) {
+    size_t sum = a + b;
+    return sum < a ? (size_t)-1 : sum;
+}
+
+void mp_call_profile_exit(const mp_obj_fun_bc_t *fun, const mp_call_profile_frame_t *frame) {
+    if (!frame->enabled) {
+        return;
+    }
+    size_t total_us = mp_hal_ticks_us() - frame->start_us;
+    size_t callee_us = MP_STATE_VM(call_profile_callee_us);
+    size_t self_us = total_us > callee_us ? total_us - callee_us : 0;
+    MP_STATE_VM(call_profile_callee_us) = call_profile_add_us(frame->outer_callee_us, total_us);
+    if (!MP_STATE_VM(call_profile_enabled)) {
+        // stopped during the call
+        return;
+    }
+
+    #if MICROPY_EMIT_BYTECODE_USES_QSTR_TABLE
+    qstr file = fun->context->constants.qstr_table[0];
+    #else
+    qstr file = fun->context->constants.source_file;
+    #endif
+    qstr name = mp_obj_fun_get_name(MP_OBJ_FROM_PTR(fun));
+    size_t line = mp_bytecode_get_first_line(fun->bytecode);
+
+    mp_call_profile_fun_t *funs = MP_STATE_VM(call_profile_funs);
+    size_t n_funs = MP_STATE_VM(call_profile_n_funs);
+    size_t i = 0;
+    while (i < n_funs && (funs[i].line != line || funs[i].name != name || funs[i].file != file)) {
+        i += 1;
+    }
+    if (i == n_funs) {
+        if (n_funs < MICROPY_CALL_PROFILE_FUNS) {
+            MP_STATE_VM(call_profile_n_funs) = n_funs + 1;
+            funs[i].n_calls = 0;
+            funs[i].us = 0;
+        } else {
+            // Out of room: the last entry becomes a catch-all, with no file
+            i = MICROPY_CALL_PROFILE_FUNS - 1;
+            file = MP_QSTRnull;
+            name = MP_QSTRnull;
+            line = 0;
+        }
+        funs[i].file = file;
+        funs[i].name = name;
+        funs[i].line = line;
+    }
+    funs[i].n_calls += 1;
+    funs[i].us = call_profile_add_us(funs[i].us, self_us);
+}
+
+void mp_call_profile_snapshot(vstr_t *vstr) {
+    vstr_add_str(vstr, "MPCP");
+    vstr_add_byte(vstr, CALL_PROFILE_VERSION);
+    const mp_call_profile_fun_t *funs = MP_STATE_VM(call_profile_funs);
+    size_t n_funs = MP_STATE_VM(call_profile_n_funs);
+    vstr_add_uleb(vstr, n_funs);
+    for (size_t i = 0; i < n_funs; ++i) {
+        vstr_add_uleb_str(vstr, qstr_str(funs[i].file), qstr_len(funs[i].file));
+        vstr_add_uleb_str(vstr, qstr_str(funs[i].name), qstr_len(funs[i].name));
+        vstr_add_uleb(vstr, funs[i].line);
+        vstr_add_uleb(vstr, funs[i].n_calls);
+        vstr_add_uleb(vstr, funs[i].us);
+    }
+}
+
+#endif // MICROPY_CALL_PROFILE
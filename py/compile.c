@@ -38,6 +38,7 @@
 #include "py/nativeglue.h"
 #include "py/persistentcode.h"
 #include "py/smallint.h"
+#include "py/builtin.h"
 
 #if MICROPY_ENABLE_COMPILER
 
@@ -67,6 +68,10 @@ typedef enum {
 
 #define NEED_METHOD_TABLE MICROPY_EMIT_NATIVE
 
+// Loading globals that are read in a loop before the loop is only done by
+// mpy-cross, when asked to with --hoist-globals (see compile_hoist_start).
+#define COMP_HOIST_GLOBALS (MICROPY_COMP_OPT_LEVEL_2 && MICROPY_DYNAMIC_COMPILER)
+
 #if NEED_METHOD_TABLE
 
 // we need a method table to do the lookup for the emitter functions
@@ -237,6 +242,28 @@ static void mp_emit_common_start_pass(mp_emit_common_t *emit, pass_kind_t pass)
     emit->ct_cur_child = 0;
 }
 
+#if MICROPY_DYNAMIC_COMPILER && MICROPY_EMIT_NATIVE
+// Drop the qstrs and constant objects that were added after the tables had
+// n_qstr and n_obj entries.
+static void mp_emit_common_truncate(mp_emit_common_t *emit, size_t n_qstr, size_t n_obj) {
+    #if MICROPY_EMIT_BYTECODE_USES_QSTR_TABLE
+    for (size_t i = 0; emit->qstr_map.used > n_qstr;) {
+        assert(i < emit->qstr_map.alloc);
+        if (mp_map_slot_is_filled(&emit->qstr_map, i)
+            && (size_t)MP_OBJ_SMALL_INT_VALUE(emit->qstr_map.table[i].value) >= n_qstr) {
+            // removing may move other entries, so look at this slot again
+            mp_map_lookup(&emit->qstr_map, emit->qstr_map.table[i].key, MP_MAP_LOOKUP_REMOVE_IF_FOUND);
+        } else {
+            ++i;
+        }
+    }
+    #else
+    (void)n_qstr;
+    #endif
+    emit->const_obj_list.len = n_obj;
+}
+#endif
+
 static void mp_emit_common_populate_module_context(mp_emit_common_t *emit, qstr source_file, mp_module_context_t *context) {
     #if MICROPY_EMIT_BYTECODE_USES_QSTR_TABLE
     size_t qstr_map_used = emit->qstr_map.used;
@@ -354,6 +381,15 @@ static void compile_generic_all_nodes(compiler_t *comp, mp_parse_node_struct_t *
 static void compile_load_id(compiler_t *comp, qstr qst) {
     if (comp->pass == MP_PASS_SCOPE) {
         mp_emit_common_get_id_for_load(comp->scope_cur, qst);
+        #if COMP_HOIST_GLOBALS
+        if (comp->break_label != INVALID_LABEL && mp_dynamic_compiler.hoist_globals) {
+            // a global read within a loop is a candidate for hoisting out of the loop
+            id_info_t *id = scope_find(comp->scope_cur, qst);
+            if (id->kind == ID_INFO_KIND_GLOBAL_IMPLICIT) {
+                id->flags |= ID_FLAG_IS_HOISTED;
+            }
+        }
+        #endif
     } else {
         #if NEED_METHOD_TABLE
         mp_emit_common_id_op(comp->emit, &comp->emit_method_table->load_id, comp->scope_cur, qst);
@@ -1388,7 +1424,74 @@ done:
     comp->continue_label = old_continue_label; \
     comp->break_continue_except_level = old_break_continue_except_level;
 
+#if COMP_HOIST_GLOBALS
+static bool compile_hoist_ids(compiler_t *comp, mp_parse_node_t pn) {
+    bool hoisted = false;
+    if (MP_PARSE_NODE_IS_ID(pn)) {
+        qstr qst = MP_PARSE_NODE_LEAF_ARG(pn);
+        id_info_t *id = scope_find(comp->scope_cur, qst);
+        if (id != NULL && (id->flags & ID_FLAG_IS_HOISTED) && id->kind == ID_INFO_KIND_GLOBAL_EXPLICIT) {
+            compile_load_id(comp, qst);
+            id->kind = ID_INFO_KIND_LOCAL;
+            compile_store_id(comp, qst);
+            hoisted = true;
+        }
+    } else if (MP_PARSE_NODE_IS_STRUCT(pn)) {
+        mp_parse_node_struct_t *pns = (mp_parse_node_struct_t *)pn;
+        if (MP_PARSE_NODE_STRUCT_KIND(pns) == PN_trailer_period
+            || MP_PARSE_NODE_STRUCT_KIND(pns) == PN_const_object) {
+            // an attribute name, or an object rather than nodes
+            return false;
+        }
+        size_t n = MP_PARSE_NODE_STRUCT_NUM_NODES(pns);
+        for (size_t i = 0; i < n; i++) {
+            hoisted |= compile_hoist_ids(comp, pns->nodes[i]);
+        }
+    }
+    return hoisted;
+}
+
+// With mp_dynamic_compiler.hoist_globals, globals and builtins that are read
+// within the outermost loop of a function (and pass compile_filter_hoisted_ids)
+// are loaded once before the loop into their hidden local, and are then read
+// from that local for the rest of the loop statement.  Returns true if any were,
+// in which case the caller compiles the loop and then calls compile_hoist_end.
+//
+// This is not safe in general, which is why it's opt-in: the loop no longer
+// sees the name being rebound while it runs (through globals(), by a function
+// it calls, or from another module), and a name that is missing raises
+// NameError before the loop even if the loop would never have read it.
+static bool compile_hoist_start(compiler_t *comp, mp_parse_node_t pn0, mp_parse_node_t pn1) {
+    if (comp->pass == MP_PASS_SCOPE
+        || comp->break_label != INVALID_LABEL
+        || comp->scope_cur->kind != SCOPE_FUNCTION
+        || !mp_dynamic_compiler.hoist_globals) {
+        return false;
+    }
+    bool hoisted = compile_hoist_ids(comp, pn0);
+    return compile_hoist_ids(comp, pn1) || hoisted;
+}
+
+static void compile_hoist_end(compiler_t *comp) {
+    scope_t *scope = comp->scope_cur;
+    for (size_t i = 0; i < scope->id_info_len; i++) {
+        id_info_t *id = &scope->id_info[i];
+        if ((id->flags & ID_FLAG_IS_HOISTED) && id->kind == ID_INFO_KIND_LOCAL) {
+            id->kind = ID_INFO_KIND_GLOBAL_EXPLICIT;
+        }
+    }
+}
+#endif
+
 static void compile_while_stmt(compiler_t *comp, mp_parse_node_struct_t *pns) {
+    #if COMP_HOIST_GLOBALS
+    if (!mp_parse_node_is_const_false(pns->nodes[0]) && compile_hoist_start(comp, pns->nodes[0], pns->nodes[1])) {
+        compile_while_stmt(comp, pns);
+        compile_hoist_end(comp);
+        return;
+    }
+    #endif
+
     START_BREAK_CONTINUE_BLOCK
 
     if (!mp_parse_node_is_const_false(pns->nodes[0])) { // optimisation: don't emit anything for "while False"
@@ -1509,6 +1612,14 @@ static void compile_for_stmt_optimised_range(compiler_t *comp, mp_parse_node_t p
 }
 
 static void compile_for_stmt(compiler_t *comp, mp_parse_node_struct_t *pns) {
+    #if COMP_HOIST_GLOBALS
+    if (compile_hoist_start(comp, pns->nodes[2], MP_PARSE_NODE_NULL)) {
+        compile_for_stmt(comp, pns);
+        compile_hoist_end(comp);
+        return;
+    }
+    #endif
+
     // this bit optimises: for <x> in range(...), turning it into an explicitly incremented variable
     // this is actually slower, but uses no heap memory
     // for viper it will be much, much faster
@@ -3423,6 +3534,16 @@ static void scope_compute_things(scope_t *scope) {
         }
     }
 
+    #if COMP_HOIST_GLOBALS
+    // compute the index of the hidden locals that hold hoisted globals
+    for (int i = 0; i < scope->id_info_len; i++) {
+        id_info_t *id = &scope->id_info[i];
+        if (id->flags & ID_FLAG_IS_HOISTED) {
+            id->local_num = scope->num_locals++;
+        }
+    }
+    #endif
+
     // compute the index of cell vars
     for (int i = 0; i < scope->id_info_len; i++) {
         id_info_t *id = &scope->id_info[i];
@@ -3467,6 +3588,111 @@ static void scope_compute_things(scope_t *scope) {
     }
 }
 
+#if COMP_HOIST_GLOBALS
+static bool compile_is_hoistable_global(scope_t *scope_head, scope_t *module_scope, qstr qst) {
+    for (scope_t *s = scope_head; s != NULL; s = s->next) {
+        id_info_t *id = scope_find(s, qst);
+        if (id != NULL && id->kind == ID_INFO_KIND_GLOBAL_EXPLICIT) {
+            // declared global somewhere, so it may be rebound while a loop runs
+            return false;
+        }
+    }
+    id_info_t *id = scope_find(module_scope, qst);
+    if (id != NULL && id->kind == ID_INFO_KIND_GLOBAL_IMPLICIT_ASSIGNED) {
+        return true;
+    }
+    return mp_map_lookup((mp_map_t *)&mp_module_builtins_globals.map, MP_OBJ_NEW_QSTR(qst), MP_MAP_LOOKUP) != NULL;
+}
+
+// Of the globals read within loops, keep ID_FLAG_IS_HOISTED only on those that
+// can be loaded before the loop: in bytecode functions that are not generators,
+// and for names that are not declared global by any scope in this module (so
+// the module's own code can't rebind them during the loop) and that are either
+// assigned at the top level of the module or are builtins (so the early load is
+// unlikely to raise a NameError that the loop itself would not have raised).
+static void compile_filter_hoisted_ids(scope_t *scope_head, scope_t *module_scope) {
+    for (scope_t *s = scope_head; s != NULL; s = s->next) {
+        bool eligible = s->kind == SCOPE_FUNCTION
+            && s->emit_options == MP_EMIT_OPT_NONE
+            && !(s->scope_flags & MP_SCOPE_FLAG_GENERATOR);
+        for (size_t i = 0; i < s->id_info_len; ++i) {
+            id_info_t *id = &s->id_info[i];
+            if ((id->flags & ID_FLAG_IS_HOISTED)
+                && !(eligible
+                     && id->kind == ID_INFO_KIND_GLOBAL_IMPLICIT
+                     && compile_is_hoistable_global(scope_head, module_scope, id->qst))) {
+                id->flags &= ~ID_FLAG_IS_HOISTED;
+            }
+        }
+    }
+}
+#endif
+
+// Run the passes that emit the code for a scope, with the current emitter.
+static void compile_scope_emit(compiler_t *comp, scope_t *s) {
+    // need a pass to compute stack size
+    compile_scope(comp, s, MP_PASS_STACK_SIZE);
+
+    // second last pass: compute code size
+    if (comp->compile_error == MP_OBJ_NULL) {
+        compile_scope(comp, s, MP_PASS_CODE_SIZE);
+    }
+
+    // final pass: emit code
+    // the emitter can request multiple of these passes
+    if (comp->compile_error == MP_OBJ_NULL) {
+        while (!compile_scope(comp, s, MP_PASS_EMIT)) {
+        }
+    }
+}
+
+#if MICROPY_DYNAMIC_COMPILER && MICROPY_EMIT_NATIVE
+// Give mp_dynamic_compiler.native_select the chance to have a function that was
+// compiled to bytecode compiled to native code instead (eg mpy-cross does this
+// for the functions that a call profile shows are hot).  It's called once with
+// a native length of 0 to ask whether to try, then again with the actual length
+// to decide whether to keep the native code.  If the native emitter can't
+// compile the function, or the native code isn't wanted, the function is
+// compiled to bytecode again.
+static void compile_scope_select_native(compiler_t *comp, scope_t *s, emit_t *emit_bc, emit_t **emit_native, uint max_num_labels) {
+    mp_raw_code_t *rc = s->raw_code;
+    size_t line = mp_bytecode_get_first_line(rc->fun_data);
+    size_t bytecode_len = rc->fun_data_len;
+    if (!mp_dynamic_compiler.native_select(s->simple_name, line, bytecode_len, 0)) {
+        return;
+    }
+
+    // The native code may add to the module's qstr and constant tables, which
+    // must be undone if the function goes back to bytecode
+    #if MICROPY_EMIT_BYTECODE_USES_QSTR_TABLE
+    size_t n_qstr = comp->emit_common.qstr_map.used;
+    #else
+    size_t n_qstr = 0;
+    #endif
+    size_t n_obj = comp->emit_common.const_obj_list.len;
+
+    if (*emit_native == NULL) {
+        *emit_native = NATIVE_EMITTER(new)(&comp->emit_common, &comp->compile_error, &comp->next_label, max_num_labels);
+    }
+    s->emit_options = MP_EMIT_OPT_NATIVE_PYTHON;
+    comp->emit_method_table = NATIVE_EMITTER_TABLE;
+    comp->emit = *emit_native;
+    compile_scope_emit(comp, s);
+    if (comp->compile_error == MP_OBJ_NULL
+        && mp_dynamic_compiler.native_select(s->simple_name, line, bytecode_len, rc->fun_data_len)) {
+        return;
+    }
+
+    comp->compile_error = MP_OBJ_NULL;
+    comp->compile_error_line = 0;
+    mp_emit_common_truncate(&comp->emit_common, n_qstr, n_obj);
+    s->emit_options = MP_EMIT_OPT_NONE;
+    comp->emit_method_table = &emit_bc_method_table;
+    comp->emit = emit_bc;
+    compile_scope_emit(comp, s);
+}
+#endif
+
 #if !MICROPY_EXPOSE_MP_COMPILE_TO_RAW_CODE
 static
 #endif
@@ -3521,6 +3747,12 @@ void mp_compile_to_raw_code(mp_parse_tree_t *parse_tree, qstr source_file, bool
         }
     }
 
+    #if COMP_HOIST_GLOBALS
+    if (comp->compile_error == MP_OBJ_NULL && mp_dynamic_compiler.hoist_globals) {
+        compile_filter_hoisted_ids(comp->scope_head, module_scope);
+    }
+    #endif
+
     // compute some things related to scope and identifiers
     for (scope_t *s = comp->scope_head; s != NULL && comp->compile_error == MP_OBJ_NULL; s = s->next) {
         scope_compute_things(s);
@@ -3584,20 +3816,16 @@ void mp_compile_to_raw_code(mp_parse_tree_t *parse_tree, qstr source_file, bool
                     break;
             }
 
-            // need a pass to compute stack size
-            compile_scope(comp, s, MP_PASS_STACK_SIZE);
+            compile_scope_emit(comp, s);
 
-            // second last pass: compute code size
-            if (comp->compile_error == MP_OBJ_NULL) {
-                compile_scope(comp, s, MP_PASS_CODE_SIZE);
-            }
-
-            // final pass: emit code
-            // the emitter can request multiple of these passes
-            if (comp->compile_error == MP_OBJ_NULL) {
-                while (!compile_scope(comp, s, MP_PASS_EMIT)) {
-                }
+            #if MICROPY_DYNAMIC_COMPILER && MICROPY_EMIT_NATIVE
+            if (comp->compile_error == MP_OBJ_NULL
+                && mp_dynamic_compiler.native_select != NULL
+                && s->kind == SCOPE_FUNCTION
+                && s->emit_options == MP_EMIT_OPT_NONE) {
+                compile_scope_select_native(comp, s, emit_bc, &emit_native, max_num_labels);
             }
+            #endif
         }
     }
 
@@ -40,6 +40,28 @@
 
 #define DUMMY_DATA_SIZE (MP_ENCODE_UINT_MAX_BYTES)
 
+// The peephole optimiser changes the opcodes that are executed for a given line,
+// so it is not used when tracing.
+#define EMIT_BC_PEEPHOLE (MICROPY_COMP_PEEPHOLE && !MICROPY_PY_SYS_SETTRACE)
+
+#if EMIT_BC_PEEPHOLE
+
+// Number of recently emitted opcodes that are remembered for fusing.
+#define PEEPHOLE_HISTORY_LEN (3)
+
+// Maximum number of labels at the same offset that can be threaded.
+#define PEEPHOLE_MAX_PENDING_LABELS (4)
+
+#define PEEPHOLE_NO_LABEL ((size_t)-1)
+
+typedef struct _peephole_op_t {
+    byte opcode; // generic opcode, one of MP_BC_LOAD_FAST_N, MP_BC_LOAD_CONST_SMALL_INT, MP_BC_BINARY_OP_MULTI
+    mp_int_t arg;
+    size_t offset;
+} peephole_op_t;
+
+#endif
+
 struct _emit_t {
     // Accessed as mp_obj_t, so must be aligned as such, and we rely on the
     // memory allocator returning a suitably aligned pointer.
@@ -73,6 +95,27 @@ struct _emit_t {
 
     size_t n_info;
     size_t n_cell;
+
+    #if EMIT_BC_PEEPHOLE
+    // The last few opcodes emitted, which are contiguous and end at history_end.
+    // This is cleared at labels and line number changes, so anything in it can
+    // be fused into a single opcode.
+    size_t history_len;
+    size_t history_end;
+    peephole_op_t history[PEEPHOLE_HISTORY_LEN];
+
+    // Labels assigned at pending_labels_offset during MP_PASS_STACK_SIZE, and
+    // for each label the label it jumps straight to (or PEEPHOLE_NO_LABEL).
+    size_t pending_labels_offset;
+    size_t num_pending_labels;
+    size_t pending_labels[PEEPHOLE_MAX_PENDING_LABELS];
+    size_t *label_forward;
+
+    // Bitmap of the fast locals that are loaded or deleted, computed during
+    // MP_PASS_STACK_SIZE; a store to any other local is dead.
+    size_t locals_used_len;
+    byte *locals_used;
+    #endif
 };
 
 emit_t *emit_bc_new(mp_emit_common_t *emit_common) {
@@ -84,9 +127,16 @@ emit_t *emit_bc_new(mp_emit_common_t *emit_common) {
 void emit_bc_set_max_num_labels(emit_t *emit, mp_uint_t max_num_labels) {
     emit->max_num_labels = max_num_labels;
     emit->label_offsets = m_new(size_t, emit->max_num_labels);
+    #if EMIT_BC_PEEPHOLE
+    emit->label_forward = m_new(size_t, emit->max_num_labels);
+    #endif
 }
 
 void emit_bc_free(emit_t *emit) {
+    #if EMIT_BC_PEEPHOLE
+    m_del(byte, emit->locals_used, emit->locals_used_len);
+    m_del(size_t, emit->label_forward, emit->max_num_labels);
+    #endif
     m_del(size_t, emit->label_offsets, emit->max_num_labels);
     m_del_obj(emit_t, emit);
 }
@@ -222,6 +272,66 @@ static void emit_write_bytecode_byte_child(emit_t *emit, int stack_adj, byte b,
     #endif
 }
 
+#if EMIT_BC_PEEPHOLE
+
+// Remember an opcode that was just emitted at the given offset, so that it can
+// be fused with the opcodes that follow it.
+static void peephole_record(emit_t *emit, byte opcode, mp_int_t arg, size_t offset) {
+    if (emit->suppress) {
+        return;
+    }
+    if (emit->history_end != offset) {
+        // Something else was emitted after the last recorded opcode.
+        emit->history_len = 0;
+    } else if (emit->history_len == PEEPHOLE_HISTORY_LEN) {
+        memmove(&emit->history[0], &emit->history[1], (PEEPHOLE_HISTORY_LEN - 1) * sizeof(peephole_op_t));
+        --emit->history_len;
+    }
+    peephole_op_t *op = &emit->history[emit->history_len++];
+    op->opcode = opcode;
+    op->arg = arg;
+    op->offset = offset;
+    emit->history_end = emit->bytecode_offset;
+}
+
+// If the last n opcodes emitted are in the history and the first of them is the
+// given opcode, return that entry (the others follow it in the history).
+static peephole_op_t *peephole_match(emit_t *emit, size_t n, byte opcode) {
+    if (emit->suppress || emit->history_end != emit->bytecode_offset || emit->history_len < n) {
+        return NULL;
+    }
+    peephole_op_t *op = &emit->history[emit->history_len - n];
+    return op->opcode == opcode ? op : NULL;
+}
+
+// Discard the opcodes from op onwards so a superinstruction can replace them.
+// Their stack adjustments have already been made.
+static void peephole_rewind(emit_t *emit, peephole_op_t *op) {
+    emit->bytecode_offset = op->offset;
+    emit->history_len = 0;
+}
+
+// Follow a label to the label that it jumps straight to, if any.  The number of
+// steps is bounded so that a cycle of jumps (eg "while 1: pass") terminates.
+static mp_uint_t peephole_thread_label(emit_t *emit, mp_uint_t label) {
+    for (size_t i = 0; i < 4 && emit->label_forward[label] != PEEPHOLE_NO_LABEL; ++i) {
+        label = emit->label_forward[label];
+    }
+    return label;
+}
+
+static void peephole_mark_local_used(emit_t *emit, mp_uint_t local_num) {
+    if (emit->pass == MP_PASS_STACK_SIZE) {
+        emit->locals_used[local_num / 8] |= 1 << (local_num & 7);
+    }
+}
+
+static bool peephole_local_is_used(emit_t *emit, mp_uint_t local_num) {
+    return emit->pass == MP_PASS_STACK_SIZE || (emit->locals_used[local_num / 8] & (1 << (local_num & 7)));
+}
+
+#endif
+
 // Emit a jump opcode to a destination label.
 // The offset to the label is relative to the ip following this instruction.
 // The offset is encoded as either 1 or 2 bytes, depending on how big it is.
@@ -237,6 +347,15 @@ static void emit_write_bytecode_byte_label(emit_t *emit, int stack_adj, byte b1,
     // Determine if the jump offset is signed or unsigned, based on the opcode.
     const bool is_signed = b1 <= MP_BC_POP_JUMP_IF_FALSE;
 
+    #if EMIT_BC_PEEPHOLE
+    // A jump to an unconditional jump can go straight to the final destination.
+    // This is decided by MP_PASS_STACK_SIZE (where all jumps have the largest
+    // encoding) so that the code still only shrinks on each following pass.
+    if (is_signed && b1 != MP_BC_UNWIND_JUMP && emit->pass >= MP_PASS_CODE_SIZE) {
+        label = peephole_thread_label(emit, label);
+    }
+    #endif
+
     // Default to a 2-byte encoding (the largest) with an unknown jump offset.
     unsigned int jump_encoding_size = 1;
     ssize_t bytecode_offset = 0;
@@ -291,6 +410,23 @@ void mp_emit_bc_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scope) {
     emit->code_info_offset = 0;
     emit->overflow = false;
 
+    #if EMIT_BC_PEEPHOLE
+    emit->history_len = 0;
+    emit->history_end = 0;
+    if (pass == MP_PASS_STACK_SIZE) {
+        emit->num_pending_labels = 0;
+        for (size_t i = 0; i < emit->max_num_labels; ++i) {
+            emit->label_forward[i] = PEEPHOLE_NO_LABEL;
+        }
+        size_t n = (scope->num_locals + 7) / 8;
+        if (n > emit->locals_used_len) {
+            emit->locals_used = m_renew(byte, emit->locals_used, emit->locals_used_len, n);
+            emit->locals_used_len = n;
+        }
+        memset(emit->locals_used, 0, n);
+    }
+    #endif
+
     // Write local state size, exception stack size, scope flags and number of arguments
     {
         mp_uint_t n_state = scope->num_locals + scope->stack_size;
@@ -436,6 +572,10 @@ void mp_emit_bc_set_source_line(emit_t *emit, mp_uint_t source_line) {
         emit_write_code_info_bytes_lines(emit, bytes_to_skip, lines_to_skip);
         emit->last_source_line_offset = emit->bytecode_offset;
         emit->last_source_line = source_line;
+        #if EMIT_BC_PEEPHOLE
+        // Opcodes on different lines can't be fused.
+        emit->history_len = 0;
+        #endif
     }
     #else
     (void)emit;
@@ -461,6 +601,22 @@ void mp_emit_bc_label_assign(emit_t *emit, mp_uint_t l) {
 
     // Assign label offset.
     emit->label_offsets[l] = emit->bytecode_offset;
+
+    #if EMIT_BC_PEEPHOLE
+    // Nothing can be fused across a label, since it can be jumped to.
+    emit->history_len = 0;
+
+    // Remember the labels at this offset, in case the next opcode is a jump.
+    if (emit->pass == MP_PASS_STACK_SIZE) {
+        if (emit->pending_labels_offset != emit->bytecode_offset) {
+            emit->pending_labels_offset = emit->bytecode_offset;
+            emit->num_pending_labels = 0;
+        }
+        if (emit->num_pending_labels < PEEPHOLE_MAX_PENDING_LABELS) {
+            emit->pending_labels[emit->num_pending_labels++] = l;
+        }
+    }
+    #endif
 }
 
 void mp_emit_bc_import(emit_t *emit, qstr qst, int kind) {
@@ -486,6 +642,9 @@ void mp_emit_bc_load_const_tok(emit_t *emit, mp_token_kind_t tok) {
 
 void mp_emit_bc_load_const_small_int(emit_t *emit, mp_int_t arg) {
     assert(MP_SMALL_INT_FITS(arg));
+    #if EMIT_BC_PEEPHOLE
+    size_t offset = emit->bytecode_offset;
+    #endif
     if (-MP_BC_LOAD_CONST_SMALL_INT_MULTI_EXCESS <= arg
         && arg < MP_BC_LOAD_CONST_SMALL_INT_MULTI_NUM - MP_BC_LOAD_CONST_SMALL_INT_MULTI_EXCESS) {
         emit_write_bytecode_byte(emit, 1,
@@ -493,6 +652,9 @@ void mp_emit_bc_load_const_small_int(emit_t *emit, mp_int_t arg) {
     } else {
         emit_write_bytecode_byte_int(emit, 1, MP_BC_LOAD_CONST_SMALL_INT, arg);
     }
+    #if EMIT_BC_PEEPHOLE
+    peephole_record(emit, MP_BC_LOAD_CONST_SMALL_INT, arg, offset);
+    #endif
 }
 
 void mp_emit_bc_load_const_str(emit_t *emit, qstr qst) {
@@ -511,11 +673,31 @@ void mp_emit_bc_load_local(emit_t *emit, qstr qst, mp_uint_t local_num, int kind
     MP_STATIC_ASSERT(MP_BC_LOAD_FAST_N + MP_EMIT_IDOP_LOCAL_FAST == MP_BC_LOAD_FAST_N);
     MP_STATIC_ASSERT(MP_BC_LOAD_FAST_N + MP_EMIT_IDOP_LOCAL_DEREF == MP_BC_LOAD_DEREF);
     (void)qst;
+    #if EMIT_BC_PEEPHOLE
+    if (kind == MP_EMIT_IDOP_LOCAL_FAST) {
+        peephole_mark_local_used(emit, local_num);
+        // LOAD_FAST a, LOAD_FAST b -> LOAD_FAST_2 (a << 4 | b), which is the same
+        // size when a < 8.  Local 0 is not fused as the second load because it is
+        // usually "self" and better fused with a following LOAD_ATTR.
+        peephole_op_t *op = peephole_match(emit, 1, MP_BC_LOAD_FAST_N);
+        if (op != NULL && op->arg < 8 && 1 <= local_num && local_num <= 15) {
+            peephole_rewind(emit, op);
+            emit_write_bytecode_byte_uint(emit, 1, MP_BC_LOAD_FAST_2, op->arg << 4 | local_num);
+            return;
+        }
+    }
+    size_t offset = emit->bytecode_offset;
+    #endif
     if (kind == MP_EMIT_IDOP_LOCAL_FAST && local_num <= 15) {
         emit_write_bytecode_byte(emit, 1, MP_BC_LOAD_FAST_MULTI + local_num);
     } else {
         emit_write_bytecode_byte_uint(emit, 1, MP_BC_LOAD_FAST_N + kind, local_num);
     }
+    #if EMIT_BC_PEEPHOLE
+    if (kind == MP_EMIT_IDOP_LOCAL_FAST) {
+        peephole_record(emit, MP_BC_LOAD_FAST_N, local_num, offset);
+    }
+    #endif
 }
 
 void mp_emit_bc_load_global(emit_t *emit, qstr qst, int kind) {
@@ -548,6 +730,15 @@ void mp_emit_bc_subscr(emit_t *emit, int kind) {
 
 void mp_emit_bc_attr(emit_t *emit, qstr qst, int kind) {
     if (kind == MP_EMIT_ATTR_LOAD) {
+        #if EMIT_BC_PEEPHOLE
+        // LOAD_FAST 0, LOAD_ATTR -> LOAD_FAST_0_ATTR, eg self.attr in a method.
+        peephole_op_t *op = peephole_match(emit, 1, MP_BC_LOAD_FAST_N);
+        if (op != NULL && op->arg == 0) {
+            peephole_rewind(emit, op);
+            emit_write_bytecode_byte_qstr(emit, 0, MP_BC_LOAD_FAST_0_ATTR, qst);
+            return;
+        }
+        #endif
         emit_write_bytecode_byte_qstr(emit, 0, MP_BC_LOAD_ATTR, qst);
     } else {
         if (kind == MP_EMIT_ATTR_DELETE) {
@@ -562,6 +753,28 @@ void mp_emit_bc_store_local(emit_t *emit, qstr qst, mp_uint_t local_num, int kin
     MP_STATIC_ASSERT(MP_BC_STORE_FAST_N + MP_EMIT_IDOP_LOCAL_FAST == MP_BC_STORE_FAST_N);
     MP_STATIC_ASSERT(MP_BC_STORE_FAST_N + MP_EMIT_IDOP_LOCAL_DEREF == MP_BC_STORE_DEREF);
     (void)qst;
+    #if EMIT_BC_PEEPHOLE
+    if (kind == MP_EMIT_IDOP_LOCAL_FAST) {
+        if (!peephole_local_is_used(emit, local_num)) {
+            // This local is never loaded or deleted, so the store is dead.
+            emit_write_bytecode_byte(emit, -1, MP_BC_POP_TOP);
+            return;
+        }
+        // LOAD_FAST n, LOAD_CONST_SMALL_INT k, BINARY_OP INPLACE_ADD, STORE_FAST n
+        // -> INPLACE_ADD_FAST (k << 4 | n), and likewise for INPLACE_SUBTRACT.
+        peephole_op_t *op = peephole_match(emit, 3, MP_BC_LOAD_FAST_N);
+        if (op != NULL && op[0].arg == (mp_int_t)local_num && local_num <= 15
+            && op[1].opcode == MP_BC_LOAD_CONST_SMALL_INT && 0 <= op[1].arg && op[1].arg < 128
+            && op[2].opcode == MP_BC_BINARY_OP_MULTI
+            && (op[2].arg == MP_BINARY_OP_INPLACE_ADD || op[2].arg == MP_BINARY_OP_INPLACE_SUBTRACT)) {
+            byte opcode = op[2].arg == MP_BINARY_OP_INPLACE_ADD ? MP_BC_INPLACE_ADD_FAST : MP_BC_INPLACE_SUBTRACT_FAST;
+            mp_uint_t arg = op[1].arg << 4 | local_num;
+            peephole_rewind(emit, op);
+            emit_write_bytecode_byte_uint(emit, -1, opcode, arg);
+            return;
+        }
+    }
+    #endif
     if (kind == MP_EMIT_IDOP_LOCAL_FAST && local_num <= 15) {
         emit_write_bytecode_byte(emit, -1, MP_BC_STORE_FAST_MULTI + local_num);
     } else {
@@ -579,6 +792,11 @@ void mp_emit_bc_delete_local(emit_t *emit, qstr qst, mp_uint_t local_num, int ki
     MP_STATIC_ASSERT(MP_BC_DELETE_FAST + MP_EMIT_IDOP_LOCAL_FAST == MP_BC_DELETE_FAST);
     MP_STATIC_ASSERT(MP_BC_DELETE_FAST + MP_EMIT_IDOP_LOCAL_DEREF == MP_BC_DELETE_DEREF);
     (void)qst;
+    #if EMIT_BC_PEEPHOLE
+    if (kind == MP_EMIT_IDOP_LOCAL_FAST) {
+        peephole_mark_local_used(emit, local_num);
+    }
+    #endif
     emit_write_bytecode_byte_uint(emit, 0, MP_BC_DELETE_FAST + kind, local_num);
 }
 
@@ -609,11 +827,32 @@ void mp_emit_bc_rot_three(emit_t *emit) {
 }
 
 void mp_emit_bc_jump(emit_t *emit, mp_uint_t label) {
+    #if EMIT_BC_PEEPHOLE
+    // Any labels right before this jump can forward to its destination.
+    if (emit->pass == MP_PASS_STACK_SIZE && !emit->suppress
+        && emit->pending_labels_offset == emit->bytecode_offset) {
+        for (size_t i = 0; i < emit->num_pending_labels; ++i) {
+            emit->label_forward[emit->pending_labels[i]] = label;
+        }
+        emit->num_pending_labels = 0;
+    }
+    #endif
     emit_write_bytecode_byte_label(emit, 0, MP_BC_JUMP, label);
     emit->suppress = true;
 }
 
 void mp_emit_bc_pop_jump_if(emit_t *emit, bool cond, mp_uint_t label) {
+    #if EMIT_BC_PEEPHOLE
+    // BINARY_OP op, POP_JUMP_IF_cond -> BINARY_OP_POP_JUMP_IF, eg for "if a < b:".
+    peephole_op_t *op = peephole_match(emit, 1, MP_BC_BINARY_OP_MULTI);
+    if (op != NULL) {
+        byte arg = op->arg | (cond ? MP_BC_BINARY_OP_POP_JUMP_IF_TRUE_FLAG : 0);
+        peephole_rewind(emit, op);
+        emit_write_bytecode_byte_label(emit, -1, MP_BC_BINARY_OP_POP_JUMP_IF, label);
+        emit_write_bytecode_raw_byte(emit, arg);
+        return;
+    }
+    #endif
     if (cond) {
         emit_write_bytecode_byte_label(emit, -1, MP_BC_POP_JUMP_IF_TRUE, label);
     } else {
@@ -723,7 +962,13 @@ void mp_emit_bc_binary_op(emit_t *emit, mp_binary_op_t op) {
         invert = true;
         op = MP_BINARY_OP_IS;
     }
+    #if EMIT_BC_PEEPHOLE
+    size_t offset = emit->bytecode_offset;
+    #endif
     emit_write_bytecode_byte(emit, -1, MP_BC_BINARY_OP_MULTI + op);
+    #if EMIT_BC_PEEPHOLE
+    peephole_record(emit, MP_BC_BINARY_OP_MULTI, op, offset);
+    #endif
     if (invert) {
         emit_write_bytecode_byte(emit, 0, MP_BC_UNARY_OP_MULTI + MP_UNARY_OP_NOT);
     }
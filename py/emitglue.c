@@ -35,6 +35,7 @@
 #include "py/runtime0.h"
 #include "py/bc.h"
 #include "py/objfun.h"
+#include "py/persistentcode.h"
 #include "py/profile.h"
 
 #if MICROPY_DEBUG_VERBOSE // print debugging info
@@ -179,7 +180,7 @@ mp_obj_t mp_make_function_from_proto_fun(mp_proto_fun_t proto_fun, const mp_modu
     // def_kw_args must be MP_OBJ_NULL or a dict
     assert(def_args == NULL || def_args[1] == MP_OBJ_NULL || mp_obj_is_type(def_args[1], &mp_type_dict));
 
-    #if MICROPY_MODULE_FROZEN_MPY
+    #if MICROPY_MODULE_FROZEN_MPY || MICROPY_PERSISTENT_CODE_LAZY
     if (mp_proto_fun_is_bytecode(proto_fun)) {
         const uint8_t *bc = proto_fun;
         mp_obj_t fun = mp_obj_new_fun_bc(def_args, bc, context, NULL);
@@ -194,6 +195,12 @@ mp_obj_t mp_make_function_from_proto_fun(mp_proto_fun_t proto_fun, const mp_modu
     // the proto-function is a mp_raw_code_t
     const mp_raw_code_t *rc = proto_fun;
 
+    #if MICROPY_PERSISTENT_CODE_LAZY
+    if (rc->kind == MP_CODE_BYTECODE_LAZY) {
+        mp_raw_code_load_lazy((mp_raw_code_t *)rc);
+    }
+    #endif
+
     // make the function, depending on the raw code kind
     mp_obj_t fun;
     switch (rc->kind) {
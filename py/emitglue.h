@@ -52,6 +52,7 @@ typedef enum {
     MP_CODE_NATIVE_PY,
     MP_CODE_NATIVE_VIPER,
     MP_CODE_NATIVE_ASM,
+    MP_CODE_BYTECODE_LAZY, // fun_data is the raw code in a memory-mapped .mpy file
 } mp_raw_code_kind_t;
 
 // An mp_proto_fun_t points to static information about a non-instantiated function.
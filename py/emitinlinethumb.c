@@ -104,7 +104,7 @@ static void emit_inline_thumb_start_pass(emit_inline_asm_t *emit, pass_kind_t pa
         memset(emit->label_lookup, 0, emit->max_num_labels * sizeof(qstr));
     }
     mp_asm_base_start_pass(&emit->as.base, pass == MP_PASS_EMIT ? MP_ASM_PASS_EMIT : MP_ASM_PASS_COMPUTE);
-    asm_thumb_entry(&emit->as, 0);
+    asm_thumb_entry(&emit->as, 0, false);
 }
 
 static void emit_inline_thumb_end_pass(emit_inline_asm_t *emit, mp_uint_t type_sig) {
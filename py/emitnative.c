@@ -152,29 +152,56 @@
 // When building with the ability to save native code to .mpy files:
 //  - Qstrs are indirect via qstr_table, and REG_LOCAL_3 always points to qstr_table.
 //  - In a generator no registers are used to store locals, and REG_LOCAL_2 points to the generator state.
-//  - At most 2 registers hold local variables (see CAN_USE_REGS_FOR_LOCALS for when this is possible).
+//  - At most 2 registers (4 if the architecture has REG_LOCAL_4/5) hold local variables
+//    (see CAN_USE_REGS_FOR_LOCALS for when this is possible).
 
 #define REG_GENERATOR_STATE (REG_LOCAL_2)
 #define REG_QSTR_TABLE (REG_LOCAL_3)
-#define MAX_REGS_FOR_LOCAL_VARS (2)
+#define REG_LOCAL_LAST (REG_LOCAL_2)
 
-static const uint8_t reg_local_table[MAX_REGS_FOR_LOCAL_VARS] = {REG_LOCAL_1, REG_LOCAL_2};
+static const uint8_t reg_local_table[] = {
+    REG_LOCAL_1, REG_LOCAL_2,
+    #ifdef REG_LOCAL_5
+    REG_LOCAL_4, REG_LOCAL_5,
+    #endif
+};
 
 #else
 
 // When building without the ability to save native code to .mpy files:
 //  - Qstrs values are written directly into the machine code.
 //  - In a generator no registers are used to store locals, and REG_LOCAL_3 points to the generator state.
-//  - At most 3 registers hold local variables (see CAN_USE_REGS_FOR_LOCALS for when this is possible).
+//  - At most 3 registers (5 if the architecture has REG_LOCAL_4/5) hold local variables
+//    (see CAN_USE_REGS_FOR_LOCALS for when this is possible).
 
 #define REG_GENERATOR_STATE (REG_LOCAL_3)
-#define MAX_REGS_FOR_LOCAL_VARS (3)
+#define REG_LOCAL_LAST (REG_LOCAL_3)
+
+static const uint8_t reg_local_table[] = {
+    REG_LOCAL_1, REG_LOCAL_2, REG_LOCAL_3,
+    #ifdef REG_LOCAL_5
+    REG_LOCAL_4, REG_LOCAL_5,
+    #endif
+};
+
+#endif
 
-static const uint8_t reg_local_table[MAX_REGS_FOR_LOCAL_VARS] = {REG_LOCAL_1, REG_LOCAL_2, REG_LOCAL_3};
+// REG_LOCAL_LAST is used as a base register to load the arguments of a viper
+// function, so it's the last of REG_LOCAL_1-3 that hold locals, not REG_LOCAL_5.
+#define MAX_REGS_FOR_LOCAL_VARS ((int)MP_ARRAY_SIZE(reg_local_table))
 
+// Whether locals in the given register must be moved through REG_TEMP0 to be used.
+#ifndef REG_LOCAL_IS_HIGH
+#define REG_LOCAL_IS_HIGH(reg) (false)
 #endif
 
-#define REG_LOCAL_LAST (reg_local_table[MAX_REGS_FOR_LOCAL_VARS - 1])
+// Marks a local that is kept in the C stack rather than in a register.
+#define REG_LOCAL_NONE (0xff)
+
+// Uses of a local inside a loop are weighted by this power of 2 per level of nesting,
+// when choosing which locals to keep in registers.
+#define LOCAL_USE_LOOP_WEIGHT_SHIFT (3)
+#define LOCAL_USE_MAX_LOOP_DEPTH (6)
 
 #define EMIT_NATIVE_VIPER_TYPE_ERROR(emit, ...) do { \
         *emit->error_slot = mp_obj_new_exception_msg_varg(&mp_type_ViperTypeError, __VA_ARGS__); \
@@ -246,6 +273,14 @@ typedef struct _stack_info_t {
 #define UNWIND_LABEL_UNUSED (0x7fff)
 #define UNWIND_LABEL_DO_FINAL_UNWIND (0x7ffe)
 
+// A load or store of a local, recorded during MP_PASS_STACK_SIZE.
+typedef struct _local_use_t {
+    uint16_t local_num;
+    uint16_t loop_depth;
+    size_t code_pos;
+    size_t loop_head;
+} local_use_t;
+
 typedef struct _exc_stack_entry_t {
     uint16_t label : 15;
     uint16_t is_finally : 1;
@@ -264,6 +299,11 @@ struct _emit_t {
 
     mp_uint_t local_vtype_alloc;
     vtype_kind_t *local_vtype;
+    uint8_t *local_reg;
+
+    size_t local_use_alloc;
+    size_t local_use_len;
+    local_use_t *local_use;
 
     mp_uint_t stack_info_alloc;
     stack_info_t *stack_info;
@@ -316,6 +356,8 @@ void EXPORT_FUN(free)(emit_t * emit) {
     mp_asm_base_deinit(&emit->as->base, false);
     m_del_obj(ASM_T, emit->as);
     m_del(exc_stack_entry_t, emit->exc_stack, emit->exc_stack_alloc);
+    m_del(local_use_t, emit->local_use, emit->local_use_alloc);
+    m_del(uint8_t, emit->local_reg, emit->local_vtype_alloc);
     m_del(vtype_kind_t, emit->local_vtype, emit->local_vtype_alloc);
     m_del(stack_info_t, emit->stack_info, emit->stack_info_alloc);
     m_del_obj(emit_t, emit);
@@ -377,6 +419,99 @@ static void emit_native_mov_reg_qstr_obj(emit_t *emit, int reg_dest, qstr qst) {
         emit_native_mov_state_reg((emit), (local_num), (reg_temp)); \
     } while (false)
 
+// Record a load or store of a local, used to choose which locals are kept in registers.
+static void emit_native_note_local_use(emit_t *emit, mp_uint_t local_num) {
+    if (emit->pass != MP_PASS_STACK_SIZE || !CAN_USE_REGS_FOR_LOCALS(emit)) {
+        return;
+    }
+    if (emit->local_use_len >= emit->local_use_alloc) {
+        size_t new_alloc = emit->local_use_alloc * 2 + 16;
+        emit->local_use = m_renew(local_use_t, emit->local_use, emit->local_use_alloc, new_alloc);
+        emit->local_use_alloc = new_alloc;
+    }
+    local_use_t *use = &emit->local_use[emit->local_use_len++];
+    use->local_num = local_num;
+    use->loop_depth = 0;
+    use->code_pos = mp_asm_base_get_code_pos(&emit->as->base);
+    use->loop_head = (size_t)-1;
+}
+
+// A jump back to a label that is already assigned closes a loop, so all uses of
+// locals since that label are one level deeper inside loops.
+static void emit_native_note_jump(emit_t *emit, mp_uint_t label) {
+    if (emit->pass != MP_PASS_STACK_SIZE || label >= emit->as->base.max_num_labels) {
+        return;
+    }
+    size_t head = emit->as->base.label_offsets[label];
+    if (head == (size_t)-1) {
+        // Forward jump
+        return;
+    }
+    for (size_t i = emit->local_use_len; i > 0 && emit->local_use[i - 1].code_pos >= head; --i) {
+        local_use_t *use = &emit->local_use[i - 1];
+        // Count each loop only once, even if it has more than one jump back to its head
+        if (use->loop_head > head) {
+            use->loop_head = head;
+            if (use->loop_depth < LOCAL_USE_MAX_LOOP_DEPTH) {
+                ++use->loop_depth;
+            }
+        }
+    }
+}
+
+// Choose which locals are kept in registers.  During MP_PASS_STACK_SIZE these are
+// just the first locals, and that pass records every use of a local.  The later
+// passes then use the locals with the most uses, weighted by loop depth.
+static void emit_native_alloc_local_regs(emit_t *emit) {
+    scope_t *scope = emit->scope;
+    for (mp_uint_t i = 0; i < scope->num_locals; ++i) {
+        emit->local_reg[i] = REG_LOCAL_NONE;
+    }
+    if (!CAN_USE_REGS_FOR_LOCALS(emit)) {
+        return;
+    }
+
+    int num_regs = MAX_REGS_FOR_LOCAL_VARS;
+    #if N_THUMB
+    if (!asm_thumb_allow_armv7m(emit->as)) {
+        // REG_LOCAL_4/5 are only saved on entry for ARMv7-M (see asm_thumb_entry)
+        num_regs -= 2;
+    }
+    #endif
+    num_regs = MIN(num_regs, scope->num_locals);
+    if (emit->pass == MP_PASS_STACK_SIZE || num_regs == scope->num_locals) {
+        for (int i = 0; i < num_regs; ++i) {
+            emit->local_reg[i] = reg_local_table[i];
+        }
+        return;
+    }
+
+    mp_uint_t *weight = m_new0(mp_uint_t, scope->num_locals);
+    for (size_t i = 0; i < emit->local_use_len; ++i) {
+        local_use_t *use = &emit->local_use[i];
+        weight[use->local_num] += (mp_uint_t)1 << (use->loop_depth * LOCAL_USE_LOOP_WEIGHT_SHIFT);
+    }
+
+    // Pick the heaviest locals, preferring lower numbered ones when equal
+    for (int n = 0; n < num_regs; ++n) {
+        mp_uint_t best = scope->num_locals;
+        for (mp_uint_t i = 0; i < scope->num_locals; ++i) {
+            if (emit->local_reg[i] == REG_LOCAL_NONE && (best == scope->num_locals || weight[i] > weight[best])) {
+                best = i;
+            }
+        }
+        emit->local_reg[best] = 0;
+    }
+    m_del(mp_uint_t, weight, scope->num_locals);
+
+    // Hand out the registers in order of local number
+    for (mp_uint_t i = 0, n = 0; i < scope->num_locals; ++i) {
+        if (emit->local_reg[i] != REG_LOCAL_NONE) {
+            emit->local_reg[i] = reg_local_table[n++];
+        }
+    }
+}
+
 static void emit_native_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scope) {
     DEBUG_printf("start_pass(pass=%u, scope=%p)\n", pass, scope);
 
@@ -388,6 +523,7 @@ static void emit_native_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scop
     // allocate memory for keeping track of the types of locals
     if (emit->local_vtype_alloc < scope->num_locals) {
         emit->local_vtype = m_renew(vtype_kind_t, emit->local_vtype, emit->local_vtype_alloc, scope->num_locals);
+        emit->local_reg = m_renew(uint8_t, emit->local_reg, emit->local_vtype_alloc, scope->num_locals);
         emit->local_vtype_alloc = scope->num_locals;
     }
 
@@ -427,6 +563,12 @@ static void emit_native_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scop
 
     mp_asm_base_start_pass(&emit->as->base, pass == MP_PASS_EMIT ? MP_ASM_PASS_EMIT : MP_ASM_PASS_COMPUTE);
 
+    // choose which locals to keep in registers
+    if (pass == MP_PASS_STACK_SIZE) {
+        emit->local_use_len = 0;
+    }
+    emit_native_alloc_local_regs(emit);
+
     // generate code for entry to function
 
     // Work out start of code state (mp_code_state_native_t or reduced version for viper)
@@ -447,16 +589,14 @@ static void emit_native_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scop
         // Work out size of state (locals plus stack)
         // n_state counts all stack and locals, even those in registers
         emit->n_state = scope->num_locals + scope->stack_size;
+        // The stack slots of the leading locals that are in registers are not needed
         int num_locals_in_regs = 0;
-        if (CAN_USE_REGS_FOR_LOCALS(emit)) {
-            num_locals_in_regs = scope->num_locals;
-            if (num_locals_in_regs > MAX_REGS_FOR_LOCAL_VARS) {
-                num_locals_in_regs = MAX_REGS_FOR_LOCAL_VARS;
-            }
-            // Need a spot for REG_LOCAL_LAST (see below)
-            if (scope->num_pos_args >= MAX_REGS_FOR_LOCAL_VARS + 1) {
-                --num_locals_in_regs;
+        while (num_locals_in_regs < scope->num_locals && emit->local_reg[num_locals_in_regs] != REG_LOCAL_NONE) {
+            // Need a spot for REG_LOCAL_LAST if it's not the last argument (see below)
+            if (emit->local_reg[num_locals_in_regs] == REG_LOCAL_LAST && num_locals_in_regs < scope->num_pos_args - 1) {
+                break;
             }
+            ++num_locals_in_regs;
         }
 
         // Work out where the locals and Python stack start within the C stack
@@ -519,15 +659,18 @@ static void emit_native_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scop
                 r = REG_RET;
             }
             // REG_LOCAL_LAST points to the args array so be sure not to overwrite it if it's still needed
-            if (i < MAX_REGS_FOR_LOCAL_VARS && CAN_USE_REGS_FOR_LOCALS(emit) && (i != MAX_REGS_FOR_LOCAL_VARS - 1 || emit->scope->num_pos_args == MAX_REGS_FOR_LOCAL_VARS)) {
-                ASM_MOV_REG_REG(emit->as, reg_local_table[i], r);
+            int reg_local = emit->local_reg[i];
+            if (reg_local != REG_LOCAL_NONE && (reg_local != REG_LOCAL_LAST || i == emit->scope->num_pos_args - 1)) {
+                ASM_MOV_REG_REG(emit->as, reg_local, r);
             } else {
                 emit_native_mov_state_reg(emit, LOCAL_IDX_LOCAL_VAR(emit, i), r);
             }
         }
         // Get local from the stack back into REG_LOCAL_LAST if this reg couldn't be written to above
-        if (emit->scope->num_pos_args >= MAX_REGS_FOR_LOCAL_VARS + 1 && CAN_USE_REGS_FOR_LOCALS(emit)) {
-            ASM_MOV_REG_LOCAL(emit->as, REG_LOCAL_LAST, LOCAL_IDX_LOCAL_VAR(emit, MAX_REGS_FOR_LOCAL_VARS - 1));
+        for (int i = 0; i < emit->scope->num_pos_args - 1; ++i) {
+            if (emit->local_reg[i] == REG_LOCAL_LAST) {
+                ASM_MOV_REG_LOCAL(emit->as, REG_LOCAL_LAST, LOCAL_IDX_LOCAL_VAR(emit, i));
+            }
         }
 
         emit_native_global_exc_entry(emit);
@@ -626,9 +769,13 @@ static void emit_native_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scop
         emit_native_global_exc_entry(emit);
 
         // cache some locals in registers, but only if no exception handlers
-        if (CAN_USE_REGS_FOR_LOCALS(emit)) {
-            for (int i = 0; i < MAX_REGS_FOR_LOCAL_VARS && i < scope->num_locals; ++i) {
-                ASM_MOV_REG_LOCAL(emit->as, reg_local_table[i], LOCAL_IDX_LOCAL_VAR(emit, i));
+        for (int i = 0; i < scope->num_locals; ++i) {
+            int reg_local = emit->local_reg[i];
+            if (reg_local != REG_LOCAL_NONE && REG_LOCAL_IS_HIGH(reg_local)) {
+                ASM_MOV_REG_LOCAL(emit->as, REG_TEMP0, LOCAL_IDX_LOCAL_VAR(emit, i));
+                ASM_MOV_REG_REG(emit->as, reg_local, REG_TEMP0);
+            } else if (reg_local != REG_LOCAL_NONE) {
+                ASM_MOV_REG_LOCAL(emit->as, reg_local, LOCAL_IDX_LOCAL_VAR(emit, i));
             }
         }
 
@@ -1415,8 +1562,14 @@ static void emit_native_load_fast(emit_t *emit, qstr qst, mp_uint_t local_num) {
         EMIT_NATIVE_VIPER_TYPE_ERROR(emit, MP_ERROR_TEXT("local '%q' used before type known"), qst);
     }
     emit_native_pre(emit);
-    if (local_num < MAX_REGS_FOR_LOCAL_VARS && CAN_USE_REGS_FOR_LOCALS(emit)) {
-        emit_post_push_reg(emit, vtype, reg_local_table[local_num]);
+    emit_native_note_local_use(emit, local_num);
+    int reg_local = emit->local_reg[local_num];
+    if (reg_local != REG_LOCAL_NONE && REG_LOCAL_IS_HIGH(reg_local)) {
+        need_reg_single(emit, REG_TEMP0, 0);
+        ASM_MOV_REG_REG(emit->as, REG_TEMP0, reg_local);
+        emit_post_push_reg(emit, vtype, REG_TEMP0);
+    } else if (reg_local != REG_LOCAL_NONE) {
+        emit_post_push_reg(emit, vtype, reg_local);
     } else {
         need_reg_single(emit, REG_TEMP0, 0);
         emit_native_mov_reg_state(emit, REG_TEMP0, LOCAL_IDX_LOCAL_VAR(emit, local_num));
@@ -1685,8 +1838,13 @@ static void emit_native_load_subscr(emit_t *emit) {
 
 static void emit_native_store_fast(emit_t *emit, qstr qst, mp_uint_t local_num) {
     vtype_kind_t vtype;
-    if (local_num < MAX_REGS_FOR_LOCAL_VARS && CAN_USE_REGS_FOR_LOCALS(emit)) {
-        emit_pre_pop_reg(emit, &vtype, reg_local_table[local_num]);
+    emit_native_note_local_use(emit, local_num);
+    int reg_local = emit->local_reg[local_num];
+    if (reg_local != REG_LOCAL_NONE && REG_LOCAL_IS_HIGH(reg_local)) {
+        emit_pre_pop_reg(emit, &vtype, REG_TEMP0);
+        ASM_MOV_REG_REG(emit->as, reg_local, REG_TEMP0);
+    } else if (reg_local != REG_LOCAL_NONE) {
+        emit_pre_pop_reg(emit, &vtype, reg_local);
     } else {
         emit_pre_pop_reg(emit, &vtype, REG_TEMP0);
         emit_native_mov_state_reg(emit, LOCAL_IDX_LOCAL_VAR(emit, local_num), REG_TEMP0);
@@ -2081,6 +2239,7 @@ static void emit_native_jump(emit_t *emit, mp_uint_t label) {
     emit_native_pre(emit);
     // need to commit stack because we are jumping elsewhere
     need_stack_settled(emit);
+    emit_native_note_jump(emit, label);
     ASM_JUMP(emit->as, label);
     emit_post(emit);
     mp_asm_base_suppress_code(&emit->as->base);
@@ -2112,6 +2271,7 @@ static void emit_native_jump_helper(emit_t *emit, bool cond, mp_uint_t label, bo
     // need to commit stack because we may jump elsewhere
     need_stack_settled(emit);
     // Emit the jump
+    emit_native_note_jump(emit, label);
     if (cond) {
         ASM_JUMP_IF_REG_NONZERO(emit->as, REG_RET, label, vtype == VTYPE_PYOBJ);
     } else {
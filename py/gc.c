@@ -36,6 +36,10 @@
 #include <valgrind/memcheck.h>
 #endif
 
+#if MICROPY_GC_INCREMENTAL
+#include "py/mphal.h"
+#endif
+
 #if MICROPY_ENABLE_GC
 
 #if MICROPY_DEBUG_VERBOSE // print debugging info
@@ -68,15 +72,11 @@
 #define AT_MARK (3)
 
 #define BLOCKS_PER_ATB (4)
-#define ATB_MASK_0 (0x03)
-#define ATB_MASK_1 (0x0c)
-#define ATB_MASK_2 (0x30)
-#define ATB_MASK_3 (0xc0)
 
-#define ATB_0_IS_FREE(a) (((a) & ATB_MASK_0) == 0)
-#define ATB_1_IS_FREE(a) (((a) & ATB_MASK_1) == 0)
-#define ATB_2_IS_FREE(a) (((a) & ATB_MASK_2) == 0)
-#define ATB_3_IS_FREE(a) (((a) & ATB_MASK_3) == 0)
+// gc_alloc scans the ATB a 32-bit word (4 ATBs) at a time
+#define ATBS_PER_WORD (4)
+#define BLOCKS_PER_ATB_WORD (ATBS_PER_WORD * BLOCKS_PER_ATB)
+#define ATB_WORD_LOW_BITS (0x55555555)
 
 #if MICROPY_GC_SPLIT_HEAP
 #define NEXT_AREA(area) ((area)->next)
@@ -92,6 +92,15 @@
 #define ATB_HEAD_TO_MARK(area, block) do { area->gc_alloc_table_start[(block) / BLOCKS_PER_ATB] |= (AT_MARK << BLOCK_SHIFT(block)); } while (0)
 #define ATB_MARK_TO_HEAD(area, block) do { area->gc_alloc_table_start[(block) / BLOCKS_PER_ATB] &= (~(AT_TAIL << BLOCK_SHIFT(block))); } while (0)
 
+#if MICROPY_GC_INCREMENTAL
+// While a lazy sweep is pending, the live objects it hasn't reached yet still
+// have their head marked, and unmarked heads there are garbage
+#define ATB_IS_LIVE_HEAD(area, block) (ATB_GET_KIND(area, block) == AT_HEAD \
+    || (ATB_GET_KIND(area, block) == AT_MARK && (block) >= (area)->gc_sweep_block))
+#else
+#define ATB_IS_LIVE_HEAD(area, block) (ATB_GET_KIND(area, block) == AT_HEAD)
+#endif
+
 #define BLOCK_FROM_PTR(area, ptr) (((byte *)(ptr) - area->gc_pool_start) / BYTES_PER_BLOCK)
 #define PTR_FROM_BLOCK(area, block) (((block) * BYTES_PER_BLOCK + (uintptr_t)area->gc_pool_start))
 
@@ -112,6 +121,37 @@
 #define FTB_CLEAR(area, block) do { area->gc_finaliser_table_start[(block) / BLOCKS_PER_FTB] &= (~(1 << ((block) & 7))); } while (0)
 #endif
 
+#if MICROPY_GC_NO_SCAN
+// NSTB = no-scan table byte
+// if set, then the corresponding block holds no heap pointers
+
+#define BLOCKS_PER_NSTB (8)
+
+#define NSTB_GET(area, block) ((area->gc_no_scan_table_start[(block) / BLOCKS_PER_NSTB] >> ((block) & 7)) & 1)
+#define NSTB_SET(area, block) do { area->gc_no_scan_table_start[(block) / BLOCKS_PER_NSTB] |= (1 << ((block) & 7)); } while (0)
+#define NSTB_CLEAR(area, block) do { area->gc_no_scan_table_start[(block) / BLOCKS_PER_NSTB] &= (~(1 << ((block) & 7))); } while (0)
+#define BLOCK_HAS_CHILDREN(area, block) (!NSTB_GET(area, block))
+#else
+#define BLOCK_HAS_CHILDREN(area, block) (1)
+#endif
+
+#if MICROPY_GC_PROFILE
+// PRTB = profile table byte
+// 2 bits per block, for the heap profiler
+
+#define BLOCKS_PER_PRTB (4)
+
+#define PRTB_SAMPLED (1) // allocation was sampled, and is in gc_profile_samples
+#define PRTB_OBJ (2) // starts with a type pointer, set by mp_obj_malloc
+
+#define PRTB_SHIFT(block) (((block) & (BLOCKS_PER_PRTB - 1)) << 1)
+#define PRTB_GET(area, block) ((area->gc_profile_table_start[(block) / BLOCKS_PER_PRTB] >> PRTB_SHIFT(block)) & 3)
+#define PRTB_SET(area, block, bits) do { \
+        byte *prtb_ptr = &area->gc_profile_table_start[(block) / BLOCKS_PER_PRTB]; \
+        *prtb_ptr = (*prtb_ptr & ~(3 << PRTB_SHIFT(block))) | ((bits) << PRTB_SHIFT(block)); \
+} while (0)
+#endif
+
 #if MICROPY_PY_THREAD && !MICROPY_PY_THREAD_GIL
 #define GC_MUTEX_INIT() mp_thread_recursive_mutex_init(&MP_STATE_MEM(gc_mutex))
 #define GC_ENTER() mp_thread_recursive_mutex_lock(&MP_STATE_MEM(gc_mutex), 1)
@@ -133,53 +173,154 @@ static void gc_mark_subtree(size_t block);
 #endif
 static void gc_deal_with_stack_overflow(void);
 static void gc_sweep_run_finalisers(void);
-static void gc_sweep_free_blocks(void);
+static bool gc_sweep_free_blocks(size_t max_blocks);
+#if MICROPY_GC_INCREMENTAL
+static void gc_sweep_start(void);
+static void gc_pause_end(mp_uint_t start);
+#endif
+#if MICROPY_GC_ARENA
+static void gc_arena_mark(void **ptrs, size_t len);
+static void gc_arena_sweep(void);
+#endif
+
+// Load the 4 ATBs from index i as a word, with block n of the word in bits 2n
+// and 2n+1 regardless of endianness.  ATBs past the end of the table read as
+// used.
+static inline uint32_t gc_atb_load_word(const mp_state_mem_area_t *area, size_t i) {
+    const byte *atb = area->gc_alloc_table_start + i;
+    size_t len = area->gc_alloc_table_byte_len - i;
+    if (len >= ATBS_PER_WORD) {
+        return atb[0] | atb[1] << 8 | atb[2] << 16 | (uint32_t)atb[3] << 24;
+    }
+    uint32_t word = 0;
+    for (size_t n = 0; n < ATBS_PER_WORD; n++) {
+        word |= (uint32_t)(n < len ? atb[n] : 0xff) << (8 * n);
+    }
+    return word;
+}
+
+// Bit 2n of the result is set if block n of an ATB word is free
+static inline uint32_t gc_atb_word_free_mask(uint32_t word) {
+    return ~(word | word >> 1) & ATB_WORD_LOW_BITS;
+}
+
+// Returns the hint that gc_alloc starts from when looking for n_blocks, and
+// in *min_blocks the run length it is for: no free run of at least that many
+// blocks starts in an ATB before the hint.  Single blocks use
+// gc_last_free_atb_index, larger sizes a hint per power-of-two size class.
+static size_t *gc_free_hint(mp_state_mem_area_t *area, size_t n_blocks, size_t *min_blocks) {
+    #if MICROPY_GC_FREE_HINTS
+    if (n_blocks > 1) {
+        size_t class = MICROPY_GC_FREE_HINTS - 1;
+        if (n_blocks < ((size_t)2 << class)) {
+            // floor(log2(n_blocks)) - 1
+            class = 30 - mp_clz((uint32_t)n_blocks);
+        }
+        *min_blocks = (size_t)2 << class;
+        return &area->gc_free_hint_atb_index[class];
+    }
+    #else
+    (void)n_blocks;
+    #endif
+    *min_blocks = 1;
+    return &area->gc_last_free_atb_index;
+}
+
+// Move the hints back so that they are valid again after blocks from block
+// onwards are freed.
+static void gc_free_hints_update(mp_state_mem_area_t *area, size_t block) {
+    if (block / BLOCKS_PER_ATB < area->gc_last_free_atb_index) {
+        area->gc_last_free_atb_index = block / BLOCKS_PER_ATB;
+    }
+    #if MICROPY_GC_FREE_HINTS
+    for (size_t class = 0; class < MICROPY_GC_FREE_HINTS; class++) {
+        // The freed blocks may join a free run just before them, which is
+        // shorter than this class (or the hint would already be before it)
+        size_t start = block - MIN(block, ((size_t)2 << class) - 1);
+        if (start / BLOCKS_PER_ATB < area->gc_free_hint_atb_index[class]) {
+            area->gc_free_hint_atb_index[class] = start / BLOCKS_PER_ATB;
+        }
+    }
+    #endif
+}
 
 // TODO waste less memory; currently requires that all entries in alloc_table have a corresponding block in pool
 static void gc_setup_area(mp_state_mem_area_t *area, void *start, void *end) {
-    // calculate parameters for GC (T=total, A=alloc table, F=finaliser table, P=pool; all in bytes):
-    // T = A + F + P
+    // calculate parameters for GC (T=total, A=alloc table, F=finaliser table,
+    // N=no-scan table, R=profile table, P=pool; all in bytes):
+    // T = A + F + N + R + P
     //     F = A * BLOCKS_PER_ATB / BLOCKS_PER_FTB
+    //     N = A * BLOCKS_PER_ATB / BLOCKS_PER_NSTB
+    //     R = A * BLOCKS_PER_ATB / BLOCKS_PER_PRTB
     //     P = A * BLOCKS_PER_ATB * BYTES_PER_BLOCK
-    // => T = A * (1 + BLOCKS_PER_ATB / BLOCKS_PER_FTB + BLOCKS_PER_ATB * BYTES_PER_BLOCK)
-    size_t total_byte_len = (byte *)end - (byte *)start;
+    // => T = A * (1 + BLOCKS_PER_ATB / BLOCKS_PER_FTB + BLOCKS_PER_ATB / BLOCKS_PER_NSTB
+    //             + BLOCKS_PER_ATB / BLOCKS_PER_PRTB + BLOCKS_PER_ATB * BYTES_PER_BLOCK)
+    // F, N and R are each rounded up to a whole byte below, so a byte is
+    // reserved for each of them before dividing.
+    size_t total_byte_len = (byte *)end - (byte *)start - ALLOC_TABLE_GAP_BYTE;
     #if MICROPY_ENABLE_FINALISER
-    area->gc_alloc_table_byte_len = (total_byte_len - ALLOC_TABLE_GAP_BYTE)
+    total_byte_len -= 1;
+    #endif
+    #if MICROPY_GC_NO_SCAN
+    total_byte_len -= 1;
+    #endif
+    #if MICROPY_GC_PROFILE
+    total_byte_len -= 1;
+    #endif
+    area->gc_alloc_table_byte_len = total_byte_len
         * MP_BITS_PER_BYTE
         / (
             MP_BITS_PER_BYTE
+            #if MICROPY_ENABLE_FINALISER
             + MP_BITS_PER_BYTE * BLOCKS_PER_ATB / BLOCKS_PER_FTB
+            #endif
+            #if MICROPY_GC_NO_SCAN
+            + MP_BITS_PER_BYTE * BLOCKS_PER_ATB / BLOCKS_PER_NSTB
+            #endif
+            #if MICROPY_GC_PROFILE
+            + MP_BITS_PER_BYTE * BLOCKS_PER_ATB / BLOCKS_PER_PRTB
+            #endif
             + MP_BITS_PER_BYTE * BLOCKS_PER_ATB * BYTES_PER_BLOCK
             );
-    #else
-    area->gc_alloc_table_byte_len = (total_byte_len - ALLOC_TABLE_GAP_BYTE) / (1 + MP_BITS_PER_BYTE / 2 * BYTES_PER_BLOCK);
-    #endif
 
     area->gc_alloc_table_start = (byte *)start;
+    byte *tables_end = area->gc_alloc_table_start + area->gc_alloc_table_byte_len + ALLOC_TABLE_GAP_BYTE;
 
     #if MICROPY_ENABLE_FINALISER
     size_t gc_finaliser_table_byte_len = (area->gc_alloc_table_byte_len * BLOCKS_PER_ATB + BLOCKS_PER_FTB - 1) / BLOCKS_PER_FTB;
-    area->gc_finaliser_table_start = area->gc_alloc_table_start + area->gc_alloc_table_byte_len + ALLOC_TABLE_GAP_BYTE;
+    area->gc_finaliser_table_start = tables_end;
+    tables_end += gc_finaliser_table_byte_len;
+    #endif
+
+    #if MICROPY_GC_NO_SCAN
+    size_t gc_no_scan_table_byte_len = (area->gc_alloc_table_byte_len * BLOCKS_PER_ATB + BLOCKS_PER_NSTB - 1) / BLOCKS_PER_NSTB;
+    area->gc_no_scan_table_start = tables_end;
+    tables_end += gc_no_scan_table_byte_len;
+    #endif
+
+    #if MICROPY_GC_PROFILE
+    size_t gc_profile_table_byte_len = (area->gc_alloc_table_byte_len * BLOCKS_PER_ATB + BLOCKS_PER_PRTB - 1) / BLOCKS_PER_PRTB;
+    area->gc_profile_table_start = tables_end;
+    tables_end += gc_profile_table_byte_len;
     #endif
 
     size_t gc_pool_block_len = area->gc_alloc_table_byte_len * BLOCKS_PER_ATB;
     area->gc_pool_start = (byte *)end - gc_pool_block_len * BYTES_PER_BLOCK;
     area->gc_pool_end = end;
 
-    #if MICROPY_ENABLE_FINALISER
-    assert(area->gc_pool_start >= area->gc_finaliser_table_start + gc_finaliser_table_byte_len);
-    #endif
+    assert(area->gc_pool_start >= tables_end);
 
-    #if MICROPY_ENABLE_FINALISER
-    // clear ATB's and FTB's
-    memset(area->gc_alloc_table_start, 0, gc_finaliser_table_byte_len + area->gc_alloc_table_byte_len + ALLOC_TABLE_GAP_BYTE);
-    #else
-    // clear ATB's
-    memset(area->gc_alloc_table_start, 0, area->gc_alloc_table_byte_len + ALLOC_TABLE_GAP_BYTE);
-    #endif
+    // clear ATB's and the other tables
+    memset(area->gc_alloc_table_start, 0, tables_end - area->gc_alloc_table_start);
 
     area->gc_last_free_atb_index = 0;
+    #if MICROPY_GC_FREE_HINTS
+    memset(area->gc_free_hint_atb_index, 0, sizeof(area->gc_free_hint_atb_index));
+    #endif
     area->gc_last_used_block = 0;
+    #if MICROPY_GC_INCREMENTAL
+    area->gc_sweep_block = (size_t)-1;
+    #endif
 
     #if MICROPY_GC_SPLIT_HEAP
     area->next = NULL;
@@ -196,6 +337,18 @@ static void gc_setup_area(mp_state_mem_area_t *area, void *start, void *end) {
         gc_finaliser_table_byte_len,
         gc_finaliser_table_byte_len * BLOCKS_PER_FTB);
     #endif
+    #if MICROPY_GC_NO_SCAN
+    DEBUG_printf("  no-scan table at %p, length " UINT_FMT " bytes, "
+        UINT_FMT " blocks\n", area->gc_no_scan_table_start,
+        gc_no_scan_table_byte_len,
+        gc_no_scan_table_byte_len * BLOCKS_PER_NSTB);
+    #endif
+    #if MICROPY_GC_PROFILE
+    DEBUG_printf("  profile table at %p, length " UINT_FMT " bytes, "
+        UINT_FMT " blocks\n", area->gc_profile_table_start,
+        gc_profile_table_byte_len,
+        gc_profile_table_byte_len * BLOCKS_PER_PRTB);
+    #endif
     DEBUG_printf("  pool at %p, length " UINT_FMT " bytes, "
         UINT_FMT " blocks\n", area->gc_pool_start,
         gc_pool_block_len * BYTES_PER_BLOCK, gc_pool_block_len);
@@ -310,6 +463,12 @@ static bool gc_try_add_heap(size_t failed_alloc) {
         #if MICROPY_ENABLE_FINALISER
         + total_blocks / BLOCKS_PER_FTB
         #endif
+        #if MICROPY_GC_NO_SCAN
+        + total_blocks / BLOCKS_PER_NSTB
+        #endif
+        #if MICROPY_GC_PROFILE
+        + total_blocks / BLOCKS_PER_PRTB
+        #endif
         + total_blocks * BYTES_PER_BLOCK
         + ALLOC_TABLE_GAP_BYTE
         + sizeof(mp_state_mem_area_t);
@@ -414,12 +573,23 @@ void gc_collect_start(void) {
 
 static void gc_collect_start_common(void) {
     GC_ENTER();
+    #if MICROPY_GC_INCREMENTAL
+    MP_STATE_MEM(gc_pause_start) = mp_hal_ticks_us();
+    // The previous collection must be fully swept before marking again
+    gc_sweep_free_blocks((size_t)-1);
+    #endif
     assert((MP_STATE_THREAD(gc_lock_depth) & GC_COLLECT_FLAG) == 0);
     MP_STATE_THREAD(gc_lock_depth) |= GC_COLLECT_FLAG;
     MP_STATE_MEM(gc_stack_overflow) = 0;
 }
 
 void gc_collect_root(void **ptrs, size_t len) {
+    #if MICROPY_GC_ARENA
+    if (MP_STATE_MEM(gc_arena_scan)) {
+        gc_arena_mark(ptrs, len);
+        return;
+    }
+    #endif
     #if !MICROPY_GC_SPLIT_HEAP
     mp_state_mem_area_t *area = &MP_STATE_MEM(area);
     #endif
@@ -440,6 +610,9 @@ void gc_collect_root(void **ptrs, size_t len) {
         if (ATB_GET_KIND(area, block) == AT_HEAD) {
             // An unmarked head: mark it, and mark all its children
             ATB_HEAD_TO_MARK(area, block);
+            if (!BLOCK_HAS_CHILDREN(area, block)) {
+                continue;
+            }
             #if MICROPY_GC_SPLIT_HEAP
             gc_mark_subtree(area, block);
             #else
@@ -502,6 +675,10 @@ static void gc_mark_subtree(size_t block)
             // An unmarked head. Mark it, and push it on gc stack.
             TRACE_MARK(ptr_block, ptr);
             ATB_HEAD_TO_MARK(ptr_area, ptr_block);
+            if (!BLOCK_HAS_CHILDREN(ptr_area, ptr_block)) {
+                // Plain data, there's nothing in it to mark.
+                continue;
+            }
             if (sp < MICROPY_ALLOC_GC_STACK_SIZE) {
                 MP_STATE_MEM(gc_block_stack)[sp] = ptr_block;
                 #if MICROPY_GC_SPLIT_HEAP
@@ -530,21 +707,83 @@ static void gc_mark_subtree(size_t block)
 void gc_sweep_all(void) {
     gc_collect_start_common();
     gc_collect_end();
+    #if MICROPY_GC_INCREMENTAL
+    gc_sweep_finish();
+    #endif
 }
 
 void gc_collect_end(void) {
-    gc_deal_with_stack_overflow();
-    gc_sweep_run_finalisers();
-    gc_sweep_free_blocks();
+    #if MICROPY_GC_ARENA
+    if (MP_STATE_MEM(gc_arena_scan)) {
+        // Only the arena was marked, see gc_arena_exit
+        gc_arena_sweep();
+    } else
+    #endif
+    {
+        gc_deal_with_stack_overflow();
+        gc_sweep_run_finalisers();
+        #if MICROPY_GC_INCREMENTAL
+        // Freeing is left to later slices, from gc_alloc and gc_collect_step
+        gc_sweep_start();
+        #else
+        gc_sweep_free_blocks((size_t)-1);
+        #endif
+    }
     #if MICROPY_GC_SPLIT_HEAP
     MP_STATE_MEM(gc_last_free_area) = &MP_STATE_MEM(area);
     #endif
+    MP_STATE_THREAD(gc_lock_depth) &= ~GC_COLLECT_FLAG;
+    #if MICROPY_GC_INCREMENTAL
+    gc_pause_end(MP_STATE_MEM(gc_pause_start));
+    #endif
+    GC_EXIT();
+}
+
+#if MICROPY_GC_INCREMENTAL
+static void gc_pause_end(mp_uint_t start) {
+    mp_uint_t pause = mp_hal_ticks_us() - start;
+    if (pause > MP_STATE_MEM(gc_max_pause_us)) {
+        MP_STATE_MEM(gc_max_pause_us) = pause;
+    }
+}
+
+static void gc_sweep_start(void) {
+    #if MICROPY_PY_GC_COLLECT_RETVAL
+    MP_STATE_MEM(gc_collected) = 0;
+    #endif
     for (mp_state_mem_area_t *area = &MP_STATE_MEM(area); area != NULL; area = NEXT_AREA(area)) {
-        area->gc_last_free_atb_index = 0;
+        area->gc_sweep_block = 0;
     }
-    MP_STATE_THREAD(gc_lock_depth) &= ~GC_COLLECT_FLAG;
+    MP_STATE_MEM(gc_sweep_area) = &MP_STATE_MEM(area);
+}
+
+void gc_sweep_finish(void) {
+    GC_ENTER();
+    if (MP_STATE_MEM(gc_sweep_area) != NULL) {
+        mp_uint_t start = mp_hal_ticks_us();
+        gc_sweep_free_blocks((size_t)-1);
+        gc_pause_end(start);
+    }
+    GC_EXIT();
+}
+
+bool gc_collect_step(mp_uint_t budget_us) {
+    mp_uint_t start = mp_hal_ticks_us();
+    if (MP_STATE_MEM(gc_sweep_area) == NULL) {
+        // Marking can't be split up, as nothing tracks stores into objects
+        // that were already scanned, so it's done in one go
+        gc_collect();
+    }
+    GC_ENTER();
+    bool done;
+    do {
+        done = gc_sweep_free_blocks(MICROPY_GC_SWEEP_SLICE);
+    } while (!done && mp_hal_ticks_us() - start < budget_us);
+    gc_pause_end(start);
     GC_EXIT();
+    return done;
 }
+#endif
 
 static void gc_deal_with_stack_overflow(void) {
     while (MP_STATE_MEM(gc_stack_overflow)) {
@@ -555,7 +794,7 @@ static void gc_deal_with_stack_overflow(void) {
             for (size_t block = 0; block < area->gc_alloc_table_byte_len * BLOCKS_PER_ATB; block++) {
                 MICROPY_GC_HOOK_LOOP(block);
                 // trace (again) if mark bit set
-                if (ATB_GET_KIND(area, block) == AT_MARK) {
+                if (ATB_GET_KIND(area, block) == AT_MARK && BLOCK_HAS_CHILDREN(area, block)) {
                     #if MICROPY_GC_SPLIT_HEAP
                     gc_mark_subtree(area, block);
                     #else
@@ -609,29 +848,54 @@ static void gc_sweep_run_finalisers(void) {
     #endif // MICROPY_ENABLE_FINALISER
 }
 
-// Free unmarked heads and their tails
-static void gc_sweep_free_blocks(void) {
+// Free unmarked heads and their tails.  With MICROPY_GC_INCREMENTAL this
+// carries on from where the previous slice stopped and stops after about
+// max_blocks blocks, returning false if there is more to sweep.
+static bool gc_sweep_free_blocks(size_t max_blocks) {
+    #if MICROPY_GC_INCREMENTAL
+    mp_state_mem_area_t *area = MP_STATE_MEM(gc_sweep_area);
+    #else
+    (void)max_blocks;
     #if MICROPY_PY_GC_COLLECT_RETVAL
     MP_STATE_MEM(gc_collected) = 0;
     #endif
-    int free_tail = 0;
-    #if MICROPY_GC_SPLIT_HEAP_AUTO
-    mp_state_mem_area_t *prev_area = NULL;
+    mp_state_mem_area_t *area = &MP_STATE_MEM(area);
     #endif
+    int free_tail = 0;
 
-    for (mp_state_mem_area_t *area = &MP_STATE_MEM(area); area != NULL; area = NEXT_AREA(area)) {
+    for (; area != NULL; area = NEXT_AREA(area)) {
         size_t last_used_block = 0;
+        bool freed = false;
         assert(area->gc_last_used_block <= area->gc_alloc_table_byte_len * BLOCKS_PER_ATB);
 
-        for (size_t block = 0; block <= area->gc_last_used_block; block++) {
+        #if MICROPY_GC_INCREMENTAL
+        size_t block = area->gc_sweep_block;
+        #else
+        size_t block = 0;
+        #endif
+        for (; block <= area->gc_last_used_block; block++) {
             MICROPY_GC_HOOK_LOOP(block);
-            switch (ATB_GET_KIND(area, block)) {
+            byte kind = ATB_GET_KIND(area, block);
+            #if MICROPY_GC_INCREMENTAL
+            // Only stop at the start of a chain, so free_tail needn't be kept
+            if (kind != AT_TAIL && max_blocks-- == 0) {
+                area->gc_sweep_block = block;
+                MP_STATE_MEM(gc_sweep_area) = area;
+                return false;
+            }
+            #endif
+            switch (kind) {
                 case AT_HEAD:
                     free_tail = 1;
                     DEBUG_printf("gc_sweep_free_blocks(%p)\n", (void *)PTR_FROM_BLOCK(area, block));
                     #if MICROPY_PY_GC_COLLECT_RETVAL
                     MP_STATE_MEM(gc_collected)++;
                     #endif
+                    if (!freed) {
+                        // Later frees can't move the hints back any further
+                        gc_free_hints_update(area, block);
+                        freed = true;
+                    }
                     // fall through to free the head
                     MP_FALLTHROUGH
 
@@ -654,20 +918,210 @@ static void gc_sweep_free_blocks(void) {
             }
         }
 
+        #if MICROPY_GC_INCREMENTAL
+        // Earlier slices and allocations since the mark aren't accounted for
+        // in last_used_block, so look back from the end for it instead
+        area->gc_sweep_block = (size_t)-1;
+        last_used_block = area->gc_last_used_block;
+        while (last_used_block > 0 && ATB_GET_KIND(area, last_used_block) == AT_FREE) {
+            last_used_block--;
+        }
+        #endif
         area->gc_last_used_block = last_used_block;
 
         #if MICROPY_GC_SPLIT_HEAP_AUTO
         // Free any empty area, aside from the first one
-        if (last_used_block == 0 && prev_area != NULL) {
+        if (last_used_block == 0 && area != &MP_STATE_MEM(area)) {
             DEBUG_printf("gc_sweep_free_blocks free empty area %p\n", area);
+            mp_state_mem_area_t *prev_area = &MP_STATE_MEM(area);
+            while (NEXT_AREA(prev_area) != area) {
+                prev_area = NEXT_AREA(prev_area);
+            }
             NEXT_AREA(prev_area) = NEXT_AREA(area);
+            if (MP_STATE_MEM(gc_last_free_area) == area) {
+                MP_STATE_MEM(gc_last_free_area) = &MP_STATE_MEM(area);
+            }
             MP_PLAT_FREE_HEAP(area);
             area = prev_area;
         }
-        prev_area = area;
         #endif
     }
+
+    #if MICROPY_GC_INCREMENTAL
+    MP_STATE_MEM(gc_sweep_area) = NULL;
+    #endif
+    return true;
+}
+
+#if MICROPY_GC_ARENA
+MP_REGISTER_ROOT_POINTER(void *gc_arena_free);
+
+bool gc_arena_enter(size_t n_bytes) {
+    void *ptr = gc_alloc(n_bytes, GC_ALLOC_FLAG_NO_SCAN);
+    if (ptr == NULL) {
+        return false;
+    }
+    // Allocations are carved off with whatever the blocks hold, so clear out
+    // any stale heap pointers now
+    memset(ptr, 0, n_bytes);
+
+    GC_ENTER();
+    mp_state_mem_area_t *area;
+    #if MICROPY_GC_SPLIT_HEAP
+    area = gc_get_ptr_area(ptr);
+    #else
+    area = &MP_STATE_MEM(area);
+    #endif
+    size_t block = BLOCK_FROM_PTR(area, ptr);
+    MP_STATE_MEM(gc_arena_area) = area;
+    MP_STATE_MEM(gc_arena_start_block) = block;
+    MP_STATE_MEM(gc_arena_end_block) = block + (n_bytes + BYTES_PER_BLOCK - 1) / BYTES_PER_BLOCK;
+    MP_STATE_VM(gc_arena_free) = ptr;
+    GC_EXIT();
+    return true;
+}
+
+void gc_arena_exit(void) {
+    GC_ENTER();
+    if (MP_STATE_MEM(gc_arena_area) == NULL) {
+        GC_EXIT();
+        return;
+    }
+    if (MP_STATE_VM(gc_arena_free) != NULL) {
+        gc_free(MP_STATE_VM(gc_arena_free));
+        MP_STATE_VM(gc_arena_free) = NULL;
+    }
+    if (MP_STATE_THREAD(gc_lock_depth) == 0) {
+        // The port's gc_collect finds the roots as usual, but with gc_arena_scan
+        // set they only mark within the arena, and gc_collect_end then frees
+        // the rest of the arena instead of sweeping the whole heap
+        MP_STATE_MEM(gc_arena_scan) = true;
+        gc_collect();
+    }
+    // If the heap is locked the arena's contents are left for a collection
+    MP_STATE_MEM(gc_arena_area) = NULL;
+    GC_EXIT();
+}
+
+// Number of blocks in the chain with its head at block
+static size_t gc_chain_n_blocks(const mp_state_mem_area_t *area, size_t block) {
+    size_t n_blocks = 0;
+    do {
+        n_blocks += 1;
+    } while (ATB_GET_KIND(area, block + n_blocks) == AT_TAIL);
+    return n_blocks;
+}
+
+// Mark the unmarked heads in the arena that ptrs refer to, and then those in
+// the arena that they refer to, and so on.  Pointers to anywhere outside the
+// arena are ignored, so only the arena's ATBs are changed.
+static void gc_arena_mark(void **ptrs, size_t len) {
+    mp_state_mem_area_t *area = MP_STATE_MEM(gc_arena_area);
+    size_t start = MP_STATE_MEM(gc_arena_start_block);
+    uintptr_t base = PTR_FROM_BLOCK(area, start);
+    uintptr_t size = (MP_STATE_MEM(gc_arena_end_block) - start) * BYTES_PER_BLOCK;
+    size_t sp = 0;
+    for (;;) {
+        for (size_t i = 0; i < len; i++) {
+            MICROPY_GC_HOOK_LOOP(i);
+            // one compare both checks the pointer is in the arena and aligned
+            uintptr_t offset = (uintptr_t)gc_get_ptr(ptrs, i) - base;
+            if (offset >= size || (offset & (BYTES_PER_BLOCK - 1)) != 0) {
+                continue;
+            }
+            size_t block = start + offset / BYTES_PER_BLOCK;
+            if (ATB_GET_KIND(area, block) != AT_HEAD) {
+                continue;
+            }
+            ATB_HEAD_TO_MARK(area, block);
+            if (!BLOCK_HAS_CHILDREN(area, block)) {
+                continue;
+            }
+            if (sp < MICROPY_ALLOC_GC_STACK_SIZE) {
+                MP_STATE_MEM(gc_block_stack)[sp++] = block;
+            } else {
+                MP_STATE_MEM(gc_stack_overflow) = 1;
+            }
+        }
+        if (sp == 0) {
+            break;
+        }
+        size_t block = MP_STATE_MEM(gc_block_stack)[--sp];
+        ptrs = (void **)PTR_FROM_BLOCK(area, block);
+        len = gc_chain_n_blocks(area, block) * BYTES_PER_BLOCK / sizeof(void *);
+    }
+}
+
+// Called from gc_collect_end once the roots have been through gc_arena_mark.
+// Every other block in the heap is then scanned for references into the arena,
+// dead or not, since nothing tracks which objects have been written to since
+// the arena was entered.  That is a linear pass without any marking, and the
+// arena is the only part of the heap that gets swept.
+static void gc_arena_sweep(void) {
+    mp_state_mem_area_t *arena = MP_STATE_MEM(gc_arena_area);
+    size_t start = MP_STATE_MEM(gc_arena_start_block);
+    size_t end = MP_STATE_MEM(gc_arena_end_block);
+
+    for (mp_state_mem_area_t *area = &MP_STATE_MEM(area); area != NULL; area = NEXT_AREA(area)) {
+        // find the heads a word of ATBs at a time
+        for (size_t i = 0; i * BLOCKS_PER_ATB <= area->gc_last_used_block; i += ATBS_PER_WORD) {
+            MICROPY_GC_HOOK_LOOP(i);
+            uint32_t word = gc_atb_load_word(area, i);
+            uint32_t heads = word & ~(word >> 1) & ATB_WORD_LOW_BITS;
+            while (heads) {
+                size_t block = i * BLOCKS_PER_ATB + mp_ctz(heads) / 2;
+                heads &= heads - 1;
+                if (!BLOCK_HAS_CHILDREN(area, block) || (area == arena && block >= start && block < end)) {
+                    continue;
+                }
+                size_t n_blocks = gc_chain_n_blocks(area, block);
+                gc_arena_mark((void **)PTR_FROM_BLOCK(area, block), n_blocks * BYTES_PER_BLOCK / sizeof(void *));
+            }
+        }
+    }
+
+    while (MP_STATE_MEM(gc_stack_overflow)) {
+        MP_STATE_MEM(gc_stack_overflow) = 0;
+        for (size_t block = start; block < end; block++) {
+            if (ATB_GET_KIND(arena, block) == AT_MARK && BLOCK_HAS_CHILDREN(arena, block)) {
+                size_t n_blocks = gc_chain_n_blocks(arena, block);
+                gc_arena_mark((void **)PTR_FROM_BLOCK(arena, block), n_blocks * BYTES_PER_BLOCK / sizeof(void *));
+            }
+        }
+    }
+
+    // Free the unmarked heads, which may have been allocated outside the
+    // arena into blocks freed since, but they are unreachable all the same
+    bool freed = false;
+    for (size_t block = start; block < end; block++) {
+        switch (ATB_GET_KIND(arena, block)) {
+            case AT_HEAD:
+                #if MICROPY_ENABLE_FINALISER
+                if (FTB_GET(arena, block)) {
+                    // left for a full collection to run the finaliser
+                    break;
+                }
+                #endif
+                if (!freed) {
+                    gc_free_hints_update(arena, block);
+                    freed = true;
+                }
+                do {
+                    ATB_ANY_TO_FREE(arena, block);
+                    block += 1;
+                } while (ATB_GET_KIND(arena, block) == AT_TAIL);
+                block -= 1;
+                break;
+
+            case AT_MARK:
+                ATB_MARK_TO_HEAD(arena, block);
+                break;
+        }
+    }
+
+    MP_STATE_MEM(gc_arena_scan) = false;
 }
+#endif
 
 // Address sanitizer needs to know that the access to ptrs[i] must always be
 // considered OK, even if it's a load from an address that would normally be
@@ -684,6 +1138,20 @@ static void *gc_get_ptr(void **ptrs, int i) {
     return ptrs[i];
 }
 
+// The kind of a block as gc_info sees it, given whether the block before it is
+// free: unmarked chains that a pending lazy sweep has yet to reach are free.
+static inline size_t gc_info_block_kind(const mp_state_mem_area_t *area, size_t block, bool prev_free) {
+    size_t kind = ATB_GET_KIND(area, block);
+    #if MICROPY_GC_INCREMENTAL
+    if (block >= area->gc_sweep_block && (kind == AT_HEAD || (kind == AT_TAIL && prev_free))) {
+        kind = AT_FREE;
+    }
+    #else
+    (void)prev_free;
+    #endif
+    return kind;
+}
+
 void gc_info(gc_info_t *info) {
     GC_ENTER();
     info->total = 0;
@@ -696,9 +1164,9 @@ void gc_info(gc_info_t *info) {
     for (mp_state_mem_area_t *area = &MP_STATE_MEM(area); area != NULL; area = NEXT_AREA(area)) {
         bool finish = false;
         info->total += area->gc_pool_end - area->gc_pool_start;
+        size_t kind = gc_info_block_kind(area, 0, false);
         for (size_t block = 0, len = 0, len_free = 0; !finish;) {
             MICROPY_GC_HOOK_LOOP(block);
-            size_t kind = ATB_GET_KIND(area, block);
             switch (kind) {
                 case AT_FREE:
                     info->free += 1;
@@ -707,6 +1175,7 @@ void gc_info(gc_info_t *info) {
                     break;
 
                 case AT_HEAD:
+                case AT_MARK: // a live object that a lazy sweep hasn't reached
                     info->used += 1;
                     len = 1;
                     break;
@@ -715,20 +1184,16 @@ void gc_info(gc_info_t *info) {
                     info->used += 1;
                     len += 1;
                     break;
-
-                case AT_MARK:
-                    // shouldn't happen
-                    break;
             }
 
             block++;
             finish = (block == area->gc_alloc_table_byte_len * BLOCKS_PER_ATB);
             // Get next block type if possible
             if (!finish) {
-                kind = ATB_GET_KIND(area, block);
+                kind = gc_info_block_kind(area, block, kind == AT_FREE);
             }
 
-            if (finish || kind == AT_FREE || kind == AT_HEAD) {
+            if (finish || kind != AT_TAIL) {
                 if (len == 1) {
                     info->num_1block += 1;
                 } else if (len == 2) {
@@ -737,7 +1202,7 @@ void gc_info(gc_info_t *info) {
                 if (len > info->max_block) {
                     info->max_block = len;
                 }
-                if (finish || kind == AT_HEAD) {
+                if (finish || kind != AT_FREE) {
                     if (len_free > info->max_free) {
                         info->max_free = len_free;
                     }
@@ -757,6 +1222,52 @@ void gc_info(gc_info_t *info) {
     GC_EXIT();
 }
 
+#if MICROPY_GC_PROFILE
+static bool gc_profile_sample_is_live(void *ptr) {
+    #if MICROPY_GC_SPLIT_HEAP
+    mp_state_mem_area_t *area = gc_get_ptr_area(ptr);
+    if (area == NULL) {
+        // its area has been freed
+        return false;
+    }
+    #else
+    mp_state_mem_area_t *area = &MP_STATE_MEM(area);
+    #endif
+    size_t block = BLOCK_FROM_PTR(area, ptr);
+    return ATB_IS_LIVE_HEAD(area, block) && (PRTB_GET(area, block) & PRTB_SAMPLED);
+}
+
+// Add a sampled allocation to gc_profile_samples, returning false if full
+static bool gc_profile_follow(void *ptr, size_t n_bytes, size_t site) {
+    mp_gc_profile_sample_t *samples = MP_STATE_MEM(gc_profile_samples);
+    size_t n = MP_STATE_MEM(gc_profile_n_samples);
+    size_t i = 0;
+    while (i < n && samples[i].ptr != ptr) {
+        i += 1;
+    }
+    if (i == MICROPY_GC_PROFILE_SAMPLES) {
+        // Drop the ones that have been freed since
+        n = 0;
+        for (i = 0; i < MICROPY_GC_PROFILE_SAMPLES; ++i) {
+            if (gc_profile_sample_is_live(samples[i].ptr)) {
+                samples[n++] = samples[i];
+            }
+        }
+        if (n == MICROPY_GC_PROFILE_SAMPLES) {
+            return false;
+        }
+        i = n;
+    }
+    if (i == n) {
+        MP_STATE_MEM(gc_profile_n_samples) = n + 1;
+    }
+    samples[i].ptr = ptr;
+    samples[i].n_bytes = n_bytes;
+    samples[i].site = site;
+    return true;
+}
+#endif
+
 void *gc_alloc(size_t n_bytes, unsigned int alloc_flags) {
     bool has_finaliser = alloc_flags & GC_ALLOC_FLAG_HAS_FINALISER;
     size_t n_blocks = ((n_bytes + BYTES_PER_BLOCK - 1) & (~(BYTES_PER_BLOCK - 1))) / BYTES_PER_BLOCK;
@@ -774,16 +1285,63 @@ void *gc_alloc(size_t n_bytes, unsigned int alloc_flags) {
 
     GC_ENTER();
 
+    #if MICROPY_GC_INCREMENTAL
+    if (MP_STATE_MEM(gc_sweep_area) != NULL) {
+        // Spread a pending sweep over allocations
+        mp_uint_t start = mp_hal_ticks_us();
+        gc_sweep_free_blocks(MICROPY_GC_SWEEP_SLICE);
+        gc_pause_end(start);
+    }
+    #endif
+
     mp_state_mem_area_t *area;
     size_t i;
     size_t end_block;
     size_t start_block;
     size_t n_free;
+    size_t *hint;
+    size_t min_blocks;
+    size_t hint_block;
     int collected = !MP_STATE_MEM(gc_auto_collect_enabled);
     #if MICROPY_GC_SPLIT_HEAP_AUTO
     bool added = false;
     #endif
 
+    #if MICROPY_GC_ARENA
+    if (MP_STATE_VM(gc_arena_free) != NULL && !has_finaliser) {
+        // Carve the allocation off the front of the arena's unused chain.  The
+        // blocks are already a live head and tails, so setting them up below
+        // doesn't change them.
+        area = MP_STATE_MEM(gc_arena_area);
+        start_block = BLOCK_FROM_PTR(area, MP_STATE_VM(gc_arena_free));
+        end_block = start_block + n_blocks - 1;
+        if (end_block + 1 == MP_STATE_MEM(gc_arena_end_block)) {
+            MP_STATE_VM(gc_arena_free) = NULL;
+            goto carved;
+        }
+        if (end_block + 1 < MP_STATE_MEM(gc_arena_end_block)) {
+            // the rest of the chain gets a head of its own
+            size_t rest = end_block + 1;
+            ATB_ANY_TO_FREE(area, rest);
+            ATB_FREE_TO_HEAD(area, rest);
+            #if MICROPY_GC_INCREMENTAL
+            if (rest >= area->gc_sweep_block) {
+                ATB_HEAD_TO_MARK(area, rest);
+            }
+            #endif
+            #if MICROPY_GC_NO_SCAN
+            NSTB_SET(area, rest);
+            #endif
+            #if MICROPY_GC_PROFILE
+            PRTB_SET(area, rest, 0);
+            #endif
+            MP_STATE_VM(gc_arena_free) = (void *)PTR_FROM_BLOCK(area, rest);
+            goto carved;
+        }
+        // too big for what's left, so it comes from the heap as usual
+    }
+    #endif
+
     #if MICROPY_GC_ALLOC_THRESHOLD
     if (!collected && MP_STATE_MEM(gc_alloc_amount) >= MP_STATE_MEM(gc_alloc_threshold)) {
         GC_EXIT();
@@ -801,32 +1359,58 @@ void *gc_alloc(size_t n_bytes, unsigned int alloc_flags) {
         area = &MP_STATE_MEM(area);
         #endif
 
-        // look for a run of n_blocks available blocks
-        for (; area != NULL; area = NEXT_AREA(area), i = 0) {
+        // look for a run of n_blocks available blocks, a word of ATBs at a time
+        for (; area != NULL; area = NEXT_AREA(area)) {
+            hint = gc_free_hint(area, n_blocks, &min_blocks);
+            // start of the first run of at least min_blocks, for the new hint
+            hint_block = (size_t)-1;
             n_free = 0;
-            for (i = area->gc_last_free_atb_index; i < area->gc_alloc_table_byte_len; i++) {
+            for (i = *hint & ~(size_t)(ATBS_PER_WORD - 1); i < area->gc_alloc_table_byte_len; i += ATBS_PER_WORD) {
                 MICROPY_GC_HOOK_LOOP(i);
-                byte a = area->gc_alloc_table_start[i];
-                // *FORMAT-OFF*
-                if (ATB_0_IS_FREE(a)) { if (++n_free >= n_blocks) { i = i * BLOCKS_PER_ATB + 0; goto found; } } else { n_free = 0; }
-                if (ATB_1_IS_FREE(a)) { if (++n_free >= n_blocks) { i = i * BLOCKS_PER_ATB + 1; goto found; } } else { n_free = 0; }
-                if (ATB_2_IS_FREE(a)) { if (++n_free >= n_blocks) { i = i * BLOCKS_PER_ATB + 2; goto found; } } else { n_free = 0; }
-                if (ATB_3_IS_FREE(a)) { if (++n_free >= n_blocks) { i = i * BLOCKS_PER_ATB + 3; goto found; } } else { n_free = 0; }
-                // *FORMAT-ON*
+                uint32_t free_mask = gc_atb_word_free_mask(gc_atb_load_word(area, i));
+                size_t base = i * BLOCKS_PER_ATB;
+                for (size_t k = 0; k < BLOCKS_PER_ATB_WORD;) {
+                    uint32_t rest = free_mask >> (2 * k);
+                    if (rest & 1) {
+                        // a free run starts at block k, find where it ends
+                        uint32_t used = ~rest & (ATB_WORD_LOW_BITS >> (2 * k));
+                        size_t run = used ? (size_t)mp_ctz(used) / 2 : BLOCKS_PER_ATB_WORD - k;
+                        n_free += run;
+                        if (n_free >= min_blocks && hint_block == (size_t)-1) {
+                            hint_block = base + k + run - n_free;
+                        }
+                        if (n_free >= n_blocks) {
+                            i = base + k + run - 1 - (n_free - n_blocks);
+                            n_free = n_blocks;
+                            goto found;
+                        }
+                        k += run;
+                    } else {
+                        // skip to the next free block, if any
+                        n_free = 0;
+                        if (rest == 0) {
+                            break;
+                        }
+                        k += mp_ctz(rest) / 2;
+                    }
+                }
             }
 
-            // No free blocks found on this heap. Mark this heap as
-            // filled, so we won't try to find free space here again until
-            // space is freed.
-            #if MICROPY_GC_SPLIT_HEAP
-            if (n_blocks == 1) {
-                area->gc_last_free_atb_index = (i + 1) / BLOCKS_PER_ATB; // or (size_t)-1
-            }
-            #endif
+            // No run of n_blocks found on this heap.  Move the hint past the
+            // space scanned, so we won't look there again until it is freed.
+            *hint = hint_block == (size_t)-1 ? area->gc_alloc_table_byte_len : hint_block / BLOCKS_PER_ATB;
         }
 
         GC_EXIT();
         // nothing found!
+        #if MICROPY_GC_INCREMENTAL
+        if (MP_STATE_MEM(gc_sweep_area) != NULL) {
+            // There may be garbage left to free from the last collection
+            gc_sweep_finish();
+            GC_ENTER();
+            continue;
+        }
+        #endif
         if (collected) {
             #if MICROPY_GC_SPLIT_HEAP_AUTO
             if (!added && gc_try_add_heap(n_bytes)) {
@@ -848,22 +1432,31 @@ found:
     end_block = i;
     start_block = i - n_free + 1;
 
-    // Set last free ATB index to block after last block we found, for start of
-    // next scan.  To reduce fragmentation, we only do this if we were looking
-    // for a single free block, which guarantees that there are no free blocks
-    // before this one.  Also, whenever we free or shink a block we must check
-    // if this index needs adjusting (see gc_realloc and gc_free).
-    if (n_free == 1) {
-        #if MICROPY_GC_SPLIT_HEAP
+    // Update the hint for this size class, for the start of the next scan.
+    // If this run was the first one of at least min_blocks then the next one
+    // can only be after it, otherwise it's the first such run we passed.
+    // Whenever we free or shrink a block the hints are moved back as needed
+    // (see gc_free_hints_update).
+    *hint = (hint_block == start_block ? end_block + 1 : hint_block) / BLOCKS_PER_ATB;
+    #if MICROPY_GC_SPLIT_HEAP
+    if (n_blocks == 1) {
         MP_STATE_MEM(gc_last_free_area) = area;
-        #endif
-        area->gc_last_free_atb_index = (i + 1) / BLOCKS_PER_ATB;
     }
+    #endif
 
+    #if MICROPY_GC_ARENA
+carved:
+    #endif
     area->gc_last_used_block = MAX(area->gc_last_used_block, end_block);
 
     // mark first block as used head
     ATB_FREE_TO_HEAD(area, start_block);
+    #if MICROPY_GC_INCREMENTAL
+    if (start_block >= area->gc_sweep_block) {
+        // a pending sweep has yet to get here, so it must see a live object
+        ATB_HEAD_TO_MARK(area, start_block);
+    }
+    #endif
 
     // mark rest of blocks as used tail
     // TODO for a run of many blocks can make this more efficient
@@ -871,6 +1464,28 @@ found:
         ATB_FREE_TO_TAIL(area, bl);
     }
 
+    #if MICROPY_GC_NO_SCAN
+    // the NSTB is left as it was when the block was last freed, so always set it
+    if (alloc_flags & GC_ALLOC_FLAG_NO_SCAN) {
+        NSTB_SET(area, start_block);
+    } else {
+        NSTB_CLEAR(area, start_block);
+    }
+    #endif
+
+    #if MICROPY_GC_PROFILE
+    // likewise the PRTB
+    unsigned int prtb = 0;
+    if (MP_STATE_MEM(gc_profile_rate) != 0 && --MP_STATE_MEM(gc_profile_countdown) == 0) {
+        MP_STATE_MEM(gc_profile_countdown) = MP_STATE_MEM(gc_profile_rate);
+        size_t site = gc_profile_site(n_bytes);
+        if (gc_profile_follow((void *)PTR_FROM_BLOCK(area, start_block), n_bytes, site)) {
+            prtb = PRTB_SAMPLED;
+        }
+    }
+    PRTB_SET(area, start_block, prtb);
+    #endif
+
     // get pointer to first block
     // we must create this pointer before unlocking the GC so a collection can find it
     void *ret_ptr = (void *)(area->gc_pool_start + start_block * BYTES_PER_BLOCK);
@@ -948,7 +1563,7 @@ void gc_free(void *ptr) {
     #endif
 
     size_t block = BLOCK_FROM_PTR(area, ptr);
-    assert(ATB_GET_KIND(area, block) == AT_HEAD
+    assert(ATB_IS_LIVE_HEAD(area, block)
         || (ATB_GET_KIND(area, block) == AT_MARK && (MP_STATE_THREAD(gc_lock_depth) & GC_COLLECT_FLAG)));
 
     #if MICROPY_ENABLE_FINALISER
@@ -970,10 +1585,8 @@ void gc_free(void *ptr) {
     }
     #endif
 
-    // set the last_free pointer to this block if it's earlier in the heap
-    if (block / BLOCKS_PER_ATB < area->gc_last_free_atb_index) {
-        area->gc_last_free_atb_index = block / BLOCKS_PER_ATB;
-    }
+    // move the free hints back to this block if it's earlier in the heap
+    gc_free_hints_update(area, block);
 
     // free head and all of its tail blocks
     do {
@@ -1004,7 +1617,7 @@ size_t gc_nbytes(const void *ptr) {
 
     if (area) {
         size_t block = BLOCK_FROM_PTR(area, ptr);
-        if (ATB_GET_KIND(area, block) == AT_HEAD) {
+        if (ATB_IS_LIVE_HEAD(area, block)) {
             // work out number of consecutive blocks in the chain starting with this on
             size_t n_blocks = 0;
             do {
@@ -1020,6 +1633,32 @@ size_t gc_nbytes(const void *ptr) {
     return 0;
 }
 
+#if MICROPY_GC_NO_SCAN
+void gc_set_no_scan(const void *ptr) {
+    GC_ENTER();
+
+    mp_state_mem_area_t *area;
+    #if MICROPY_GC_SPLIT_HEAP
+    area = gc_get_ptr_area(ptr);
+    #else
+    if (VERIFY_PTR(ptr)) {
+        area = &MP_STATE_MEM(area);
+    } else {
+        area = NULL;
+    }
+    #endif
+
+    if (area) {
+        size_t block = BLOCK_FROM_PTR(area, ptr);
+        if (ATB_IS_LIVE_HEAD(area, block)) {
+            NSTB_SET(area, block);
+        }
+    }
+
+    GC_EXIT();
+}
+#endif
+
 void *gc_realloc(void *ptr_in, size_t n_bytes, bool allow_move) {
     // check for pure allocation
     if (ptr_in == NULL) {
@@ -1050,7 +1689,7 @@ void *gc_realloc(void *ptr_in, size_t n_bytes, bool allow_move) {
     area = &MP_STATE_MEM(area);
     #endif
     size_t block = BLOCK_FROM_PTR(area, ptr);
-    assert(ATB_GET_KIND(area, block) == AT_HEAD);
+    assert(ATB_IS_LIVE_HEAD(area, block));
 
     // compute number of new blocks that are requested
     size_t new_blocks = (n_bytes + BYTES_PER_BLOCK - 1) / BYTES_PER_BLOCK;
@@ -1101,10 +1740,8 @@ void *gc_realloc(void *ptr_in, size_t n_bytes, bool allow_move) {
         }
         #endif
 
-        // set the last_free pointer to end of this block if it's earlier in the heap
-        if ((block + new_blocks) / BLOCKS_PER_ATB < area->gc_last_free_atb_index) {
-            area->gc_last_free_atb_index = (block + new_blocks) / BLOCKS_PER_ATB;
-        }
+        // move the free hints back to the end of this block if it's earlier in the heap
+        gc_free_hints_update(area, block + new_blocks);
 
         GC_EXIT();
 
@@ -1143,10 +1780,17 @@ void *gc_realloc(void *ptr_in, size_t n_bytes, bool allow_move) {
         return ptr_in;
     }
 
+    // the new chain gets the same flags as the old one
+    unsigned int alloc_flags = 0;
     #if MICROPY_ENABLE_FINALISER
-    bool ftb_state = FTB_GET(area, block);
-    #else
-    bool ftb_state = false;
+    if (FTB_GET(area, block)) {
+        alloc_flags |= GC_ALLOC_FLAG_HAS_FINALISER;
+    }
+    #endif
+    #if MICROPY_GC_NO_SCAN
+    if (NSTB_GET(area, block)) {
+        alloc_flags |= GC_ALLOC_FLAG_NO_SCAN;
+    }
     #endif
 
     GC_EXIT();
@@ -1157,7 +1801,7 @@ void *gc_realloc(void *ptr_in, size_t n_bytes, bool allow_move) {
     }
 
     // can't resize inplace; try to find a new contiguous chain
-    void *ptr_out = gc_alloc(n_bytes, ftb_state);
+    void *ptr_out = gc_alloc(n_bytes, alloc_flags);
 
     // check that the alloc succeeded
     if (ptr_out == NULL) {
@@ -1170,6 +1814,46 @@ void *gc_realloc(void *ptr_in, size_t n_bytes, bool allow_move) {
     return ptr_out;
 }
 
+#if MICROPY_GC_PROFILE
+void gc_profile_mark_obj(const void *ptr) {
+    GC_ENTER();
+    #if MICROPY_GC_SPLIT_HEAP
+    mp_state_mem_area_t *area = gc_get_ptr_area(ptr);
+    #else
+    mp_state_mem_area_t *area = VERIFY_PTR(ptr) ? &MP_STATE_MEM(area) : NULL;
+    #endif
+    if (area) {
+        size_t block = BLOCK_FROM_PTR(area, ptr);
+        PRTB_SET(area, block, PRTB_GET(area, block) | PRTB_OBJ);
+    }
+    GC_EXIT();
+}
+
+void gc_profile_walk(gc_profile_visit_t visit, void *arg) {
+    GC_ENTER();
+    for (mp_state_mem_area_t *area = &MP_STATE_MEM(area); area != NULL; area = NEXT_AREA(area)) {
+        for (size_t block = 0; block <= area->gc_last_used_block; block++) {
+            if (!ATB_IS_LIVE_HEAD(area, block)) {
+                continue;
+            }
+            size_t n_blocks = 0;
+            do {
+                n_blocks += 1;
+            } while (ATB_GET_KIND(area, block + n_blocks) == AT_TAIL);
+            unsigned int prtb = PRTB_GET(area, block);
+            bool is_obj = prtb & PRTB_OBJ;
+            #if MICROPY_ENABLE_FINALISER
+            // these always start with a type pointer, or NULL
+            is_obj |= FTB_GET(area, block);
+            #endif
+            visit(arg, (void *)PTR_FROM_BLOCK(area, block), n_blocks * BYTES_PER_BLOCK, is_obj, prtb & PRTB_SAMPLED);
+            block += n_blocks - 1;
+        }
+    }
+    GC_EXIT();
+}
+#endif
+
 void gc_dump_info(const mp_print_t *print) {
     gc_info_t info;
     gc_info(&info);
@@ -58,13 +58,48 @@ void gc_collect_end(void);
 // Use this function to sweep the whole heap and run all finalisers
 void gc_sweep_all(void);
 
+#if MICROPY_GC_INCREMENTAL
+// Do about budget_us of collection work, starting a new collection if the last
+// one has been fully swept.  Returns true when the collection is complete.
+bool gc_collect_step(mp_uint_t budget_us);
+// Finish any pending lazy sweep.
+void gc_sweep_finish(void);
+#endif
+
+#if MICROPY_GC_ARENA
+// Reserve n_bytes of heap and carve later allocations from it, returning false
+// if there is no room.  Objects with finalisers are allocated as usual.
+bool gc_arena_enter(size_t n_bytes);
+// Stop using the arena and free what is in it that isn't referenced from the
+// roots or the rest of the heap.
+void gc_arena_exit(void);
+#endif
+
 enum {
     GC_ALLOC_FLAG_HAS_FINALISER = 1,
+    // The block holds no heap pointers, so marking doesn't look inside it
+    // (only has an effect with MICROPY_GC_NO_SCAN).
+    GC_ALLOC_FLAG_NO_SCAN = 2,
 };
 
+#if MICROPY_GC_PROFILE
+// Heap profiler support, see gcprofile.c.  The visitor is called with the GC
+// locked and must not allocate.
+struct _vstr_t;
+typedef void (*gc_profile_visit_t)(void *arg, void *ptr, size_t n_bytes, bool is_obj, bool sampled);
+void gc_profile_start(size_t rate); // rate of 0 stops sampling
+size_t gc_profile_site(size_t n_bytes);
+void gc_profile_snapshot(struct _vstr_t *vstr);
+void gc_profile_mark_obj(const void *ptr);
+void gc_profile_walk(gc_profile_visit_t visit, void *arg);
+#endif
+
 void *gc_alloc(size_t n_bytes, unsigned int alloc_flags);
 void gc_free(void *ptr); // does not call finaliser
 size_t gc_nbytes(const void *ptr);
+#if MICROPY_GC_NO_SCAN
+void gc_set_no_scan(const void *ptr); // for a live block from gc_alloc
+#endif
 void *gc_realloc(void *ptr, size_t n_bytes, bool allow_move);
 
 typedef struct _gc_info_t {
@@ -0,0 +1,235 @@
+/*
+ * This file is part of the MicroPython project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "py/bc.h"
+#include "py/builtin.h"
+#include "py/gc.h"
+#include "py/objfun.h"
+#include "py/runtime.h"
+
+#if MICROPY_GC_PROFILE
+
+// Heap profiler.  One in every MP_STATE_MEM(gc_profile_rate) allocations is
+// attributed to the line of bytecode that is running, and gc_alloc follows the
+// sampled allocations (see PRTB in gc.c) so that a snapshot can tell which of
+// them are still live.  A snapshot also counts all live objects by type.
+//
+// A snapshot is a compact binary record, rendered by tools/heapprof.py:
+//   "MPHP" version:u8 rate:uleb
+//   n_types:uleb { name:str count:uleb bytes:uleb }
+//   untyped_count:uleb untyped_bytes:uleb
+//   n_sites:uleb { file:str line:uleb n_allocs:uleb alloc_bytes:uleb live_count:uleb live_bytes:uleb }
+// where str is a uleb length followed by that many bytes.  Counts of sampled
+// allocations are not scaled by the rate.
+
+#define GC_PROFILE_VERSION (1)
+
+typedef struct _gc_profile_type_t {
+    const mp_obj_type_t *type;
+    size_t count;
+    size_t bytes;
+} gc_profile_type_t;
+
+typedef struct _gc_profile_snapshot_t {
+    gc_profile_type_t types[MICROPY_GC_PROFILE_TYPES];
+    size_t n_types;
+    size_t untyped_count;
+    size_t untyped_bytes;
+    size_t site_live_count[MICROPY_GC_PROFILE_SITES];
+    size_t site_live_bytes[MICROPY_GC_PROFILE_SITES];
+} gc_profile_snapshot_t;
+
+void gc_profile_start(size_t rate) {
+    MP_STATE_MEM(gc_profile_rate) = rate;
+    MP_STATE_MEM(gc_profile_countdown) = rate;
+    MP_STATE_MEM(gc_profile_n_sites) = 0;
+    MP_STATE_MEM(gc_profile_n_samples) = 0;
+}
+
+// Called by gc_alloc for a sampled allocation, with the GC locked.
+size_t gc_profile_site(size_t n_bytes) {
+    qstr file = MP_QSTRnull;
+    size_t line = 0;
+    const mp_code_state_t *code_state = MP_STATE_THREAD(current_code_state);
+    if (code_state != NULL) {
+        const byte *ip = code_state->fun_bc->bytecode;
+        MP_BC_PRELUDE_SIG_DECODE(ip);
+        MP_BC_PRELUDE_SIZE_DECODE(ip);
+        const byte *line_info_top = ip + n_info;
+        const byte *bytecode_start = ip + n_info + n_cell;
+        for (size_t i = 0; i < 1 + n_pos_args + n_kwonly_args; ++i) {
+            ip = mp_decode_uint_skip(ip);
+        }
+        // before the first opcode is dispatched ip still points at the prelude
+        size_t bc = code_state->ip > bytecode_start ? code_state->ip - bytecode_start : 0;
+        line = mp_bytecode_get_source_line(ip, line_info_top, bc);
+        #if MICROPY_EMIT_BYTECODE_USES_QSTR_TABLE
+        file = code_state->fun_bc->context->constants.qstr_table[0];
+        #else
+        file = code_state->fun_bc->context->constants.source_file;
+        #endif
+    }
+
+    mp_gc_profile_site_t *sites = MP_STATE_MEM(gc_profile_sites);
+    size_t n_sites = MP_STATE_MEM(gc_profile_n_sites);
+    size_t site = 0;
+    while (site < n_sites && (sites[site].file != file || sites[site].line != line)) {
+        site += 1;
+    }
+    if (site == n_sites) {
+        if (n_sites < MICROPY_GC_PROFILE_SITES) {
+            MP_STATE_MEM(gc_profile_n_sites) = n_sites + 1;
+            sites[site].n_allocs = 0;
+            sites[site].n_bytes = 0;
+        } else {
+            // Out of room: the last entry becomes a catch-all, with no file
+            site = MICROPY_GC_PROFILE_SITES - 1;
+            file = MP_QSTRnull;
+            line = 0;
+        }
+        sites[site].file = file;
+        sites[site].line = line;
+    }
+    sites[site].n_allocs += 1;
+    sites[site].n_bytes += n_bytes;
+    return site;
+}
+
+static void gc_profile_count_typed(void *arg, void *ptr, size_t n_bytes, bool is_obj, bool sampled) {
+    gc_profile_snapshot_t *s = arg;
+    if (ptr == s) {
+        return;
+    }
+    if (sampled) {
+        const mp_gc_profile_sample_t *samples = MP_STATE_MEM(gc_profile_samples);
+        for (size_t i = 0; i < MP_STATE_MEM(gc_profile_n_samples); ++i) {
+            if (samples[i].ptr == ptr) {
+                s->site_live_count[samples[i].site] += 1;
+                s->site_live_bytes[samples[i].site] += samples[i].n_bytes;
+                break;
+            }
+        }
+    }
+    const mp_obj_type_t *type = is_obj ? ((mp_obj_base_t *)ptr)->type : NULL;
+    if (type == NULL) {
+        return;
+    }
+    size_t i = 0;
+    while (i < s->n_types && s->types[i].type != type) {
+        i += 1;
+    }
+    if (i == s->n_types) {
+        if (i == MICROPY_GC_PROFILE_TYPES) {
+            // no room for it, so it's counted as untyped
+            s->untyped_count += 1;
+            s->untyped_bytes += n_bytes;
+            return;
+        }
+        s->types[i].type = type;
+        s->n_types += 1;
+    }
+    s->types[i].count += 1;
+    s->types[i].bytes += n_bytes;
+}
+
+// Objects made without mp_obj_malloc aren't marked as such, but if they start
+// with a pointer to a type that is already known (from marked objects, or a
+// builtin) then they're of that type.  Anything else is counted as untyped,
+// without looking at it any further.
+static void gc_profile_count_untyped(void *arg, void *ptr, size_t n_bytes, bool is_obj, bool sampled) {
+    (void)sampled;
+    gc_profile_snapshot_t *s = arg;
+    if (is_obj || ptr == s) {
+        return;
+    }
+    const void *first = *(const void **)ptr;
+    for (size_t i = 0; i < s->n_types; ++i) {
+        if (s->types[i].type == first) {
+            s->types[i].count += 1;
+            s->types[i].bytes += n_bytes;
+            return;
+        }
+    }
+    s->untyped_count += 1;
+    s->untyped_bytes += n_bytes;
+}
+
+void gc_profile_snapshot(vstr_t *vstr) {
+    // Only count what's live
+    gc_collect();
+    #if MICROPY_GC_INCREMENTAL
+    gc_sweep_finish();
+    #endif
+
+    gc_profile_snapshot_t *s = m_new0(gc_profile_snapshot_t, 1);
+    gc_profile_walk(gc_profile_count_typed, s);
+    const mp_map_t *builtins = &mp_module_builtins_globals.map;
+    for (size_t i = 0; i < builtins->alloc && s->n_types < MICROPY_GC_PROFILE_TYPES; ++i) {
+        mp_obj_t value = builtins->table[i].value;
+        if (mp_map_slot_is_filled(builtins, i) && mp_obj_is_type(value, &mp_type_type)) {
+            const mp_obj_type_t *type = MP_OBJ_TO_PTR(value);
+            size_t j = 0;
+            while (j < s->n_types && s->types[j].type != type) {
+                j += 1;
+            }
+            if (j == s->n_types) {
+                s->types[s->n_types++].type = type;
+            }
+        }
+    }
+    gc_profile_walk(gc_profile_count_untyped, s);
+
+    vstr_add_str(vstr, "MPHP");
+    vstr_add_byte(vstr, GC_PROFILE_VERSION);
+    vstr_add_uleb(vstr, MP_STATE_MEM(gc_profile_rate));
+    size_t n_types = 0;
+    for (size_t i = 0; i < s->n_types; ++i) {
+        n_types += s->types[i].count != 0;
+    }
+    vstr_add_uleb(vstr, n_types);
+    for (size_t i = 0; i < s->n_types; ++i) {
+        if (s->types[i].count == 0) {
+            continue;
+        }
+        vstr_add_uleb_str(vstr, qstr_str(s->types[i].type->name), qstr_len(s->types[i].type->name));
+        vstr_add_uleb(vstr, s->types[i].count);
+        vstr_add_uleb(vstr, s->types[i].bytes);
+    }
+    vstr_add_uleb(vstr, s->untyped_count);
+    vstr_add_uleb(vstr, s->untyped_bytes);
+    const mp_gc_profile_site_t *sites = MP_STATE_MEM(gc_profile_sites);
+    vstr_add_uleb(vstr, MP_STATE_MEM(gc_profile_n_sites));
+    for (size_t i = 0; i < MP_STATE_MEM(gc_profile_n_sites); ++i) {
+        vstr_add_uleb_str(vstr, qstr_str(sites[i].file), qstr_len(sites[i].file));
+        vstr_add_uleb(vstr, sites[i].line);
+        vstr_add_uleb(vstr, sites[i].n_allocs);
+        vstr_add_uleb(vstr, sites[i].n_bytes);
+        vstr_add_uleb(vstr, s->site_live_count[i]);
+        vstr_add_uleb(vstr, s->site_live_bytes[i]);
+    }
+
+    m_del(gc_profile_snapshot_t, s, 1);
+}
+
+#endif // MICROPY_GC_PROFILE
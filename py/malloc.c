@@ -58,6 +58,12 @@
 #undef realloc
 #define malloc(b) gc_alloc((b), false)
 #define malloc_with_finaliser(b) gc_alloc((b), true)
+#define malloc_no_scan(b) gc_alloc((b), GC_ALLOC_FLAG_NO_SCAN)
+#if MICROPY_GC_NO_SCAN
+#define set_no_scan(ptr) gc_set_no_scan(ptr)
+#else
+#define set_no_scan(ptr) (void)(ptr)
+#endif
 #define free gc_free
 #define realloc(ptr, n) gc_realloc(ptr, n, true)
 #define realloc_ext(ptr, n, mv) gc_realloc(ptr, n, mv)
@@ -65,6 +71,9 @@
 
 // GC is disabled.  Use system malloc/realloc/free.
 
+#define malloc_no_scan(b) malloc(b)
+#define set_no_scan(ptr) (void)(ptr)
+
 #if MICROPY_ENABLE_FINALISER
 #error MICROPY_ENABLE_FINALISER requires MICROPY_ENABLE_GC
 #endif
@@ -123,6 +132,27 @@ void *m_malloc_with_finaliser(size_t num_bytes) {
 }
 #endif
 
+// For memory that will only ever hold plain data, never pointers to the heap.
+void *m_malloc_no_scan(size_t num_bytes) {
+    void *ptr = malloc_no_scan(num_bytes);
+    if (ptr == NULL && num_bytes != 0) {
+        m_malloc_fail(num_bytes);
+    }
+    #if MICROPY_MEM_STATS
+    MP_STATE_MEM(total_bytes_allocated) += num_bytes;
+    MP_STATE_MEM(current_bytes_allocated) += num_bytes;
+    UPDATE_PEAK();
+    #endif
+    DEBUG_printf("malloc %d : %p\n", num_bytes, ptr);
+    return ptr;
+}
+
+// For memory from m_malloc that holds only plain data from now on, eg a vstr
+// buffer that becomes the data of a bytes object.
+void m_set_no_scan(void *ptr) {
+    set_no_scan(ptr);
+}
+
 void *m_malloc0(size_t num_bytes) {
     void *ptr = m_malloc(num_bytes);
     // If this config is set then the GC clears all memory, so we don't need to.
@@ -98,6 +98,7 @@ void mp_map_init(mp_map_t *map, size_t n) {
     map->all_keys_are_qstrs = 1;
     map->is_fixed = 0;
     map->is_ordered = 0;
+    map->is_perfect = 0;
 }
 
 void mp_map_init_fixed_table(mp_map_t *map, size_t n, const mp_obj_t *table) {
@@ -106,6 +107,7 @@ void mp_map_init_fixed_table(mp_map_t *map, size_t n, const mp_obj_t *table) {
     map->all_keys_are_qstrs = 1;
     map->is_fixed = 1;
     map->is_ordered = 1;
+    map->is_perfect = 0;
     map->table = (mp_map_elem_t *)table;
 }
 
@@ -125,6 +127,7 @@ void mp_map_clear(mp_map_t *map) {
     map->used = 0;
     map->all_keys_are_qstrs = 1;
     map->is_fixed = 0;
+    map->is_perfect = 0;
     map->table = NULL;
 }
 
@@ -250,6 +253,18 @@ mp_map_elem_t *MICROPY_WRAP_MP_MAP_LOOKUP(mp_map_lookup)(mp_map_t * map, mp_obj_
     }
 
     size_t pos = hash % map->alloc;
+
+    if (map->is_perfect) {
+        // Table was laid out at build time with no collisions (see tools/cc1),
+        // so the key is either in its home slot or not in the table at all.
+        mp_map_elem_t *slot = &map->table[pos];
+        if (slot->key == index || (!compare_only_ptrs && slot->key != MP_OBJ_NULL && mp_obj_equal(slot->key, index))) {
+            MAP_CACHE_SET(index, pos);
+            return slot;
+        }
+        return NULL;
+    }
+
     size_t start_pos = pos;
     mp_map_elem_t *avail_slot = NULL;
     for (;;) {
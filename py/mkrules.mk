@@ -46,6 +46,15 @@ QSTR_GEN_CFLAGS += $(QSTR_GEN_FLAGS)
 QSTR_GEN_CXXFLAGS := $(CXXFLAGS)
 QSTR_GEN_CXXFLAGS += $(QSTR_GEN_FLAGS)
 
+# Optionally lay out ROM dicts (module globals, type locals) as hash tables at
+# build time, using tools/cc1 between the preprocessor and compiler (gcc only).
+MICROPY_ROM_DICT_HASH ?= 0
+
+ifeq ($(MICROPY_ROM_DICT_HASH),1)
+CFLAGS += -no-integrated-cpp -B$(TOP)/tools
+export MICROPY_CC1 := $(shell $(CC) -print-prog-name=cc1)
+endif
+
 # This file expects that OBJ contains a list of all of the object files.
 # The directory portion of each object file is used to locate the source
 # and should not contain any ..'s but rather be relative to the top of the
@@ -24,13 +24,585 @@
  * THE SOFTWARE.
  */
 
+#include <stdint.h>
+#include <string.h>
+
+#include "py/binary.h"
 #include "py/builtin.h"
+#include "py/objint.h"
+#include "py/runtime.h"
 
 #if MICROPY_PY_ARRAY
 
+#if MICROPY_PY_ARRAY_BULK
+
+// Bulk numeric operations on arrays, and on memoryviews and other buffers with a
+// numeric typecode.  Each operation is a plain loop over a C array of the element
+// type, so the compiler can unroll and vectorise it.  Integer arithmetic wraps
+// around, the same as storing an out-of-range value to an array element does.
+
+enum {
+    BULK_I8, BULK_U8, BULK_I16, BULK_U16, BULK_I32, BULK_U32, BULK_I64, BULK_U64,
+    #if MICROPY_PY_BUILTINS_FLOAT
+    BULK_F32, BULK_F64,
+    #endif
+};
+
+#define BULK_INT_KIND(size, is_unsigned) \
+    (((size) == 1 ? BULK_I8 : (size) == 2 ? BULK_I16 : (size) == 4 ? BULK_I32 : BULK_I64) + (is_unsigned))
+#define BULK_IS_SIGNED(kind) (((kind) & 1) == 0)
+#if MICROPY_PY_BUILTINS_FLOAT
+#define BULK_IS_FLOAT(kind) ((kind) >= BULK_F32)
+#else
+#define BULK_IS_FLOAT(kind) (false)
+#endif
+
+static const uint8_t bulk_size[] = {
+    1, 1, 2, 2, 4, 4, 8, 8,
+    #if MICROPY_PY_BUILTINS_FLOAT
+    4, 8,
+    #endif
+};
+
+static const struct {
+    long long min;
+    unsigned long long max;
+} bulk_int_range[] = {
+    { INT8_MIN, INT8_MAX }, { 0, UINT8_MAX },
+    { INT16_MIN, INT16_MAX }, { 0, UINT16_MAX },
+    { INT32_MIN, INT32_MAX }, { 0, UINT32_MAX },
+    { INT64_MIN, INT64_MAX }, { 0, UINT64_MAX },
+};
+
+// For each integer kind: element type, type that sums and products are formed in,
+// and unsigned type that elementwise arithmetic is done in so that it wraps.
+#define BULK_FOR_EACH_INT(X) \
+    X(I8, int8_t, int64_t, uint32_t) \
+    X(U8, uint8_t, uint64_t, uint32_t) \
+    X(I16, int16_t, int64_t, uint32_t) \
+    X(U16, uint16_t, uint64_t, uint32_t) \
+    X(I32, int32_t, int64_t, uint32_t) \
+    X(U32, uint32_t, uint64_t, uint32_t) \
+    X(I64, int64_t, uint64_t, uint64_t) \
+    X(U64, uint64_t, uint64_t, uint64_t)
+
+#define BULK_FOR_EACH_FLOAT(X) \
+    X(F32, float) \
+    X(F64, double)
+
+// Sums are accumulated modulo 2**64 and then taken as signed or unsigned, which is
+// exact unless a 64-bit sum overflows.
+#define BULK_INT_KERNELS(K, T, WIDE, WRAP) \
+    static uint64_t bulk_sum_##K(const T *a, size_t n) { \
+        uint64_t acc = 0; \
+        for (size_t i = 0; i < n; ++i) { \
+            acc += (uint64_t)(WIDE)a[i]; \
+        } \
+        return acc; \
+    } \
+    static uint64_t bulk_dot_##K(const T *a, const T *b, size_t n) { \
+        uint64_t acc = 0; \
+        for (size_t i = 0; i < n; ++i) { \
+            acc += (uint64_t)((WIDE)a[i] * (WIDE)b[i]); \
+        } \
+        return acc; \
+    } \
+    static void bulk_add_##K(T *d, const T *s, size_t n) { \
+        for (size_t i = 0; i < n; ++i) { \
+            d[i] = (T)((WRAP)d[i] + (WRAP)s[i]); \
+        } \
+    } \
+    static void bulk_mul_##K(T *d, const T *s, size_t n) { \
+        for (size_t i = 0; i < n; ++i) { \
+            d[i] = (T)((WRAP)d[i] * (WRAP)s[i]); \
+        } \
+    } \
+    static void bulk_add_scalar_##K(T *d, uint64_t k, size_t n) { \
+        WRAP kw = (WRAP)k; \
+        for (size_t i = 0; i < n; ++i) { \
+            d[i] = (T)((WRAP)d[i] + kw); \
+        } \
+    } \
+    static void bulk_mul_scalar_##K(T *d, uint64_t k, size_t n) { \
+        WRAP kw = (WRAP)k; \
+        for (size_t i = 0; i < n; ++i) { \
+            d[i] = (T)((WRAP)d[i] * kw); \
+        } \
+    } \
+    static void bulk_clip_##K(T *d, uint64_t lo_in, uint64_t hi_in, size_t n) { \
+        T lo = (T)lo_in, hi = (T)hi_in; \
+        for (size_t i = 0; i < n; ++i) { \
+            T x = d[i]; \
+            d[i] = x < lo ? lo : x > hi ? hi : x; \
+        } \
+    } \
+    static size_t bulk_argmax_##K(const T *a, size_t n, bool is_max) { \
+        size_t best = 0; \
+        for (size_t i = 1; i < n; ++i) { \
+            if (is_max ? a[i] > a[best] : a[i] < a[best]) { \
+                best = i; \
+            } \
+        } \
+        return best; \
+    }
+
+BULK_FOR_EACH_INT(BULK_INT_KERNELS)
+
+#if MICROPY_PY_BUILTINS_FLOAT
+
+// Sums of floats are formed in four independent lanes, which keeps the FPU pipeline
+// busy and lets the compiler vectorise them without reassociating the arithmetic.
+#define BULK_FLOAT_KERNELS(K, T) \
+    static T bulk_sum_##K(const T *a, size_t n) { \
+        T s0 = 0, s1 = 0, s2 = 0, s3 = 0; \
+        size_t i = 0; \
+        for (; i + 4 <= n; i += 4) { \
+            s0 += a[i]; \
+            s1 += a[i + 1]; \
+            s2 += a[i + 2]; \
+            s3 += a[i + 3]; \
+        } \
+        for (; i < n; ++i) { \
+            s0 += a[i]; \
+        } \
+        return (s0 + s1) + (s2 + s3); \
+    } \
+    static T bulk_dot_##K(const T *a, const T *b, size_t n) { \
+        T s0 = 0, s1 = 0, s2 = 0, s3 = 0; \
+        size_t i = 0; \
+        for (; i + 4 <= n; i += 4) { \
+            s0 += a[i] * b[i]; \
+            s1 += a[i + 1] * b[i + 1]; \
+            s2 += a[i + 2] * b[i + 2]; \
+            s3 += a[i + 3] * b[i + 3]; \
+        } \
+        for (; i < n; ++i) { \
+            s0 += a[i] * b[i]; \
+        } \
+        return (s0 + s1) + (s2 + s3); \
+    } \
+    static void bulk_add_##K(T *d, const T *s, size_t n) { \
+        for (size_t i = 0; i < n; ++i) { \
+            d[i] += s[i]; \
+        } \
+    } \
+    static void bulk_mul_##K(T *d, const T *s, size_t n) { \
+        for (size_t i = 0; i < n; ++i) { \
+            d[i] *= s[i]; \
+        } \
+    } \
+    static void bulk_add_scalar_##K(T *d, T k, size_t n) { \
+        for (size_t i = 0; i < n; ++i) { \
+            d[i] += k; \
+        } \
+    } \
+    static void bulk_mul_scalar_##K(T *d, T k, size_t n) { \
+        for (size_t i = 0; i < n; ++i) { \
+            d[i] *= k; \
+        } \
+    } \
+    static void bulk_clip_##K(T *d, T lo, T hi, size_t n) { \
+        for (size_t i = 0; i < n; ++i) { \
+            T x = d[i]; \
+            d[i] = x < lo ? lo : x > hi ? hi : x; \
+        } \
+    } \
+    static size_t bulk_argmax_##K(const T *a, size_t n, bool is_max) { \
+        size_t best = 0; \
+        for (size_t i = 1; i < n; ++i) { \
+            if (is_max ? a[i] > a[best] : a[i] < a[best]) { \
+                best = i; \
+            } \
+        } \
+        return best; \
+    }
+
+BULK_FOR_EACH_FLOAT(BULK_FLOAT_KERNELS)
+
+#endif
+
+typedef struct _bulk_buf_t {
+    void *items;
+    size_t len;
+    size_t kind;
+} bulk_buf_t;
+
+static void bulk_get_buf(mp_obj_t obj, bulk_buf_t *b, mp_uint_t flags) {
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(obj, &bufinfo, flags);
+    switch (bufinfo.typecode) {
+        case 'b':
+            b->kind = BULK_I8;
+            break;
+        case 'B':
+        case BYTEARRAY_TYPECODE:
+            b->kind = BULK_U8;
+            break;
+        case 'h':
+            b->kind = BULK_I16;
+            break;
+        case 'H':
+            b->kind = BULK_U16;
+            break;
+        case 'i':
+        case 'I':
+            b->kind = BULK_INT_KIND(sizeof(int), bufinfo.typecode == 'I');
+            break;
+        case 'l':
+        case 'L':
+            b->kind = BULK_INT_KIND(sizeof(long), bufinfo.typecode == 'L');
+            break;
+        #if MICROPY_LONGINT_IMPL != MICROPY_LONGINT_IMPL_NONE
+        case 'q':
+        case 'Q':
+            b->kind = BULK_INT_KIND(sizeof(long long), bufinfo.typecode == 'Q');
+            break;
+        #endif
+        #if MICROPY_PY_BUILTINS_FLOAT
+        case 'f':
+            b->kind = BULK_F32;
+            break;
+        case 'd':
+            b->kind = BULK_F64;
+            break;
+        #endif
+        default:
+            mp_raise_ValueError(MP_ERROR_TEXT("bad typecode"));
+    }
+    b->items = bufinfo.buf;
+    b->len = bufinfo.len / bulk_size[b->kind];
+}
+
+static void bulk_get_buf_pair(mp_obj_t a_in, mp_obj_t b_in, bulk_buf_t *a, bulk_buf_t *b, mp_uint_t flags) {
+    bulk_get_buf(a_in, a, flags);
+    bulk_get_buf(b_in, b, MP_BUFFER_READ);
+    if (a->kind != b->kind) {
+        mp_raise_ValueError(MP_ERROR_TEXT("bad typecode"));
+    }
+    if (a->len != b->len) {
+        mp_raise_ValueError(MP_ERROR_TEXT("lengths differ"));
+    }
+}
+
+// Wrap up the result of a reduction as an object.
+#define BULK_INT_RESULT(K, T, WIDE, WRAP) \
+    static mp_obj_t bulk_result_##K(uint64_t value) { \
+        return BULK_IS_SIGNED(BULK_##K) ? mp_obj_new_int_from_ll((long long)value) : mp_obj_new_int_from_ull(value); \
+    }
+BULK_FOR_EACH_INT(BULK_INT_RESULT)
+
+#if MICROPY_PY_BUILTINS_FLOAT
+#define BULK_FLOAT_RESULT(K, T) \
+    static mp_obj_t bulk_result_##K(T value) { \
+        return mp_obj_new_float((mp_float_t)value); \
+    }
+BULK_FOR_EACH_FLOAT(BULK_FLOAT_RESULT)
+#endif
+
+// Get an integer element, sign extended to 64 bits.
+static uint64_t bulk_load_int(size_t kind, const void *items, size_t i) {
+    switch (kind) {
+        #define BULK_LOAD(K, T, WIDE, WRAP) \
+    case BULK_##K: \
+        return (uint64_t)(WIDE)((const T *)items)[i];
+        BULK_FOR_EACH_INT(BULK_LOAD)
+        #undef BULK_LOAD
+    }
+    MP_UNREACHABLE
+}
+
+static void bulk_store_int(size_t kind, void *items, size_t i, uint64_t value) {
+    switch (kind) {
+        #define BULK_STORE(K, T, WIDE, WRAP) \
+    case BULK_##K: \
+        ((T *)items)[i] = (T)value; \
+        return;
+        BULK_FOR_EACH_INT(BULK_STORE)
+        #undef BULK_STORE
+    }
+    MP_UNREACHABLE
+}
+
+#if MICROPY_PY_BUILTINS_FLOAT
+static mp_float_t bulk_load_float(size_t kind, const void *items, size_t i) {
+    if (kind == BULK_F32) {
+        return (mp_float_t)((const float *)items)[i];
+    } else {
+        return (mp_float_t)((const double *)items)[i];
+    }
+}
+
+static void bulk_store_float(size_t kind, void *items, size_t i, mp_float_t value) {
+    if (kind == BULK_F32) {
+        ((float *)items)[i] = (float)value;
+    } else {
+        ((double *)items)[i] = (double)value;
+    }
+}
+#endif
+
+// Get an int argument as 64 bits, wrapping around if it's bigger.
+static uint64_t bulk_get_int(mp_obj_t obj) {
+    #if MICROPY_LONGINT_IMPL != MICROPY_LONGINT_IMPL_NONE
+    if (mp_obj_is_exact_type(obj, &mp_type_int)) {
+        uint64_t value;
+        mp_obj_int_to_bytes_impl(obj, MP_ENDIANNESS_BIG, sizeof(value), (byte *)&value);
+        return value;
+    }
+    #endif
+    return (uint64_t)(int64_t)mp_obj_get_int(obj);
+}
+
+// Get an int argument, saturated to the range of the given integer kind.
+static uint64_t bulk_get_int_saturated(mp_obj_t obj, size_t kind) {
+    mp_int_t value = mp_obj_get_int(obj);
+    if (value < 0) {
+        return (uint64_t)(value < bulk_int_range[kind].min ? bulk_int_range[kind].min : value);
+    } else {
+        return (mp_uint_t)value > bulk_int_range[kind].max ? bulk_int_range[kind].max : (uint64_t)value;
+    }
+}
+
+// Run the kernel given by BULK_CALL(K, T) for the kind of element.
+#define BULK_INT_CASE(K, T, WIDE, WRAP) \
+    case BULK_##K: \
+        BULK_CALL(K, T); \
+        break;
+#if MICROPY_PY_BUILTINS_FLOAT
+#define BULK_FLOAT_CASE(K, T) \
+    case BULK_##K: \
+        BULK_CALL(K, T); \
+        break;
+#define BULK_DISPATCH(kind) \
+    switch (kind) { \
+        BULK_FOR_EACH_INT(BULK_INT_CASE) \
+        BULK_FOR_EACH_FLOAT(BULK_FLOAT_CASE) \
+    }
+#else
+#define BULK_DISPATCH(kind) \
+    switch (kind) { \
+        BULK_FOR_EACH_INT(BULK_INT_CASE) \
+    }
+#endif
+
+static mp_obj_t array_bulk_sum(mp_obj_t a_in) {
+    bulk_buf_t a;
+    bulk_get_buf(a_in, &a, MP_BUFFER_READ);
+    mp_obj_t result = MP_OBJ_NULL;
+    #define BULK_CALL(K, T) result = bulk_result_##K(bulk_sum_##K(a.items, a.len))
+    BULK_DISPATCH(a.kind);
+    #undef BULK_CALL
+    return result;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(array_bulk_sum_obj, array_bulk_sum);
+
+static mp_obj_t array_bulk_dot(mp_obj_t a_in, mp_obj_t b_in) {
+    bulk_buf_t a, b;
+    bulk_get_buf_pair(a_in, b_in, &a, &b, MP_BUFFER_READ);
+    mp_obj_t result = MP_OBJ_NULL;
+    #define BULK_CALL(K, T) result = bulk_result_##K(bulk_dot_##K(a.items, b.items, a.len))
+    BULK_DISPATCH(a.kind);
+    #undef BULK_CALL
+    return result;
+}
+static MP_DEFINE_CONST_FUN_OBJ_2(array_bulk_dot_obj, array_bulk_dot);
+
+// Elementwise dest op= other, where other is an array of the same kind or a number.
+static mp_obj_t array_bulk_binop(mp_obj_t dest_in, mp_obj_t other_in, bool is_mul) {
+    bulk_buf_t d, s;
+    if (mp_obj_is_int(other_in) || mp_obj_is_float(other_in)) {
+        bulk_get_buf(dest_in, &d, MP_BUFFER_WRITE);
+        #if MICROPY_PY_BUILTINS_FLOAT
+        if (BULK_IS_FLOAT(d.kind)) {
+            mp_float_t k = mp_obj_get_float(other_in);
+            #define BULK_CALL(K, T) \
+    if (is_mul) { \
+        bulk_mul_scalar_##K(d.items, (T)k, d.len); \
+    } else { \
+        bulk_add_scalar_##K(d.items, (T)k, d.len); \
+    }
+            switch (d.kind) {
+                BULK_FOR_EACH_FLOAT(BULK_FLOAT_CASE)
+            }
+            #undef BULK_CALL
+            return mp_const_none;
+        }
+        #endif
+        uint64_t k = bulk_get_int(other_in);
+        #define BULK_CALL(K, T) \
+    if (is_mul) { \
+        bulk_mul_scalar_##K(d.items, k, d.len); \
+    } else { \
+        bulk_add_scalar_##K(d.items, k, d.len); \
+    }
+        switch (d.kind) {
+            BULK_FOR_EACH_INT(BULK_INT_CASE)
+        }
+        #undef BULK_CALL
+    } else {
+        bulk_get_buf_pair(dest_in, other_in, &d, &s, MP_BUFFER_WRITE);
+        #define BULK_CALL(K, T) \
+    if (is_mul) { \
+        bulk_mul_##K(d.items, s.items, d.len); \
+    } else { \
+        bulk_add_##K(d.items, s.items, d.len); \
+    }
+        BULK_DISPATCH(d.kind);
+        #undef BULK_CALL
+    }
+    return mp_const_none;
+}
+
+static mp_obj_t array_bulk_add(mp_obj_t dest_in, mp_obj_t other_in) {
+    return array_bulk_binop(dest_in, other_in, false);
+}
+static MP_DEFINE_CONST_FUN_OBJ_2(array_bulk_add_obj, array_bulk_add);
+
+static mp_obj_t array_bulk_mul(mp_obj_t dest_in, mp_obj_t other_in) {
+    return array_bulk_binop(dest_in, other_in, true);
+}
+static MP_DEFINE_CONST_FUN_OBJ_2(array_bulk_mul_obj, array_bulk_mul);
+
+static mp_obj_t array_bulk_clip(mp_obj_t dest_in, mp_obj_t lo_in, mp_obj_t hi_in) {
+    bulk_buf_t d;
+    bulk_get_buf(dest_in, &d, MP_BUFFER_WRITE);
+    #if MICROPY_PY_BUILTINS_FLOAT
+    if (BULK_IS_FLOAT(d.kind)) {
+        mp_float_t lo = mp_obj_get_float(lo_in);
+        mp_float_t hi = mp_obj_get_float(hi_in);
+        #define BULK_CALL(K, T) bulk_clip_##K(d.items, (T)lo, (T)hi, d.len)
+        switch (d.kind) {
+            BULK_FOR_EACH_FLOAT(BULK_FLOAT_CASE)
+        }
+        #undef BULK_CALL
+        return mp_const_none;
+    }
+    #endif
+    uint64_t lo = bulk_get_int_saturated(lo_in, d.kind);
+    uint64_t hi = bulk_get_int_saturated(hi_in, d.kind);
+    #define BULK_CALL(K, T) bulk_clip_##K(d.items, lo, hi, d.len)
+    switch (d.kind) {
+        BULK_FOR_EACH_INT(BULK_INT_CASE)
+    }
+    #undef BULK_CALL
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_3(array_bulk_clip_obj, array_bulk_clip);
+
+static size_t array_bulk_argmax_helper(mp_obj_t a_in, bulk_buf_t *a, bool is_max) {
+    bulk_get_buf(a_in, a, MP_BUFFER_READ);
+    if (a->len == 0) {
+        mp_raise_ValueError(MP_ERROR_TEXT("arg is an empty sequence"));
+    }
+    size_t index = 0;
+    #define BULK_CALL(K, T) index = bulk_argmax_##K(a->items, a->len, is_max)
+    BULK_DISPATCH(a->kind);
+    #undef BULK_CALL
+    return index;
+}
+
+static mp_obj_t array_bulk_minmax(mp_obj_t a_in, bool is_max) {
+    bulk_buf_t a;
+    size_t index = array_bulk_argmax_helper(a_in, &a, is_max);
+    #if MICROPY_PY_BUILTINS_FLOAT
+    if (BULK_IS_FLOAT(a.kind)) {
+        return mp_obj_new_float(bulk_load_float(a.kind, a.items, index));
+    }
+    #endif
+    uint64_t value = bulk_load_int(a.kind, a.items, index);
+    return BULK_IS_SIGNED(a.kind) ? mp_obj_new_int_from_ll((long long)value) : mp_obj_new_int_from_ull(value);
+}
+
+static mp_obj_t array_bulk_min(mp_obj_t a_in) {
+    return array_bulk_minmax(a_in, false);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(array_bulk_min_obj, array_bulk_min);
+
+static mp_obj_t array_bulk_max(mp_obj_t a_in) {
+    return array_bulk_minmax(a_in, true);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(array_bulk_max_obj, array_bulk_max);
+
+static mp_obj_t array_bulk_argmin(mp_obj_t a_in) {
+    bulk_buf_t a;
+    return MP_OBJ_NEW_SMALL_INT(array_bulk_argmax_helper(a_in, &a, false));
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(array_bulk_argmin_obj, array_bulk_argmin);
+
+static mp_obj_t array_bulk_argmax(mp_obj_t a_in) {
+    bulk_buf_t a;
+    return MP_OBJ_NEW_SMALL_INT(array_bulk_argmax_helper(a_in, &a, true));
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(array_bulk_argmax_obj, array_bulk_argmax);
+
+// Convert the elements of src to the typecode of dest.  Integers are wrapped like
+// an array store does; floats are truncated towards zero and saturated.
+static mp_obj_t array_bulk_cast(mp_obj_t dest_in, mp_obj_t src_in) {
+    bulk_buf_t d, s;
+    bulk_get_buf(dest_in, &d, MP_BUFFER_WRITE);
+    bulk_get_buf(src_in, &s, MP_BUFFER_READ);
+    if (d.len != s.len) {
+        mp_raise_ValueError(MP_ERROR_TEXT("lengths differ"));
+    }
+    if (d.kind == s.kind) {
+        memmove(d.items, s.items, d.len * bulk_size[d.kind]);
+        return mp_const_none;
+    }
+    for (size_t i = 0; i < d.len; ++i) {
+        #if MICROPY_PY_BUILTINS_FLOAT
+        if (BULK_IS_FLOAT(s.kind)) {
+            mp_float_t value = bulk_load_float(s.kind, s.items, i);
+            if (BULK_IS_FLOAT(d.kind)) {
+                bulk_store_float(d.kind, d.items, i, value);
+            } else {
+                uint64_t ivalue;
+                if (value != value) {
+                    ivalue = 0;
+                } else if (value <= (mp_float_t)bulk_int_range[d.kind].min) {
+                    ivalue = (uint64_t)bulk_int_range[d.kind].min;
+                } else if (value >= (mp_float_t)bulk_int_range[d.kind].max) {
+                    ivalue = bulk_int_range[d.kind].max;
+                } else if (value < 0) {
+                    ivalue = (uint64_t)(long long)value;
+                } else {
+                    ivalue = (unsigned long long)value;
+                }
+                bulk_store_int(d.kind, d.items, i, ivalue);
+            }
+            continue;
+        }
+        #endif
+        uint64_t value = bulk_load_int(s.kind, s.items, i);
+        #if MICROPY_PY_BUILTINS_FLOAT
+        if (BULK_IS_FLOAT(d.kind)) {
+            mp_float_t fvalue = BULK_IS_SIGNED(s.kind) ? (mp_float_t)(long long)value : (mp_float_t)value;
+            bulk_store_float(d.kind, d.items, i, fvalue);
+            continue;
+        }
+        #endif
+        bulk_store_int(d.kind, d.items, i, value);
+    }
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_2(array_bulk_cast_obj, array_bulk_cast);
+
+#endif // MICROPY_PY_ARRAY_BULK
+
 static const mp_rom_map_elem_t mp_module_array_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_array) },
     { MP_ROM_QSTR(MP_QSTR_array), MP_ROM_PTR(&mp_type_array) },
+    #if MICROPY_PY_ARRAY_BULK
+    { MP_ROM_QSTR(MP_QSTR_sum), MP_ROM_PTR(&array_bulk_sum_obj) },
+    { MP_ROM_QSTR(MP_QSTR_dot), MP_ROM_PTR(&array_bulk_dot_obj) },
+    { MP_ROM_QSTR(MP_QSTR_add), MP_ROM_PTR(&array_bulk_add_obj) },
+    { MP_ROM_QSTR(MP_QSTR_mul), MP_ROM_PTR(&array_bulk_mul_obj) },
+    { MP_ROM_QSTR(MP_QSTR_clip), MP_ROM_PTR(&array_bulk_clip_obj) },
+    { MP_ROM_QSTR(MP_QSTR_min), MP_ROM_PTR(&array_bulk_min_obj) },
+    { MP_ROM_QSTR(MP_QSTR_max), MP_ROM_PTR(&array_bulk_max_obj) },
+    { MP_ROM_QSTR(MP_QSTR_argmin), MP_ROM_PTR(&array_bulk_argmin_obj) },
+    { MP_ROM_QSTR(MP_QSTR_argmax), MP_ROM_PTR(&array_bulk_argmax_obj) },
+    { MP_ROM_QSTR(MP_QSTR_cast), MP_ROM_PTR(&array_bulk_cast_obj) },
+    #endif
 };
 
 static MP_DEFINE_CONST_DICT(mp_module_array_globals, mp_module_array_globals_table);
@@ -27,9 +27,45 @@
 #include "py/mpstate.h"
 #include "py/obj.h"
 #include "py/gc.h"
+#include "py/runtime.h"
 
 #if MICROPY_PY_GC && MICROPY_ENABLE_GC
 
+#if MICROPY_GC_INCREMENTAL
+// collect(*, budget_us=None): run a garbage collection, or with budget_us do
+// some of it and return True once it's complete
+static mp_obj_t py_gc_collect(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_budget_us };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_budget_us, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    if (args[ARG_budget_us].u_obj != mp_const_none) {
+        mp_int_t budget = mp_obj_get_int(args[ARG_budget_us].u_obj);
+        return mp_obj_new_bool(gc_collect_step(budget < 0 ? 0 : budget));
+    }
+    gc_collect();
+    gc_sweep_finish();
+    #if MICROPY_PY_GC_COLLECT_RETVAL
+    return MP_OBJ_NEW_SMALL_INT(MP_STATE_MEM(gc_collected));
+    #else
+    return mp_const_none;
+    #endif
+}
+MP_DEFINE_CONST_FUN_OBJ_KW(gc_collect_obj, 0, py_gc_collect);
+
+// max_pause([value]): get the longest pause in microseconds, or set it (eg to 0)
+static mp_obj_t gc_max_pause(size_t n_args, const mp_obj_t *args) {
+    if (n_args == 0) {
+        return mp_obj_new_int_from_uint(MP_STATE_MEM(gc_max_pause_us));
+    }
+    MP_STATE_MEM(gc_max_pause_us) = mp_obj_get_int(args[0]);
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(gc_max_pause_obj, 0, 1, gc_max_pause);
+#else
 // collect(): run a garbage collection
 static mp_obj_t py_gc_collect(void) {
     gc_collect();
@@ -40,6 +76,7 @@ static mp_obj_t py_gc_collect(void) {
     #endif
 }
 MP_DEFINE_CONST_FUN_OBJ_0(gc_collect_obj, py_gc_collect);
+#endif
 
 // disable(): disable the garbage collector
 static mp_obj_t gc_disable(void) {
@@ -111,6 +148,9 @@ static const mp_rom_map_elem_t mp_module_gc_globals_table[] = {
     #if MICROPY_GC_ALLOC_THRESHOLD
     { MP_ROM_QSTR(MP_QSTR_threshold), MP_ROM_PTR(&gc_threshold_obj) },
     #endif
+    #if MICROPY_GC_INCREMENTAL
+    { MP_ROM_QSTR(MP_QSTR_max_pause), MP_ROM_PTR(&gc_max_pause_obj) },
+    #endif
 };
 
 static MP_DEFINE_CONST_DICT(mp_module_gc_globals, mp_module_gc_globals_table);
@@ -31,6 +31,7 @@
 #include "py/runtime.h"
 #include "py/gc.h"
 #include "py/mphal.h"
+#include "py/objfun.h"
 
 #if MICROPY_PY_MICROPYTHON
 
@@ -142,6 +143,100 @@ static mp_obj_t mp_micropython_heap_locked(void) {
 }
 static MP_DEFINE_CONST_FUN_OBJ_0(mp_micropython_heap_locked_obj, mp_micropython_heap_locked);
 #endif
+
+#if MICROPY_GC_PROFILE
+static mp_obj_t mp_micropython_heap_profile(size_t n_args, const mp_obj_t *args) {
+    if (n_args == 0) {
+        return mp_obj_new_int_from_uint(MP_STATE_MEM(gc_profile_rate));
+    }
+    mp_int_t rate = mp_obj_get_int(args[0]);
+    if (rate < 0) {
+        mp_raise_ValueError(NULL);
+    }
+    gc_profile_start(rate);
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mp_micropython_heap_profile_obj, 0, 1, mp_micropython_heap_profile);
+
+static mp_obj_t mp_micropython_heap_snapshot(void) {
+    vstr_t vstr;
+    vstr_init(&vstr, 64);
+    gc_profile_snapshot(&vstr);
+    return mp_obj_new_bytes_from_vstr(&vstr);
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(mp_micropython_heap_snapshot_obj, mp_micropython_heap_snapshot);
+#endif
+
+#if MICROPY_GC_ARENA
+typedef struct _mp_obj_arena_t {
+    mp_obj_base_t base;
+    size_t size;
+} mp_obj_arena_t;
+
+static mp_obj_t arena_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    mp_arg_check_num(n_args, n_kw, 1, 1, false);
+    mp_int_t size = mp_obj_get_int(args[0]);
+    if (size <= 0) {
+        mp_raise_ValueError(NULL);
+    }
+    mp_obj_arena_t *self = mp_obj_malloc(mp_obj_arena_t, type);
+    self->size = size;
+    return MP_OBJ_FROM_PTR(self);
+}
+
+static mp_obj_t arena___enter__(mp_obj_t self_in) {
+    mp_obj_arena_t *self = MP_OBJ_TO_PTR(self_in);
+    if (MP_STATE_MEM(gc_arena_area) != NULL) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("arena already active"));
+    }
+    if (!gc_arena_enter(self->size)) {
+        m_malloc_fail(self->size);
+    }
+    return self_in;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(arena___enter___obj, arena___enter__);
+
+static mp_obj_t arena___exit__(size_t n_args, const mp_obj_t *args) {
+    (void)n_args;
+    (void)args;
+    gc_arena_exit();
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(arena___exit___obj, 4, 4, arena___exit__);
+
+static const mp_rom_map_elem_t arena_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___enter__), MP_ROM_PTR(&arena___enter___obj) },
+    { MP_ROM_QSTR(MP_QSTR___exit__), MP_ROM_PTR(&arena___exit___obj) },
+};
+static MP_DEFINE_CONST_DICT(arena_locals_dict, arena_locals_dict_table);
+
+static MP_DEFINE_CONST_OBJ_TYPE(
+    mp_type_arena,
+    MP_QSTR_arena,
+    MP_TYPE_FLAG_NONE,
+    make_new, arena_make_new,
+    locals_dict, &arena_locals_dict
+    );
+#endif
+#endif
+
+#if MICROPY_CALL_PROFILE
+static mp_obj_t mp_micropython_call_profile(size_t n_args, const mp_obj_t *args) {
+    if (n_args == 0) {
+        return mp_obj_new_bool(MP_STATE_VM(call_profile_enabled));
+    }
+    mp_call_profile_start(mp_obj_is_true(args[0]));
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mp_micropython_call_profile_obj, 0, 1, mp_micropython_call_profile);
+
+static mp_obj_t mp_micropython_call_snapshot(void) {
+    vstr_t vstr;
+    vstr_init(&vstr, 64);
+    mp_call_profile_snapshot(&vstr);
+    return mp_obj_new_bytes_from_vstr(&vstr);
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(mp_micropython_call_snapshot_obj, mp_micropython_call_snapshot);
 #endif
 
 #if MICROPY_ENABLE_EMERGENCY_EXCEPTION_BUF && (MICROPY_EMERGENCY_EXCEPTION_BUF_SIZE == 0)
@@ -196,6 +291,17 @@ static const mp_rom_map_elem_t mp_module_micropython_globals_table[] = {
     #if MICROPY_PY_MICROPYTHON_HEAP_LOCKED
     { MP_ROM_QSTR(MP_QSTR_heap_locked), MP_ROM_PTR(&mp_micropython_heap_locked_obj) },
     #endif
+    #if MICROPY_GC_PROFILE
+    { MP_ROM_QSTR(MP_QSTR_heap_profile), MP_ROM_PTR(&mp_micropython_heap_profile_obj) },
+    { MP_ROM_QSTR(MP_QSTR_heap_snapshot), MP_ROM_PTR(&mp_micropython_heap_snapshot_obj) },
+    #endif
+    #if MICROPY_GC_ARENA
+    { MP_ROM_QSTR(MP_QSTR_arena), MP_ROM_PTR(&mp_type_arena) },
+    #endif
+    #endif
+    #if MICROPY_CALL_PROFILE
+    { MP_ROM_QSTR(MP_QSTR_call_profile), MP_ROM_PTR(&mp_micropython_call_profile_obj) },
+    { MP_ROM_QSTR(MP_QSTR_call_snapshot), MP_ROM_PTR(&mp_micropython_call_snapshot_obj) },
     #endif
     #if MICROPY_KBD_EXCEPTION
     { MP_ROM_QSTR(MP_QSTR_kbd_intr), MP_ROM_PTR(&mp_micropython_kbd_intr_obj) },
@@ -200,6 +200,79 @@
 #define MICROPY_GC_ALLOC_THRESHOLD (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_CORE_FEATURES)
 #endif
 
+// Number of size classes (2-3, 4-7, 8-15, ... blocks) for which gc_alloc
+// remembers where to start looking for a free run.  With 0, allocations of
+// any size start from the first free block.
+#ifndef MICROPY_GC_FREE_HINTS
+#define MICROPY_GC_FREE_HINTS (4)
+#endif
+
+// Whether to keep a bitmap of blocks allocated with GC_ALLOC_FLAG_NO_SCAN, whose
+// contents (eg str, bytes and array data) are then not scanned for pointers
+// when marking.  Costs one bit of heap per block.
+#ifndef MICROPY_GC_NO_SCAN
+#define MICROPY_GC_NO_SCAN (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EXTRA_FEATURES)
+#endif
+
+// Whether to provide the allocation profiler, micropython.heap_profile() and
+// micropython.heap_snapshot().  Sampled allocations are attributed to the line
+// of bytecode that made them, and snapshots count the live objects by type.
+// Costs two bits of heap per block, and a little time in mp_obj_malloc.
+#ifndef MICROPY_GC_PROFILE
+#define MICROPY_GC_PROFILE (0)
+#endif
+
+// Number of distinct allocation sites the profiler keeps counts for
+#ifndef MICROPY_GC_PROFILE_SITES
+#define MICROPY_GC_PROFILE_SITES (32)
+#endif
+
+// Number of sampled allocations the profiler can follow to see if still live
+#ifndef MICROPY_GC_PROFILE_SAMPLES
+#define MICROPY_GC_PROFILE_SAMPLES (128)
+#endif
+
+// Number of distinct types a heap snapshot can count
+#ifndef MICROPY_GC_PROFILE_TYPES
+#define MICROPY_GC_PROFILE_TYPES (64)
+#endif
+
+// Whether to provide the call profiler, micropython.call_profile() and
+// micropython.call_snapshot().  Calls to bytecode functions are counted along
+// with the time spent in each, and mpy-cross can use a snapshot to compile the
+// hot functions to native code.  Costs a little time in each call to a bytecode
+// function, and more while profiling.  Requires mp_hal_ticks_us().
+#ifndef MICROPY_CALL_PROFILE
+#define MICROPY_CALL_PROFILE (0)
+#endif
+
+// Number of distinct functions the call profiler keeps counts for
+#ifndef MICROPY_CALL_PROFILE_FUNS
+#define MICROPY_CALL_PROFILE_FUNS (32)
+#endif
+
+// Whether to sweep lazily after marking: the blocks of unreachable objects are
+// freed a slice at a time by later gc_alloc calls and gc.collect(budget_us=...)
+// instead of in the same pause as the mark.  Only the sweep is bounded; marking
+// still walks the whole live heap in one pause.  Also tracks the longest pause
+// in gc.max_pause().  Requires mp_hal_ticks_us().
+#ifndef MICROPY_GC_INCREMENTAL
+#define MICROPY_GC_INCREMENTAL (0)
+#endif
+
+// Number of blocks swept per slice of a lazy sweep
+#ifndef MICROPY_GC_SWEEP_SLICE
+#define MICROPY_GC_SWEEP_SLICE (256)
+#endif
+
+// Whether to provide micropython.arena(size), a scope whose allocations are
+// carved in turn from one run of blocks reserved on entry.  On exit the heap
+// is scanned for references into the run, and whatever isn't referenced is
+// freed straight away, without waiting for a full collection.
+#ifndef MICROPY_GC_ARENA
+#define MICROPY_GC_ARENA (0)
+#endif
+
 // Number of bytes to allocate initially when creating new chunks to store
 // interned string data.  Smaller numbers lead to more chunks being needed
 // and more wastage at the end of the chunk.  Larger numbers lead to wasted
@@ -299,6 +372,13 @@
 #endif
 #endif
 
+// Whether to keep an open-addressing hash index of the qstrs interned at
+// runtime, so that looking one up doesn't scan every runtime pool.  Costs
+// about 4 bytes of heap per runtime qstr.
+#ifndef MICROPY_QSTR_INDEX
+#define MICROPY_QSTR_INDEX (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EXTRA_FEATURES)
+#endif
+
 // Avoid using C stack when making Python function calls. C stack still
 // may be used if there's no free heap.
 #ifndef MICROPY_STACKLESS
@@ -330,6 +410,13 @@
 #define MICROPY_PERSISTENT_CODE_LOAD (0)
 #endif
 
+// Whether functions of a bytecode .mpy file that is memory-mapped (eg in ROMFS)
+// are set up only when they are first made into a function object.  Functions
+// without children refer to their bytecode in place and need no RAM at all.
+#ifndef MICROPY_PERSISTENT_CODE_LAZY
+#define MICROPY_PERSISTENT_CODE_LAZY (MICROPY_PERSISTENT_CODE_LOAD && MICROPY_VFS_ROM && !MICROPY_PERSISTENT_CODE_SAVE)
+#endif
+
 // Whether to support saving of persistent code, i.e. for mpy-cross to
 // generate .mpy files. Enabling this enables additional metadata on raw code
 // objects which is also required for sys.settrace.
@@ -498,6 +585,24 @@
 #define MICROPY_COMP_RETURN_IF_EXPR (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EXTRA_FEATURES)
 #endif
 
+// Whether the bytecode emitter does peephole optimisation: fusing common opcode
+// sequences into superinstructions, threading jumps to jumps, and turning stores
+// to locals that are never read into a pop.  The VM always supports the
+// superinstructions, this only controls whether the compiler emits them.
+// It has no effect when MICROPY_PY_SYS_SETTRACE is enabled.
+#ifndef MICROPY_COMP_PEEPHOLE
+#define MICROPY_COMP_PEEPHOLE (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EXTRA_FEATURES)
+#endif
+
+// Whether to enable the extra optimisations done at optimisation level 2 and
+// above (eg mpy-cross -O2): folding of float, str and bytes constant expressions,
+// and constants imported from other modules (see mp_parse_define_module_const).
+// In mpy-cross it also provides --hoist-globals.  Requires
+// MICROPY_COMP_CONST_FOLDING and MICROPY_COMP_CONST.
+#ifndef MICROPY_COMP_OPT_LEVEL_2
+#define MICROPY_COMP_OPT_LEVEL_2 (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EXTRA_FEATURES)
+#endif
+
 /*****************************************************************************/
 /* Internal debugging stuff                                                  */
 
@@ -575,6 +680,50 @@
 #define MICROPY_OPT_MAP_LOOKUP_CACHE_SIZE (128)
 #endif
 
+// Give each bytecode function a small heap-allocated cache, indexed by opcode
+// offset, remembering where LOAD_GLOBAL and LOAD_ATTR last found their name and
+// which method LOAD_METHOD last found for a given type. Unlike the map lookup
+// cache above, call sites don't evict each other. Costs up to 5 words of heap
+// per cache entry for each function that is run.
+#ifndef MICROPY_OPT_INLINE_CACHE
+#define MICROPY_OPT_INLINE_CACHE (0)
+#endif
+
+// Maximum number of entries in each function's inline cache (a power of 2).
+#ifndef MICROPY_OPT_INLINE_CACHE_MAX_ENTRIES
+#define MICROPY_OPT_INLINE_CACHE_MAX_ENTRIES (32)
+#endif
+
+// Once a bytecode function has been run MICROPY_OPT_QUICKENING_THRESHOLD times,
+// rewrite its opcodes in place with versions specialised for the operand types
+// seen (small int and float arithmetic, list and tuple indexing, instance
+// attributes). A specialised opcode whose guard fails reverts to the generic
+// one. Only bytecode in the heap is rewritten, not frozen or ROM bytecode.
+#ifndef MICROPY_OPT_QUICKENING
+#define MICROPY_OPT_QUICKENING (0)
+#endif
+
+// Number of times a function must run before it is quickened (at most 254).
+#ifndef MICROPY_OPT_QUICKENING_THRESHOLD
+#define MICROPY_OPT_QUICKENING_THRESHOLD (8)
+#endif
+
+// Store the attributes of instances of user classes as a flat array of values,
+// with their names held in a "shape" that is shared by all instances that had
+// the same attributes set in the same order, rather than in a map per instance.
+// Instance attribute lookups then scan a short array of qstrs, or with
+// MICROPY_OPT_INLINE_CACHE index straight into the values.  An instance that has
+// an attribute deleted, or is given more than MICROPY_OPT_INSTANCE_SHAPES_MAX_ATTRS
+// attributes, goes back to a map.  Shapes are never freed.
+#ifndef MICROPY_OPT_INSTANCE_SHAPES
+#define MICROPY_OPT_INSTANCE_SHAPES (0)
+#endif
+
+// Maximum number of attributes an instance can have in a shape.
+#ifndef MICROPY_OPT_INSTANCE_SHAPES_MAX_ATTRS
+#define MICROPY_OPT_INSTANCE_SHAPES_MAX_ATTRS (16)
+#endif
+
 // Whether to use fast versions of bitwise operations (and, or, xor) when the
 // arguments are both positive.  Increases Thumb2 code size by about 250 bytes.
 #ifndef MICROPY_OPT_MPZ_BITWISE
@@ -682,6 +831,23 @@
 #define MICROPY_PYSTACK_ALIGN (8)
 #endif
 
+// Whether bytecode frames that are too big for the C stack are kept on a per-thread
+// free list when the call returns, to be reused by the next call instead of going
+// to the heap.  Only used when the pystack is disabled.
+#ifndef MICROPY_VM_FRAME_CACHE
+#define MICROPY_VM_FRAME_CACHE (0)
+#endif
+
+// Number of frame size classes, each twice the size of the previous one.
+#ifndef MICROPY_VM_FRAME_CACHE_CLASSES
+#define MICROPY_VM_FRAME_CACHE_CLASSES (4)
+#endif
+
+// Maximum number of free frames kept for each size class.
+#ifndef MICROPY_VM_FRAME_CACHE_DEPTH
+#define MICROPY_VM_FRAME_CACHE_DEPTH (4)
+#endif
+
 // Whether to check C stack usage. C stack used for calling Python functions,
 // etc. Not checking means segfault on overflow.
 #ifndef MICROPY_STACK_CHECK
@@ -1351,6 +1517,12 @@ typedef double mp_float_t;
 #define MICROPY_PY_ARRAY_SLICE_ASSIGN (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EXTRA_FEATURES)
 #endif
 
+// Whether to provide bulk numeric functions (sum, dot, add, mul, clip, min, max,
+// argmin, argmax, cast) in the "array" module (MicroPython extension).
+#ifndef MICROPY_PY_ARRAY_BULK
+#define MICROPY_PY_ARRAY_BULK (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EVERYTHING)
+#endif
+
 // Whether to support attrtuple type (MicroPython extension)
 // It provides space-efficient tuples with attribute access
 #ifndef MICROPY_PY_ATTRTUPLE
@@ -1562,6 +1734,9 @@ typedef double mp_float_t;
 #define MICROPY_PY_SYS_SETTRACE (0)
 #endif
 
+// Whether the VM keeps MP_STATE_THREAD(current_code_state) up to date
+#define MICROPY_TRACK_CODE_STATE (MICROPY_PY_SYS_SETTRACE || MICROPY_GC_PROFILE)
+
 // Whether to provide "sys.getsizeof" function
 #ifndef MICROPY_PY_SYS_GETSIZEOF
 #define MICROPY_PY_SYS_GETSIZEOF (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EVERYTHING)
@@ -63,6 +63,13 @@ typedef struct mp_dynamic_compiler_t {
     uint8_t small_int_bits; // must be <= host small_int_bits
     uint8_t native_arch;
     uint8_t nlr_buf_num_regs;
+    #if MICROPY_EMIT_NATIVE
+    // If set, chooses functions to compile to native code, see compile.c
+    bool (*native_select)(qstr name, size_t line, size_t bytecode_len, size_t native_len);
+    #endif
+    #if MICROPY_COMP_OPT_LEVEL_2
+    bool hoist_globals; // load globals read in loops before the loop, see compile.c
+    #endif
 } mp_dynamic_compiler_t;
 extern mp_dynamic_compiler_t mp_dynamic_compiler;
 #endif
@@ -101,13 +108,54 @@ typedef struct _mp_state_mem_area_t {
     #if MICROPY_ENABLE_FINALISER
     byte *gc_finaliser_table_start;
     #endif
+    #if MICROPY_GC_NO_SCAN
+    byte *gc_no_scan_table_start;
+    #endif
+    #if MICROPY_GC_PROFILE
+    byte *gc_profile_table_start;
+    #endif
     byte *gc_pool_start;
     byte *gc_pool_end;
 
     size_t gc_last_free_atb_index;
+    #if MICROPY_GC_FREE_HINTS
+    // Like gc_last_free_atb_index, but for runs of at least 2 << i blocks
+    size_t gc_free_hint_atb_index[MICROPY_GC_FREE_HINTS];
+    #endif
     size_t gc_last_used_block; // The block ID of the highest block allocated in the area
+    #if MICROPY_GC_INCREMENTAL
+    size_t gc_sweep_block; // Blocks from here on are still to be swept, (size_t)-1 if none
+    #endif
 } mp_state_mem_area_t;
 
+#if MICROPY_GC_PROFILE
+// An allocation site seen by the heap profiler, and its sampled allocations
+typedef struct _mp_gc_profile_site_t {
+    qstr file; // MP_QSTRnull if not made by bytecode
+    size_t line;
+    size_t n_allocs;
+    size_t n_bytes;
+} mp_gc_profile_site_t;
+
+// A sampled allocation that may still be live
+typedef struct _mp_gc_profile_sample_t {
+    void *ptr;
+    size_t n_bytes;
+    size_t site;
+} mp_gc_profile_sample_t;
+#endif
+
+#if MICROPY_CALL_PROFILE
+// A bytecode function seen by the call profiler
+typedef struct _mp_call_profile_fun_t {
+    qstr file; // MP_QSTRnull for the catch-all entry
+    qstr name;
+    size_t line; // line of the first statement
+    size_t n_calls;
+    size_t us; // time spent in the function itself, not in its callees
+} mp_call_profile_fun_t;
+#endif
+
 // This structure hold information about the memory allocation system.
 typedef struct _mp_state_mem_t {
     #if MICROPY_MEM_STATS
@@ -143,6 +191,35 @@ typedef struct _mp_state_mem_t {
     size_t gc_collected;
     #endif
 
+    #if MICROPY_GC_PROFILE
+    // Heap profiler state, see gcprofile.c.  This isn't in the root pointers
+    // so the sampled allocations aren't kept alive by it.
+    size_t gc_profile_rate; // sample one in this many allocations, 0 if off
+    size_t gc_profile_countdown;
+    size_t gc_profile_n_sites;
+    size_t gc_profile_n_samples;
+    mp_gc_profile_site_t gc_profile_sites[MICROPY_GC_PROFILE_SITES];
+    mp_gc_profile_sample_t gc_profile_samples[MICROPY_GC_PROFILE_SAMPLES];
+    #endif
+
+    #if MICROPY_GC_INCREMENTAL
+    // The area a lazy sweep is up to, NULL if no sweep is pending
+    mp_state_mem_area_t *gc_sweep_area;
+    mp_uint_t gc_pause_start;
+    mp_uint_t gc_max_pause_us;
+    #endif
+
+    #if MICROPY_GC_ARENA
+    // The area and blocks [start, end) of the active arena, area NULL if none.
+    // Its unused blocks are a chain kept alive by the gc_arena_free root
+    // pointer.  gc_arena_scan is set while gc_arena_exit looks for references
+    // into the arena.
+    mp_state_mem_area_t *gc_arena_area;
+    size_t gc_arena_start_block;
+    size_t gc_arena_end_block;
+    bool gc_arena_scan;
+    #endif
+
     #if MICROPY_PY_THREAD && !MICROPY_PY_THREAD_GIL
     // This is a global mutex used to make the GC thread-safe.
     mp_thread_recursive_mutex_t gc_mutex;
@@ -161,6 +238,11 @@ typedef struct _mp_state_vm_t {
 
     qstr_pool_t *last_pool;
 
+    #if MICROPY_QSTR_INDEX
+    // hash index of the qstrs in the pools after the ROM ones, see qstr.c
+    qstr_index_t *qstr_index;
+    #endif
+
     #if MICROPY_TRACKED_ALLOC
     struct _m_tracked_node_t *m_tracked_head;
     #endif
@@ -212,6 +294,10 @@ typedef struct _mp_state_vm_t {
     size_t qstr_last_alloc;
     size_t qstr_last_used;
 
+    #if MICROPY_QSTR_INDEX
+    size_t qstr_index_alloc; // size for the next qstr_index
+    #endif
+
     #if MICROPY_PY_THREAD && !MICROPY_PY_THREAD_GIL
     // This is a global mutex used to make qstr interning thread-safe.
     mp_thread_mutex_t qstr_mutex;
@@ -259,6 +345,24 @@ typedef struct _mp_state_vm_t {
     // See mp_map_lookup.
     uint8_t map_lookup_cache[MICROPY_OPT_MAP_LOOKUP_CACHE_SIZE];
     #endif
+
+    #if MICROPY_OPT_INLINE_CACHE
+    // Incremented whenever an attribute of a type is stored or deleted, which
+    // invalidates all methods remembered by inline caches (see vm.c).
+    size_t inline_cache_epoch;
+    #if MICROPY_PY_THREAD && !MICROPY_PY_THREAD_GIL
+    // Taken to attach an inline cache to a function.
+    mp_thread_mutex_t inline_cache_mutex;
+    #endif
+    #endif
+
+    #if MICROPY_CALL_PROFILE
+    // Call profiler state, see callprofile.c
+    bool call_profile_enabled;
+    size_t call_profile_callee_us; // time spent in callees of the current call
+    size_t call_profile_n_funs;
+    mp_call_profile_fun_t call_profile_funs[MICROPY_CALL_PROFILE_FUNS];
+    #endif
 } mp_state_vm_t;
 
 // This structure holds state that is specific to a given thread. Everything
@@ -301,9 +405,17 @@ typedef struct _mp_state_thread_t {
     // If MP_OBJ_STOP_ITERATION is propagated then this holds its argument.
     mp_obj_t stop_iteration_arg;
 
+    #if MICROPY_VM_FRAME_CACHE && !MICROPY_ENABLE_PYSTACK
+    // Free lists of bytecode frames, one for each size class (see objfun.c).
+    struct _mp_code_state_t *frame_cache[MICROPY_VM_FRAME_CACHE_CLASSES];
+    uint8_t frame_cache_len[MICROPY_VM_FRAME_CACHE_CLASSES];
+    #endif
+
     #if MICROPY_PY_SYS_SETTRACE
     mp_obj_t prof_trace_callback;
     bool prof_callback_is_executing;
+    #endif
+    #if MICROPY_TRACK_CODE_STATE
     struct _mp_code_state_t *current_code_state;
     #endif
 
@@ -107,7 +107,12 @@ static mp_obj_array_t *array_new(char typecode, size_t n) {
     o->typecode = typecode;
     o->free = 0;
     o->len = n;
-    o->items = m_new(byte, typecode_size * o->len);
+    if (typecode == 'O' || typecode == 'P' || typecode == 'S') {
+        // these items may point into the heap
+        o->items = m_new(byte, typecode_size * o->len);
+    } else {
+        o->items = m_new_no_scan(byte, typecode_size * o->len);
+    }
     return o;
 }
 #endif
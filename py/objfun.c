@@ -35,6 +35,7 @@
 #include "py/runtime.h"
 #include "py/bc.h"
 #include "py/cstack.h"
+#include "py/gc.h"
 
 #if MICROPY_DEBUG_VERBOSE // print debugging info
 #define DEBUG_PRINT (1)
@@ -214,6 +215,60 @@ static void dump_args(const mp_obj_t *a, size_t sz) {
             + n_exc_stack * sizeof(mp_exc_stack_t);                \
     }
 
+#if MICROPY_VM_FRAME_CACHE && !MICROPY_ENABLE_PYSTACK
+
+// Frames that don't fit on the C stack are taken from, and given back to, a per-thread
+// cache with one free list for each size class.  Class i holds frames with room for
+// 16 << i words of state.  While a frame is on a free list it is zeroed, so it doesn't
+// keep any objects alive, except for its first state word which links to the next one.
+#define FRAME_CACHE_STATE_SIZE(i) ((sizeof(mp_obj_t) * 16) << (i))
+#define FRAME_CACHE_NEXT(code_state) (*(mp_code_state_t **)(void *)(code_state)->state)
+
+static size_t frame_cache_class(size_t state_size) {
+    size_t i = 0;
+    while (i < MICROPY_VM_FRAME_CACHE_CLASSES && state_size > FRAME_CACHE_STATE_SIZE(i)) {
+        ++i;
+    }
+    return i;
+}
+
+// Returns NULL if there is no memory, like m_new_obj_var_maybe.
+static mp_code_state_t *frame_cache_alloc(size_t state_size) {
+    size_t i = frame_cache_class(state_size);
+    // A hard IRQ handler runs with the GC locked, and may have interrupted this
+    // thread part way through updating the cache, so it must not touch it.
+    if (i == MICROPY_VM_FRAME_CACHE_CLASSES || gc_is_locked()) {
+        return m_new_obj_var_maybe(mp_code_state_t, state, byte, state_size);
+    }
+    mp_code_state_t *code_state = MP_STATE_THREAD(frame_cache)[i];
+    if (code_state != NULL) {
+        MP_STATE_THREAD(frame_cache)[i] = FRAME_CACHE_NEXT(code_state);
+        MP_STATE_THREAD(frame_cache_len)[i] -= 1;
+        FRAME_CACHE_NEXT(code_state) = NULL;
+        return code_state;
+    }
+    return m_new_obj_var_maybe(mp_code_state_t, state, byte, FRAME_CACHE_STATE_SIZE(i));
+}
+
+static void frame_cache_free(mp_code_state_t *code_state, size_t state_size) {
+    size_t i = frame_cache_class(state_size);
+    if (i == MICROPY_VM_FRAME_CACHE_CLASSES || gc_is_locked()) {
+        m_del_var(mp_code_state_t, state, byte, state_size, code_state);
+    } else if (MP_STATE_THREAD(frame_cache_len)[i] == MICROPY_VM_FRAME_CACHE_DEPTH) {
+        m_del_var(mp_code_state_t, state, byte, FRAME_CACHE_STATE_SIZE(i), code_state);
+    } else {
+        memset(code_state, 0, offsetof(mp_code_state_t, state) + state_size);
+        FRAME_CACHE_NEXT(code_state) = MP_STATE_THREAD(frame_cache)[i];
+        MP_STATE_THREAD(frame_cache)[i] = code_state;
+        MP_STATE_THREAD(frame_cache_len)[i] += 1;
+    }
+}
+
+#else
+#define frame_cache_alloc(state_size) m_new_obj_var_maybe(mp_code_state_t, state, byte, state_size)
+#define frame_cache_free(code_state, state_size) m_del_var(mp_code_state_t, state, byte, state_size, code_state)
+#endif
+
 #define INIT_CODESTATE(code_state, _fun_bc, _n_state, n_args, n_kw, args) \
     code_state->fun_bc = _fun_bc; \
     code_state->n_state = _n_state; \
@@ -245,6 +300,10 @@ mp_code_state_t *mp_obj_fun_bc_prepare_codestate(mp_obj_t self_in, size_t n_args
 
     INIT_CODESTATE(code_state, self, n_state, n_args, n_kw, args);
 
+    #if MICROPY_OPT_QUICKENING
+    mp_obj_fun_bc_count_call(self);
+    #endif
+
     // execute the byte code with the correct globals context
     mp_globals_set(self->context->module.globals);
 
@@ -272,7 +331,7 @@ static mp_obj_t fun_bc_call(mp_obj_t self_in, size_t n_args, size_t n_kw, const
     code_state = mp_pystack_alloc(offsetof(mp_code_state_t, state) + state_size);
     #else
     if (state_size > VM_MAX_STATE_ON_STACK) {
-        code_state = m_new_obj_var_maybe(mp_code_state_t, state, byte, state_size);
+        code_state = frame_cache_alloc(state_size);
         #if MICROPY_DEBUG_VM_STACK_OVERFLOW
         if (code_state != NULL) {
             memset(code_state->state, 0, state_size);
@@ -290,9 +349,20 @@ static mp_obj_t fun_bc_call(mp_obj_t self_in, size_t n_args, size_t n_kw, const
 
     INIT_CODESTATE(code_state, self, n_state, n_args, n_kw, args);
 
+    #if MICROPY_OPT_QUICKENING
+    mp_obj_fun_bc_count_call(self);
+    #endif
+
     // execute the byte code with the correct globals context
     mp_globals_set(self->context->module.globals);
+    #if MICROPY_CALL_PROFILE
+    mp_call_profile_frame_t profile_frame;
+    mp_call_profile_enter(&profile_frame);
+    #endif
     mp_vm_return_kind_t vm_return_kind = mp_execute_bytecode(code_state, MP_OBJ_NULL);
+    #if MICROPY_CALL_PROFILE
+    mp_call_profile_exit(self, &profile_frame);
+    #endif
     mp_globals_set(code_state->old_globals);
 
     #if MICROPY_DEBUG_VM_STACK_OVERFLOW
@@ -342,7 +412,7 @@ static mp_obj_t fun_bc_call(mp_obj_t self_in, size_t n_args, size_t n_kw, const
     #else
     // free the state if it was allocated on the heap
     if (state_size != 0) {
-        m_del_var(mp_code_state_t, state, byte, state_size, code_state);
+        frame_cache_free(code_state, state_size);
     }
     #endif
 
@@ -431,6 +501,20 @@ mp_obj_t mp_obj_new_fun_bc(const mp_obj_t *def_args, const byte *code, const mp_
     o->bytecode = code;
     o->context = context;
     o->child_table = child_table;
+    #if MICROPY_OPT_INLINE_CACHE
+    o->inline_cache = NULL;
+    #endif
+    #if MICROPY_OPT_QUICKENING
+    // Quickening writes to the bytecode, so it must be in the heap
+    MP_STATIC_ASSERT(MICROPY_OPT_QUICKENING_THRESHOLD < MP_OBJ_FUN_BC_QUICKEN_NEVER);
+    o->quicken_count = 0;
+    #if MICROPY_ENABLE_GC
+    if (gc_nbytes(code) == 0)
+    #endif
+    {
+        o->quicken_count = MP_OBJ_FUN_BC_QUICKEN_NEVER;
+    }
+    #endif
     if (def_pos_args != NULL) {
         memcpy(o->extra_args, def_pos_args->items, n_def_args * sizeof(mp_obj_t));
     }
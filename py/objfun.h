@@ -29,6 +29,28 @@
 #include "py/bc.h"
 #include "py/obj.h"
 
+#if MICROPY_OPT_INLINE_CACHE
+// A method found by LOAD_METHOD, never modified once it's in a cache entry.
+typedef struct _mp_inline_cache_method_t {
+    const struct _mp_obj_type_t *type;
+    qstr qst;
+    size_t hash;        // qstr_hash(qst), to check that an instance doesn't shadow the method
+    size_t epoch;       // MP_STATE_VM(inline_cache_epoch) when the method was found
+    mp_obj_t value;
+} mp_inline_cache_method_t;
+
+typedef struct _mp_inline_cache_entry_t {
+    uint16_t offset;    // offset of the owning opcode in the bytecode, 0 if unused
+    uint16_t slot;      // index in the map where the name was last found, or misses since method was cached
+    const mp_inline_cache_method_t *method;
+} mp_inline_cache_entry_t;
+
+typedef struct _mp_inline_cache_t {
+    size_t mask;        // number of entries minus 1
+    mp_inline_cache_entry_t entry[];
+} mp_inline_cache_t;
+#endif
+
 typedef struct _mp_obj_fun_bc_t {
     mp_obj_base_t base;
     const mp_module_context_t *context;         // context within which this function was defined
@@ -37,6 +59,12 @@ typedef struct _mp_obj_fun_bc_t {
     #if MICROPY_PY_SYS_SETTRACE
     const struct _mp_raw_code_t *rc;
     #endif
+    #if MICROPY_OPT_INLINE_CACHE
+    mp_inline_cache_t *inline_cache;            // allocated when first needed
+    #endif
+    #if MICROPY_OPT_QUICKENING
+    uint8_t quicken_count;                      // number of runs, until quickening starts
+    #endif
     // the following extra_args array is allocated space to take (in order):
     //  - values of positional default args (if any)
     //  - a single slot for default kw args dict (if it has them)
@@ -53,6 +81,37 @@ typedef struct _mp_obj_fun_asm_t {
 mp_obj_t mp_obj_new_fun_bc(const mp_obj_t *def_args, const byte *code, const mp_module_context_t *cm, struct _mp_raw_code_t *const *raw_code_table);
 void mp_obj_fun_bc_attr(mp_obj_t self_in, qstr attr, mp_obj_t *dest);
 
+#if MICROPY_OPT_QUICKENING
+// Value of quicken_count for functions whose bytecode can't be quickened.
+#define MP_OBJ_FUN_BC_QUICKEN_NEVER (0xff)
+
+// Count a call of the function, or creation of a generator from it.  In GIL-less
+// builds two threads may race here, but the count then only loses increments: it
+// never goes past MICROPY_OPT_QUICKENING_THRESHOLD nor reaches QUICKEN_NEVER.
+static inline void mp_obj_fun_bc_count_call(mp_obj_fun_bc_t *fun) {
+    uint8_t count = fun->quicken_count;
+    if (count < MICROPY_OPT_QUICKENING_THRESHOLD) {
+        fun->quicken_count = count + 1;
+    }
+}
+#endif
+
+#if MICROPY_CALL_PROFILE
+// Call profiler support, see callprofile.c.  Each call of a bytecode function
+// is bracketed by mp_call_profile_enter and mp_call_profile_exit, which only
+// take the time while profiling.
+typedef struct _mp_call_profile_frame_t {
+    bool enabled;
+    mp_uint_t start_us;
+    size_t outer_callee_us;
+} mp_call_profile_frame_t;
+
+void mp_call_profile_start(bool enable);
+void mp_call_profile_enter(mp_call_profile_frame_t *frame);
+void mp_call_profile_exit(const mp_obj_fun_bc_t *fun, const mp_call_profile_frame_t *frame);
+void mp_call_profile_snapshot(vstr_t *vstr);
+#endif
+
 #if MICROPY_EMIT_NATIVE
 
 static inline mp_obj_t mp_obj_new_fun_native(const mp_obj_t *def_args, const void *fun_data, const mp_module_context_t *mc, struct _mp_raw_code_t *const *child_table) {
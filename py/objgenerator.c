@@ -63,6 +63,10 @@ static mp_obj_t gen_wrap_call(mp_obj_t self_in, size_t n_args, size_t n_kw, cons
         n_state * sizeof(mp_obj_t) + n_exc_stack * sizeof(mp_exc_stack_t),
         &mp_type_gen_instance);
 
+    #if MICROPY_OPT_QUICKENING
+    mp_obj_fun_bc_count_call(self_fun);
+    #endif
+
     o->pend_exc = mp_const_none;
     o->code_state.fun_bc = self_fun;
     o->code_state.n_state = n_state;
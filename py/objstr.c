@@ -2220,7 +2220,7 @@ mp_obj_t mp_obj_new_str_copy(const mp_obj_type_t *type, const byte *data, size_t
     o->len = len;
     if (data) {
         o->hash = qstr_compute_hash(data, len);
-        byte *p = m_new(byte, len + 1);
+        byte *p = m_new_no_scan(byte, len + 1);
         o->data = p;
         memcpy(p, data, len * sizeof(byte));
         p[len] = '\0'; // for now we add null for compatibility with C ASCIIZ strings
@@ -2269,6 +2269,7 @@ static mp_obj_t mp_obj_new_str_type_from_vstr(const mp_obj_type_t *type, vstr_t
         data = (byte *)m_renew(char, vstr->buf, vstr->alloc, vstr->len + 1);
     }
     data[vstr->len] = '\0'; // add null byte
+    m_set_no_scan(data);
     vstr->buf = NULL;
     vstr->alloc = 0;
     #if MICROPY_PY_BUILTINS_BYTEARRAY
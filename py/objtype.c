@@ -47,6 +47,115 @@
 static mp_obj_t mp_obj_is_subclass(mp_obj_t object, mp_obj_t classinfo);
 static mp_obj_t static_class_method_make_new(const mp_obj_type_t *self_in, size_t n_args, size_t n_kw, const mp_obj_t *args);
 
+#if MICROPY_OPT_INSTANCE_SHAPES
+
+/******************************************************************************/
+// instance shapes
+
+// Instances start out with this shape.  Its children are in
+// MP_STATE_VM(instance_shapes) so the GC can find them.
+static const mp_obj_instance_shape_t instance_shape_empty = { NULL, NULL, 0 };
+
+// The values array grows a GC block at a time.
+#define INSTANCE_VALUES_PER_BLOCK (MICROPY_BYTES_PER_GC_BLOCK / sizeof(mp_obj_t))
+
+static inline size_t instance_values_alloc(size_t n_attrs) {
+    return (n_attrs + INSTANCE_VALUES_PER_BLOCK - 1) / INSTANCE_VALUES_PER_BLOCK * INSTANCE_VALUES_PER_BLOCK;
+}
+
+// Return the shape for the attributes of shape followed by attr, or NULL if
+// there can't be one.
+static const mp_obj_instance_shape_t *instance_shape_add(const mp_obj_instance_shape_t *shape, qstr attr) {
+    size_t n = shape->n_attrs;
+    if (n >= MICROPY_OPT_INSTANCE_SHAPES_MAX_ATTRS) {
+        return NULL;
+    }
+    mp_obj_instance_shape_t **children = &MP_STATE_VM(instance_shapes);
+    if (shape != &instance_shape_empty) {
+        children = &((mp_obj_instance_shape_t *)shape)->children;
+    }
+    for (mp_obj_instance_shape_t *child = *children; child != NULL; child = child->sibling) {
+        if (child->attrs[n] == attr) {
+            return child;
+        }
+    }
+    mp_obj_instance_shape_t *child = m_new_obj_var_maybe(mp_obj_instance_shape_t, attrs, qstr, n + 1);
+    if (child == NULL) {
+        return NULL;
+    }
+    child->children = NULL;
+    child->n_attrs = n + 1;
+    memcpy(child->attrs, shape->attrs, n * sizeof(qstr));
+    child->attrs[n] = attr;
+    // link it in only once it's filled in
+    child->sibling = *children;
+    *children = child;
+    return child;
+}
+
+// Move the attributes of an instance from its values to a map.
+static void instance_shape_to_map(mp_obj_instance_t *self) {
+    const mp_obj_instance_shape_t *shape = self->shape;
+    mp_map_t *members = m_new_obj(mp_map_t);
+    mp_map_init(members, shape->n_attrs);
+    for (size_t i = 0; i < shape->n_attrs; ++i) {
+        mp_map_lookup(members, MP_OBJ_NEW_QSTR(shape->attrs[i]), MP_MAP_LOOKUP_ADD_IF_NOT_FOUND)->value = self->values[i];
+    }
+    m_del(mp_obj_t, self->values, instance_values_alloc(shape->n_attrs));
+    self->members = members;
+    self->values = NULL;
+    self->shape = NULL;
+}
+
+mp_obj_t *mp_obj_instance_lookup_member(mp_obj_instance_t *self, qstr attr) {
+    const mp_obj_instance_shape_t *shape = self->shape;
+    if (shape == NULL) {
+        mp_map_elem_t *elem = mp_map_lookup(self->members, MP_OBJ_NEW_QSTR(attr), MP_MAP_LOOKUP);
+        return elem != NULL ? &elem->value : NULL;
+    }
+    for (size_t i = 0; i < shape->n_attrs; ++i) {
+        if (shape->attrs[i] == attr) {
+            return &self->values[i];
+        }
+    }
+    return NULL;
+}
+
+bool mp_obj_instance_store_member(mp_obj_instance_t *self, qstr attr, mp_obj_t value) {
+    if (self->shape != NULL) {
+        mp_obj_t *slot = mp_obj_instance_lookup_member(self, attr);
+        if (value != MP_OBJ_NULL) {
+            if (slot != NULL) {
+                *slot = value;
+                return true;
+            }
+            const mp_obj_instance_shape_t *shape = instance_shape_add(self->shape, attr);
+            if (shape != NULL) {
+                size_t n = self->shape->n_attrs;
+                if (n % INSTANCE_VALUES_PER_BLOCK == 0) {
+                    self->values = m_renew(mp_obj_t, self->values, n, n + INSTANCE_VALUES_PER_BLOCK);
+                }
+                self->values[n] = value;
+                self->shape = shape;
+                return true;
+            }
+        } else if (slot == NULL) {
+            return false;
+        }
+        // deleting an attribute, or there's no shape to add it to
+        instance_shape_to_map(self);
+    }
+    if (value == MP_OBJ_NULL) {
+        return mp_map_lookup(self->members, MP_OBJ_NEW_QSTR(attr), MP_MAP_LOOKUP_REMOVE_IF_FOUND) != NULL;
+    }
+    mp_map_lookup(self->members, MP_OBJ_NEW_QSTR(attr), MP_MAP_LOOKUP_ADD_IF_NOT_FOUND)->value = value;
+    return true;
+}
+
+MP_REGISTER_ROOT_POINTER(struct _mp_obj_instance_shape_t *instance_shapes);
+
+#endif // MICROPY_OPT_INSTANCE_SHAPES
+
 /******************************************************************************/
 // instance object
 
@@ -101,7 +210,13 @@ mp_obj_instance_t *mp_obj_new_instance(const mp_obj_type_t *class, const mp_obj_
     size_t num_native_bases = instance_count_native_bases(class, native_base);
     assert(num_native_bases < 2);
     mp_obj_instance_t *o = mp_obj_malloc_var(mp_obj_instance_t, subobj, mp_obj_t, num_native_bases, class);
+    #if MICROPY_OPT_INSTANCE_SHAPES
+    o->shape = &instance_shape_empty;
+    o->values = NULL;
+    o->members = NULL;
+    #else
     mp_map_init(&o->members, 0);
+    #endif
     // Initialise the native base-class slot (should be 1 at most) with a valid
     // object.  It doesn't matter which object, so long as it can be uniquely
     // distinguished from a native class that is initialised.
@@ -410,8 +525,16 @@ static mp_obj_t instance_unary_op(mp_unary_op_t op, mp_obj_t self_in) {
         const mp_obj_type_t *native_base;
         size_t num_native_bases = instance_count_native_bases(mp_obj_get_type(self_in), &native_base);
 
-        size_t sz = sizeof(*self) + sizeof(*self->subobj) * num_native_bases
-            + sizeof(*self->members.table) * self->members.alloc;
+        size_t sz = sizeof(*self) + sizeof(*self->subobj) * num_native_bases;
+        #if MICROPY_OPT_INSTANCE_SHAPES
+        if (self->shape != NULL) {
+            sz += sizeof(*self->values) * instance_values_alloc(self->shape->n_attrs);
+        } else {
+            sz += sizeof(*self->members) + sizeof(*self->members->table) * self->members->alloc;
+        }
+        #else
+        sz += sizeof(*self->members.table) * self->members.alloc;
+        #endif
         return MP_OBJ_NEW_SMALL_INT(sz);
     }
     #endif
@@ -589,20 +712,34 @@ static void mp_obj_instance_load_attr(mp_obj_t self_in, qstr attr, mp_obj_t *des
     mp_obj_instance_t *self = MP_OBJ_TO_PTR(self_in);
 
     // Note: This is fast-path'ed in the VM for the MP_BC_LOAD_ATTR operation.
-    mp_map_elem_t *elem = mp_map_lookup(&self->members, MP_OBJ_NEW_QSTR(attr), MP_MAP_LOOKUP);
-    if (elem != NULL) {
+    mp_obj_t *value = mp_obj_instance_lookup_member(self, attr);
+    if (value != NULL) {
         // object member, always treated as a value
-        dest[0] = elem->value;
+        dest[0] = *value;
         return;
     }
     #if MICROPY_CPYTHON_COMPAT
     if (attr == MP_QSTR___dict__) {
         // Create a new dict with a copy of the instance's map items.
         // This creates, unlike CPython, a read-only __dict__ that can't be modified.
-        mp_obj_dict_t dict;
-        dict.base.type = &mp_type_dict;
-        dict.map = self->members;
-        dest[0] = mp_obj_dict_copy(MP_OBJ_FROM_PTR(&dict));
+        #if MICROPY_OPT_INSTANCE_SHAPES
+        if (self->shape != NULL) {
+            dest[0] = mp_obj_new_dict(self->shape->n_attrs);
+            for (size_t i = 0; i < self->shape->n_attrs; ++i) {
+                mp_obj_dict_store(dest[0], MP_OBJ_NEW_QSTR(self->shape->attrs[i]), self->values[i]);
+            }
+        } else
+        #endif
+        {
+            mp_obj_dict_t dict;
+            dict.base.type = &mp_type_dict;
+            #if MICROPY_OPT_INSTANCE_SHAPES
+            dict.map = *self->members;
+            #else
+            dict.map = self->members;
+            #endif
+            dest[0] = mp_obj_dict_copy(MP_OBJ_FROM_PTR(&dict));
+        }
         mp_obj_dict_t *dest_dict = MP_OBJ_TO_PTR(dest[0]);
         dest_dict->map.is_fixed = 1;
         return;
@@ -799,15 +936,8 @@ static bool mp_obj_instance_store_attr(mp_obj_t self_in, qstr attr, mp_obj_t val
 
 skip_special_accessors:
 
-    if (value == MP_OBJ_NULL) {
-        // delete attribute
-        mp_map_elem_t *elem = mp_map_lookup(&self->members, MP_OBJ_NEW_QSTR(attr), MP_MAP_LOOKUP_REMOVE_IF_FOUND);
-        return elem != NULL;
-    } else {
-        // store attribute
-        mp_map_lookup(&self->members, MP_OBJ_NEW_QSTR(attr), MP_MAP_LOOKUP_ADD_IF_NOT_FOUND)->value = value;
-        return true;
-    }
+    // store or delete attribute
+    return mp_obj_instance_store_member(self, attr, value);
 }
 
 static void mp_obj_instance_attr(mp_obj_t self_in, qstr attr, mp_obj_t *dest) {
@@ -1083,6 +1213,10 @@ static void type_attr(mp_obj_t self_in, qstr attr, mp_obj_t *dest) {
                 // can't apply delete/store to a fixed map
                 return;
             }
+            #if MICROPY_OPT_INLINE_CACHE
+            // methods found via this type may have changed
+            ++MP_STATE_VM(inline_cache_epoch);
+            #endif
             if (dest[1] == MP_OBJ_NULL) {
                 // delete attribute
                 mp_map_elem_t *elem = mp_map_lookup(locals_map, MP_OBJ_NEW_QSTR(attr), MP_MAP_LOOKUP_REMOVE_IF_FOUND);
@@ -28,15 +28,56 @@
 
 #include "py/obj.h"
 
+#if MICROPY_OPT_INSTANCE_SHAPES
+// The names of the attributes of an instance, in the order they were set.  The
+// shapes form a tree, with a child for each attribute added to a shape, so all
+// instances given the same attributes in the same order share a shape.
+typedef struct _mp_obj_instance_shape_t {
+    struct _mp_obj_instance_shape_t *children;
+    struct _mp_obj_instance_shape_t *sibling;
+    size_t n_attrs;
+    qstr attrs[];
+} mp_obj_instance_shape_t;
+#endif
+
 // instance object
 // creating an instance of a class makes one of these objects
 typedef struct _mp_obj_instance_t {
     mp_obj_base_t base;
+    #if MICROPY_OPT_INSTANCE_SHAPES
+    // If shape is NULL the attributes are in the members map, otherwise they
+    // are in values, in the order of shape->attrs.  These take the same space
+    // as a map so that subobj is in the same place either way.
+    const mp_obj_instance_shape_t *shape;
+    mp_obj_t *values;
+    mp_map_t *members;
+    #else
     mp_map_t members;
+    #endif
     mp_obj_t subobj[];
     // TODO maybe cache __getattr__ and __setattr__ for efficient lookup of them
 } mp_obj_instance_t;
 
+// Access the attributes stored in an instance itself (not those of its class).
+// mp_obj_instance_store_member deletes the attribute if value is MP_OBJ_NULL,
+// and returns false if it wasn't there.
+#if MICROPY_OPT_INSTANCE_SHAPES
+mp_obj_t *mp_obj_instance_lookup_member(mp_obj_instance_t *self, qstr attr);
+bool mp_obj_instance_store_member(mp_obj_instance_t *self, qstr attr, mp_obj_t value);
+#else
+static inline mp_obj_t *mp_obj_instance_lookup_member(mp_obj_instance_t *self, qstr attr) {
+    mp_map_elem_t *elem = mp_map_lookup(&self->members, MP_OBJ_NEW_QSTR(attr), MP_MAP_LOOKUP);
+    return elem != NULL ? &elem->value : NULL;
+}
+static inline bool mp_obj_instance_store_member(mp_obj_instance_t *self, qstr attr, mp_obj_t value) {
+    if (value == MP_OBJ_NULL) {
+        return mp_map_lookup(&self->members, MP_OBJ_NEW_QSTR(attr), MP_MAP_LOOKUP_REMOVE_IF_FOUND) != NULL;
+    }
+    mp_map_lookup(&self->members, MP_OBJ_NEW_QSTR(attr), MP_MAP_LOOKUP_ADD_IF_NOT_FOUND)->value = value;
+    return true;
+}
+#endif
+
 #if MICROPY_CPYTHON_COMPAT
 // this is needed for object.__new__
 mp_obj_instance_t *mp_obj_new_instance(const mp_obj_type_t *cls, const mp_obj_type_t **native_base);
@@ -39,6 +39,10 @@
 #include "py/objstr.h"
 #include "py/builtin.h"
 
+#if MICROPY_COMP_OPT_LEVEL_2 && MICROPY_PY_BUILTINS_FLOAT
+#include <math.h>
+#endif
+
 #if MICROPY_ENABLE_COMPILER
 
 #define RULE_ACT_ARG_MASK       (0x0f)
@@ -705,11 +709,291 @@ static bool fold_logical_constants(parser_t *parser, uint8_t rule_id, size_t *nu
     return false;
 }
 
+#if MICROPY_COMP_OPT_LEVEL_2
+
+// Longest str or bytes object that folding at -O2 will create.
+#define FOLD_OPT2_MAX_STR_LEN (256)
+
+static bool fold_opt2_get_operand(mp_parse_node_t pn, mp_obj_t *o) {
+    if (!mp_parse_node_is_const(pn)) {
+        return false;
+    }
+    *o = mp_parse_node_convert_to_obj(pn);
+    return mp_obj_is_int(*o)
+           #if MICROPY_PY_BUILTINS_FLOAT
+           || mp_obj_is_float(*o)
+           #endif
+           || mp_obj_is_str(*o)
+           || mp_obj_is_type(*o, &mp_type_bytes);
+}
+
+#if MICROPY_PY_BUILTINS_FLOAT
+static bool fold_opt2_is_float_ok(mp_obj_t o, bool exact) {
+    // Don't create inf or nan constants, nor zero because the constant table
+    // doesn't distinguish between 0.0 and -0.0.
+    mp_float_t f = mp_obj_get_float(o);
+    if (!isfinite(f) || f == 0) {
+        return false;
+    }
+    #if MICROPY_PERSISTENT_CODE_SAVE
+    if (exact) {
+        // the value is the same as that of a literal, eg negation of a literal
+        return true;
+    }
+    // A float is saved to .mpy as its repr, so it must survive the round trip.
+    vstr_t vstr;
+    mp_print_t print;
+    vstr_init_print(&vstr, 16, &print);
+    mp_obj_print_helper(&print, o, PRINT_REPR);
+    bool ok = mp_obj_get_float(mp_parse_num_float(vstr.buf, vstr.len, false, NULL)) == f;
+    vstr_clear(&vstr);
+    return ok;
+    #else
+    (void)exact;
+    return true;
+    #endif
+}
+
+#if MICROPY_FLOAT_IMPL == MICROPY_FLOAT_IMPL_DOUBLE
+// Floats are folded here in double precision, but the code may be saved to a
+// .mpy file and run on a target with single-precision floats.  There the
+// constant is the double result rounded to single precision, so only fold if
+// that is what the target would get by doing the operation itself.
+static bool fold_opt2_is_float_op_portable(mp_binary_op_t op, mp_obj_t lhs, mp_obj_t rhs, mp_obj_t res) {
+    float a = (float)mp_obj_get_float(lhs);
+    float b = (float)mp_obj_get_float(rhs);
+    volatile float r; // stop the compiler using extra precision
+    switch (op) {
+        case MP_BINARY_OP_ADD:
+            r = a + b;
+            break;
+        case MP_BINARY_OP_SUBTRACT:
+            r = a - b;
+            break;
+        case MP_BINARY_OP_MULTIPLY:
+            r = a * b;
+            break;
+        case MP_BINARY_OP_TRUE_DIVIDE:
+            r = a / b;
+            break;
+        case MP_BINARY_OP_POWER:
+            r = powf(a, b);
+            break;
+        default:
+            // floor division and modulo have their own rounding, leave them
+            // to the target
+            return false;
+    }
+    return isfinite(r) && r != 0 && r == (float)mp_obj_get_float(res);
+}
+#endif
+#endif
+
+// Fold lhs = lhs <op> rhs, but only if the operation is known not to raise.
+static bool fold_opt2_binary_op(mp_binary_op_t op, mp_obj_t *lhs, mp_obj_t rhs) {
+    #if MICROPY_PY_BUILTINS_FLOAT
+    if ((mp_obj_is_int(*lhs) || mp_obj_is_float(*lhs)) && (mp_obj_is_int(rhs) || mp_obj_is_float(rhs))) {
+        if (op == MP_BINARY_OP_FLOOR_DIVIDE || op == MP_BINARY_OP_TRUE_DIVIDE || op == MP_BINARY_OP_MODULO) {
+            if (mp_obj_get_float(rhs) == 0) {
+                return false;
+            }
+        } else if (op == MP_BINARY_OP_POWER) {
+            // only a positive base is guaranteed to give a real result
+            if (mp_obj_is_int(*lhs) && mp_obj_is_int(rhs) ? mp_obj_int_sign(rhs) < 0 : !(mp_obj_get_float(*lhs) > 0)) {
+                return false;
+            }
+        } else if (op != MP_BINARY_OP_ADD && op != MP_BINARY_OP_SUBTRACT && op != MP_BINARY_OP_MULTIPLY) {
+            return false;
+        }
+        mp_obj_t res = mp_binary_op(op, *lhs, rhs);
+        if (mp_obj_is_float(res) && !fold_opt2_is_float_ok(res, false)) {
+            return false;
+        }
+        #if MICROPY_FLOAT_IMPL == MICROPY_FLOAT_IMPL_DOUBLE
+        if (mp_obj_is_float(res) && !fold_opt2_is_float_op_portable(op, *lhs, rhs, res)) {
+            return false;
+        }
+        #endif
+        *lhs = res;
+        return true;
+    }
+    #endif
+
+    // str and bytes concatenation and repetition
+    mp_obj_t seq = *lhs;
+    mp_obj_t other = rhs;
+    if (op == MP_BINARY_OP_MULTIPLY && mp_obj_is_small_int(seq)) {
+        seq = rhs;
+        other = *lhs;
+    }
+    if (!(mp_obj_is_str(seq) || mp_obj_is_type(seq, &mp_type_bytes))) {
+        return false;
+    }
+    size_t len;
+    mp_obj_str_get_data(seq, &len);
+    if (op == MP_BINARY_OP_ADD) {
+        if (mp_obj_get_type(other) != mp_obj_get_type(seq)) {
+            return false;
+        }
+        size_t len2;
+        mp_obj_str_get_data(other, &len2);
+        len += len2;
+    } else if (op == MP_BINARY_OP_MULTIPLY && mp_obj_is_small_int(other)) {
+        mp_int_t n = MP_OBJ_SMALL_INT_VALUE(other);
+        if (n < 0 || (n > 0 && len > FOLD_OPT2_MAX_STR_LEN / (size_t)n)) {
+            return false;
+        }
+        len *= n;
+    } else {
+        return false;
+    }
+    if (len > FOLD_OPT2_MAX_STR_LEN) {
+        return false;
+    }
+    *lhs = mp_binary_op(op, *lhs, rhs);
+    return true;
+}
+
+// At -O2 also fold arithmetic involving floats (including int / int), and str
+// and bytes concatenation and repetition, eg 2 * 3.14159 or "ab" + "cd" * 2.
+// Integer-only expressions are left to the folding in fold_constants.
+static bool fold_constants_opt2(parser_t *parser, uint8_t rule_id, size_t num_args, mp_obj_t *arg0) {
+    bool int_only = true;
+    if (rule_id == RULE_arith_expr
+        || rule_id == RULE_term
+        || rule_id == RULE_power) {
+        if (!fold_opt2_get_operand(peek_result(parser, num_args - 1), arg0)) {
+            return false;
+        }
+        int_only = mp_obj_is_int(*arg0);
+        size_t step = rule_id == RULE_power ? 1 : 2;
+        for (ssize_t i = num_args - 1 - step; i >= 0; i -= step) {
+            mp_obj_t arg1;
+            if (!fold_opt2_get_operand(peek_result(parser, i), &arg1)) {
+                return false;
+            }
+            mp_binary_op_t op = MP_BINARY_OP_POWER;
+            if (rule_id != RULE_power) {
+                mp_token_kind_t tok = MP_PARSE_NODE_LEAF_ARG(peek_result(parser, i + 1));
+                op = MP_BINARY_OP_LSHIFT + (tok - MP_TOKEN_OP_DBL_LESS);
+                if (op == MP_BINARY_OP_TRUE_DIVIDE) {
+                    int_only = false;
+                }
+            }
+            int_only &= mp_obj_is_int(arg1);
+            if (!fold_opt2_binary_op(op, arg0, arg1)) {
+                return false;
+            }
+        }
+    #if MICROPY_PY_BUILTINS_FLOAT
+    } else if (rule_id == RULE_factor_2) {
+        mp_token_kind_t tok = MP_PARSE_NODE_LEAF_ARG(peek_result(parser, 1));
+        if (!(fold_opt2_get_operand(peek_result(parser, 0), arg0)
+              && mp_obj_is_float(*arg0)
+              && (tok == MP_TOKEN_OP_PLUS || tok == MP_TOKEN_OP_MINUS))) {
+            return false;
+        }
+        if (!fold_opt2_is_float_ok(*arg0, true)) {
+            return false;
+        }
+        int_only = false;
+        *arg0 = mp_unary_op(MP_UNARY_OP_POSITIVE + (tok - MP_TOKEN_OP_PLUS), *arg0);
+    #endif
+    } else {
+        return false;
+    }
+    return !int_only;
+}
+
+static mp_parse_node_t make_node_const_object_opt2(parser_t *parser, mp_obj_t obj) {
+    if (mp_obj_is_str(obj)) {
+        // a short str result is interned, in the same way as a str literal
+        size_t len;
+        const char *str = mp_obj_str_get_data(obj, &len);
+        qstr qst;
+        if (len <= MICROPY_ALLOC_PARSE_INTERN_STRING_LEN) {
+            qst = qstr_from_strn(str, len);
+        } else {
+            qst = qstr_find_strn(str, len);
+        }
+        if (qst != MP_QSTRnull) {
+            return mp_parse_node_new_leaf(MP_PARSE_NODE_STRING, qst);
+        }
+    }
+    return make_node_const_object_optimised(parser, 0, obj);
+}
+
+static void add_imported_module_consts(parser_t *parser, mp_parse_node_t pn_module, mp_parse_node_t pn_names) {
+    // from <module> import <name> [as <alias>], ...
+    // where <module> is an absolute module name and <module>.<name> was given to
+    // mp_parse_define_module_const
+    mp_map_t *module_consts = &((mp_obj_dict_t *)MP_OBJ_TO_PTR(MP_STATE_VM(parse_module_consts)))->map;
+    vstr_t vstr;
+    vstr_init(&vstr, 32);
+    if (MP_PARSE_NODE_IS_ID(pn_module)) {
+        vstr_add_str(&vstr, qstr_str(MP_PARSE_NODE_LEAF_ARG(pn_module)));
+    } else if (MP_PARSE_NODE_IS_STRUCT_KIND(pn_module, RULE_dotted_name)) {
+        mp_parse_node_struct_t *pns = (mp_parse_node_struct_t *)pn_module;
+        for (size_t i = 0; i < MP_PARSE_NODE_STRUCT_NUM_NODES(pns); i++) {
+            if (i > 0) {
+                vstr_add_byte(&vstr, '.');
+            }
+            vstr_add_str(&vstr, qstr_str(MP_PARSE_NODE_LEAF_ARG(pns->nodes[i])));
+        }
+    } else {
+        // relative import
+        vstr_clear(&vstr);
+        return;
+    }
+    vstr_add_byte(&vstr, '.');
+    size_t prefix_len = vstr.len;
+
+    mp_parse_node_t *nodes;
+    size_t n = mp_parse_node_extract_list(&pn_names, RULE_import_as_names, &nodes);
+    for (size_t i = 0; i < n; i++) {
+        if (!MP_PARSE_NODE_IS_STRUCT_KIND(nodes[i], RULE_import_as_name)) {
+            continue;
+        }
+        mp_parse_node_struct_t *pns = (mp_parse_node_struct_t *)nodes[i];
+        qstr name = MP_PARSE_NODE_LEAF_ARG(pns->nodes[0]);
+        qstr alias = MP_PARSE_NODE_IS_NULL(pns->nodes[1]) ? name : MP_PARSE_NODE_LEAF_ARG(pns->nodes[1]);
+        vstr_cut_tail_bytes(&vstr, vstr.len - prefix_len);
+        vstr_add_str(&vstr, qstr_str(name));
+        qstr key = qstr_find_strn(vstr.buf, vstr.len);
+        mp_map_elem_t *elem;
+        if (key != MP_QSTRnull
+            && (elem = mp_map_lookup(module_consts, MP_OBJ_NEW_QSTR(key), MP_MAP_LOOKUP)) != NULL
+            && mp_map_lookup(&parser->consts, MP_OBJ_NEW_QSTR(alias), MP_MAP_LOOKUP) == NULL) {
+            mp_map_lookup(&parser->consts, MP_OBJ_NEW_QSTR(alias), MP_MAP_LOOKUP_ADD_IF_NOT_FOUND)->value = elem->value;
+        }
+    }
+    vstr_clear(&vstr);
+}
+
+#endif // MICROPY_COMP_OPT_LEVEL_2
+
 static bool fold_constants(parser_t *parser, uint8_t rule_id, size_t num_args) {
     // this code does folding of arbitrary integer expressions, eg 1 + 2 * 3 + 4
     // it does not do partial folding, eg 1 + 2 + x -> 3 + x
 
     mp_obj_t arg0;
+
+    #if MICROPY_COMP_OPT_LEVEL_2
+    if (MP_STATE_VM(mp_optimise_value) >= 2) {
+        if (fold_constants_opt2(parser, rule_id, num_args, &arg0)) {
+            for (size_t i = num_args; i > 0; i--) {
+                pop_result(parser);
+            }
+            push_result_node(parser, make_node_const_object_opt2(parser, arg0));
+            return true;
+        }
+        if (rule_id == RULE_import_from && MP_STATE_VM(parse_module_consts) != MP_OBJ_NULL) {
+            add_imported_module_consts(parser, peek_result(parser, 1), peek_result(parser, 0));
+            return false;
+        }
+    }
+    #endif
+
     if (rule_id == RULE_expr
         || rule_id == RULE_xor_expr
         || rule_id == RULE_and_expr
@@ -1381,4 +1665,28 @@ void mp_parse_tree_clear(mp_parse_tree_t *tree) {
     tree->chunk = NULL; // Avoid dangling pointer that may live on stack
 }
 
+#if MICROPY_COMP_OPT_LEVEL_2
+void mp_parse_define_module_const(qstr name, mp_lexer_t *lex) {
+    qstr source_name = lex->source_name;
+    mp_parse_tree_t tree = mp_parse(lex, MP_PARSE_EVAL_INPUT);
+    mp_parse_node_t pn = tree.root;
+    if (MP_PARSE_NODE_IS_STRUCT_KIND(pn, RULE_eval_input)) {
+        pn = ((mp_parse_node_struct_t *)pn)->nodes[0];
+    }
+    if (!mp_parse_node_is_const(pn)) {
+        mp_obj_t exc = mp_obj_new_exception_msg(&mp_type_SyntaxError, MP_ERROR_TEXT("not a constant"));
+        mp_obj_exception_add_traceback(exc, source_name, 1, MP_QSTRnull);
+        nlr_raise(exc);
+    }
+    if (MP_STATE_VM(parse_module_consts) == MP_OBJ_NULL) {
+        MP_STATE_VM(parse_module_consts) = mp_obj_new_dict(0);
+    }
+    mp_obj_dict_store(MP_STATE_VM(parse_module_consts), MP_OBJ_NEW_QSTR(name), mp_parse_node_convert_to_obj(pn));
+    mp_parse_tree_clear(&tree);
+}
+
+// Constants defined by mp_parse_define_module_const, mapping "<module>.<name>" to value.
+MP_REGISTER_ROOT_POINTER(mp_obj_t parse_module_consts);
+#endif
+
 #endif // MICROPY_ENABLE_COMPILER
@@ -113,4 +113,13 @@ typedef struct _mp_parse_t {
 mp_parse_tree_t mp_parse(struct _mp_lexer_t *lex, mp_parse_input_kind_t input_kind);
 void mp_parse_tree_clear(mp_parse_tree_t *tree);
 
+#if MICROPY_COMP_OPT_LEVEL_2
+// Define <name>, of the form "<module>.<attr>", as a constant with the value of
+// the constant expression read from lex.  When compiling at optimisation level 2
+// or higher, "from <module> import <attr>" then makes <attr> a constant within
+// the importing module, in the same way as "<attr> = const(<value>)" would.
+// The parser will free the lexer before this function returns.
+void mp_parse_define_module_const(qstr name, struct _mp_lexer_t *lex);
+#endif
+
 #endif // MICROPY_INCLUDED_PY_PARSE_H
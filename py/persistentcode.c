@@ -284,6 +284,74 @@ static mp_obj_t load_obj(mp_reader_t *reader) {
     }
 }
 
+#if MICROPY_PERSISTENT_CODE_LAZY
+
+#if MICROPY_PERSISTENT_CODE_SAVE
+#error "MICROPY_PERSISTENT_CODE_LAZY is incompatible with MICROPY_PERSISTENT_CODE_SAVE"
+#endif
+
+// The functions below work directly on a memory-mapped .mpy file, which holds
+// bytecode only (see mp_raw_code_load) and was checked to be well formed when
+// it was loaded.
+
+static size_t read_uint_rom(const byte **ptr) {
+    size_t unum = 0;
+    for (;;) {
+        byte b = *(*ptr)++;
+        unum = (unum << 7) | (b & 0x7f);
+        if ((b & 0x80) == 0) {
+            break;
+        }
+    }
+    return unum;
+}
+
+static void skip_raw_code_rom(const byte **ptr) {
+    size_t kind_len = read_uint_rom(ptr);
+    *ptr += kind_len >> 3;
+    if (kind_len & 4) {
+        for (size_t n_children = read_uint_rom(ptr); n_children > 0; --n_children) {
+            skip_raw_code_rom(ptr);
+        }
+    }
+}
+
+// Get the proto-function for the raw code at *ptr, and move past it.  A function
+// with no children is just its bytecode, otherwise its children are loaded by
+// mp_raw_code_load_lazy when it's first made into a function object.
+static mp_proto_fun_t load_raw_code_rom(const byte **ptr) {
+    const byte *start = *ptr;
+    size_t kind_len = read_uint_rom(ptr);
+    const byte *fun_data = *ptr;
+    *ptr += kind_len >> 3;
+    if (!(kind_len & 4)) {
+        return fun_data;
+    }
+    *ptr = start;
+    skip_raw_code_rom(ptr);
+    mp_raw_code_t *rc = mp_emit_glue_new_raw_code();
+    rc->kind = MP_CODE_BYTECODE_LAZY;
+    rc->fun_data = start;
+    return rc;
+}
+
+void mp_raw_code_load_lazy(mp_raw_code_t *rc) {
+    const byte *ptr = rc->fun_data;
+    size_t kind_len = read_uint_rom(&ptr);
+    const byte *fun_data = ptr;
+    ptr += kind_len >> 3;
+    size_t n_children = read_uint_rom(&ptr);
+    mp_raw_code_t **children = m_new(mp_raw_code_t *, n_children);
+    for (size_t i = 0; i < n_children; ++i) {
+        children[i] = (mp_raw_code_t *)load_raw_code_rom(&ptr);
+    }
+    const byte *ip = fun_data;
+    MP_BC_PRELUDE_SIG_DECODE(ip);
+    mp_emit_glue_assign_bytecode(rc, fun_data, children, scope_flags);
+}
+
+#endif // MICROPY_PERSISTENT_CODE_LAZY
+
 static mp_raw_code_t *load_raw_code(mp_reader_t *reader, mp_module_context_t *context) {
     // Load function kind and data length
     size_t kind_len = read_uint(reader);
@@ -464,7 +532,8 @@ void mp_raw_code_load(mp_reader_t *reader, mp_compiled_module_t *cm) {
     read_bytes(reader, header, sizeof(header));
     byte arch = MPY_FEATURE_DECODE_ARCH(header[2]);
     if (header[0] != 'M'
-        || header[1] != MPY_VERSION
+        || header[1] < MPY_VERSION_MIN
+        || header[1] > MPY_VERSION
         || (arch != MP_NATIVE_ARCH_NONE && MPY_FEATURE_DECODE_SUB_VERSION(header[2]) != MPY_SUB_VERSION)
         || header[3] > MP_SMALL_INT_BITS) {
         mp_raise_ValueError(MP_ERROR_TEXT("incompatible .mpy file"));
@@ -496,7 +565,18 @@ void mp_raw_code_load(mp_reader_t *reader, mp_compiled_module_t *cm) {
     }
 
     // Load top-level module.
-    cm->rc = load_raw_code(reader, cm->context);
+    #if MICROPY_PERSISTENT_CODE_LAZY
+    const byte *rom = mp_reader_try_read_rom(reader, 0);
+    if (rom != NULL && arch == MP_NATIVE_ARCH_NONE) {
+        // Bytecode in ROM, so leave each function until it's needed.
+        const byte *ptr = rom;
+        cm->rc = load_raw_code_rom(&ptr);
+        mp_reader_try_read_rom(reader, ptr - rom);
+    } else
+    #endif
+    {
+        cm->rc = load_raw_code(reader, cm->context);
+    }
 
     #if MICROPY_PERSISTENT_CODE_SAVE
     cm->has_native = MPY_FEATURE_DECODE_ARCH(header[2]) != MP_NATIVE_ARCH_NONE;
@@ -844,6 +924,7 @@ mp_obj_t mp_raw_code_save_fun_to_bytes(const mp_module_constants_t *consts, cons
     // Skip pass source code info and cell info.
     // Then ip points to the start of the opcodes.
     ip += n_info + n_cell;
+    const byte *ip_opcodes = ip;
 
     // Decode bytecode.
     while (ip < fun_data_top) {
@@ -898,7 +979,20 @@ mp_obj_t mp_raw_code_save_fun_to_bytes(const mp_module_constants_t *consts, cons
     mp_print_uint(&print, fun_data_len << 3);
 
     // Save function code.
+    #if MICROPY_OPT_QUICKENING
+    // The VM may have specialised some opcodes in place, so save the generic
+    // opcode that each was derived from.
+    mp_print_bytes(&print, fun_data, ip_opcodes - fun_data);
+    for (ip = ip_opcodes; ip < fun_data_top;) {
+        mp_opcode_t op = mp_opcode_decode(ip);
+        byte opcode = mp_bc_quicken_generic(op.opcode);
+        mp_print_bytes(&print, &opcode, 1);
+        mp_print_bytes(&print, ip + 1, op.size - 1);
+        ip += op.size;
+    }
+    #else
     mp_print_bytes(&print, fun_data, fun_data_len);
+    #endif
 
     // Create and return bytes representing the .mpy data.
     return mp_obj_new_bytes_from_vstr(&vstr);
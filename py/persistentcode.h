@@ -34,9 +34,13 @@
 // as long as MPY_VERSION matches, but a native .mpy (i.e. one with an arch
 // set) must also match MPY_SUB_VERSION. This allows 3 additional updates to
 // the native ABI per bytecode revision.
-#define MPY_VERSION 6
+#define MPY_VERSION 7
 #define MPY_SUB_VERSION 3
 
+// The oldest .mpy version that can still be loaded.  Version 7 only added new
+// opcodes (the superinstructions) to version 6, so version 6 files are valid.
+#define MPY_VERSION_MIN 6
+
 // Macros to encode/decode sub-version to/from the feature byte. This replaces
 // the bits previously used to encode the flags (map caching and unicode)
 // which are no longer used starting at .mpy version 6.
@@ -118,6 +122,7 @@ enum {
 void mp_raw_code_load(mp_reader_t *reader, mp_compiled_module_t *ctx);
 void mp_raw_code_load_mem(const byte *buf, size_t len, mp_compiled_module_t *ctx);
 void mp_raw_code_load_file(qstr filename, mp_compiled_module_t *ctx);
+void mp_raw_code_load_lazy(mp_raw_code_t *rc);
 
 void mp_raw_code_save(mp_compiled_module_t *cm, mp_print_t *print);
 void mp_raw_code_save_file(mp_compiled_module_t *cm, qstr filename);
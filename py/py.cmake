@@ -38,6 +38,8 @@ set(MICROPY_SOURCE_PY
     ${MICROPY_PY_DIR}/formatfloat.c
     ${MICROPY_PY_DIR}/frozenmod.c
     ${MICROPY_PY_DIR}/gc.c
+    ${MICROPY_PY_DIR}/gcprofile.c
+    ${MICROPY_PY_DIR}/callprofile.c
     ${MICROPY_PY_DIR}/lexer.c
     ${MICROPY_PY_DIR}/malloc.c
     ${MICROPY_PY_DIR}/map.c
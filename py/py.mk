@@ -94,6 +94,8 @@ PY_CORE_O_BASENAME = $(addprefix py/,\
 	nlrsetjmp.o \
 	malloc.o \
 	gc.o \
+	gcprofile.o \
+	callprofile.o \
 	pystack.o \
 	qstr.o \
 	vstr.o \
@@ -60,13 +60,19 @@
 // allocated pool is twice this size.  The value here must be <= MP_QSTRnumber_of.
 #define MICROPY_ALLOC_QSTR_ENTRIES_INIT (10)
 
-// this must match the equivalent function in makeqstrdata.py
-size_t qstr_compute_hash(const byte *data, size_t len) {
+// Initial number of slots in the qstr index, a power of 2.
+#define MICROPY_ALLOC_QSTR_INDEX_INIT (32)
+
+static inline size_t qstr_compute_hash_unmasked(const byte *data, size_t len) {
     // djb2 algorithm; see http://www.cse.yorku.ca/~oz/hash.html
     size_t hash = 5381;
     for (const byte *top = data + len; data < top; data++) {
         hash = ((hash << 5) + hash) ^ (*data); // hash * 33 ^ data
     }
+    return hash;
+}
+
+static inline size_t qstr_mask_hash(size_t hash) {
     hash &= Q_HASH_MASK;
     // Make sure that valid hash is never zero, zero means "hash not computed"
     if (hash == 0) {
@@ -75,6 +81,11 @@ size_t qstr_compute_hash(const byte *data, size_t len) {
     return hash;
 }
 
+// this must match the equivalent function in makeqstrdata.py
+size_t qstr_compute_hash(const byte *data, size_t len) {
+    return qstr_mask_hash(qstr_compute_hash_unmasked(data, len));
+}
+
 // The first pool is the static qstr table. The contents must remain stable as
 // it is part of the .mpy ABI. See the top of py/persistentcode.c and
 // static_qstr_list in makeqstrdata.py. This pool is unsorted (although in a
@@ -181,6 +192,10 @@ extern const qstr_pool_t MICROPY_QSTR_EXTRA_POOL;
 void qstr_init(void) {
     MP_STATE_VM(last_pool) = (qstr_pool_t *)&CONST_POOL; // we won't modify the const_pool since it has no allocated room left
     MP_STATE_VM(qstr_last_chunk) = NULL;
+    #if MICROPY_QSTR_INDEX
+    MP_STATE_VM(qstr_index) = NULL;
+    MP_STATE_VM(qstr_index_alloc) = 0;
+    #endif
 
     #if MICROPY_PY_THREAD && !MICROPY_PY_THREAD_GIL
     mp_thread_mutex_init(&MP_STATE_VM(qstr_mutex));
@@ -199,10 +214,85 @@ static const qstr_pool_t *find_qstr(qstr *q) {
     return pool;
 }
 
+#if MICROPY_QSTR_INDEX
+// The qstrs interned at runtime, from QSTR_INDEX_FIRST on, are indexed by an
+// open-addressing table of (qstr - QSTR_INDEX_FIRST + 1), with 0 for an empty
+// slot, probed linearly from the unmasked hash.  It is kept at most half full
+// and is rebuilt at double the size when it gets there.  If the allocation
+// fails then qstr_find_strn scans the runtime pools instead, until the next
+// time the index would have doubled.
+#define QSTR_INDEX_FIRST (CONST_POOL.total_prev_len + CONST_POOL.len)
+
+static void qstr_index_insert(qstr_index_t *index, size_t hash, qstr q) {
+    size_t mask = index->alloc - 1;
+    size_t i = hash & mask;
+    while (index->slots[i] != 0) {
+        i = (i + 1) & mask;
+    }
+    index->slots[i] = q - QSTR_INDEX_FIRST + 1;
+}
+
+// qstr_mutex must be taken while in this function
+static void qstr_index_add(qstr q, size_t hash) {
+    size_t n = q - QSTR_INDEX_FIRST + 1;
+    size_t alloc = MP_STATE_VM(qstr_index_alloc);
+    if (n * 2 <= alloc) {
+        if (MP_STATE_VM(qstr_index) != NULL) {
+            qstr_index_insert(MP_STATE_VM(qstr_index), hash, q);
+        }
+        return;
+    }
+
+    // Lookups don't take qstr_mutex, so the old index is left for the GC
+    // rather than freed, in case another thread is still probing it
+    MP_STATE_VM(qstr_index) = NULL;
+    if (n >= 0xffff) {
+        // the entries no longer fit in a qstr_short_t, so stop indexing
+        MP_STATE_VM(qstr_index_alloc) = (size_t)-1;
+        return;
+    }
+    alloc = alloc == 0 ? MICROPY_ALLOC_QSTR_INDEX_INIT : alloc * 2;
+    MP_STATE_VM(qstr_index_alloc) = alloc;
+    qstr_index_t *index = m_new_obj_var_maybe(qstr_index_t, slots, qstr_short_t, alloc);
+    if (index == NULL) {
+        return;
+    }
+    index->alloc = alloc;
+    memset(index->slots, 0, alloc * sizeof(qstr_short_t));
+    for (const qstr_pool_t *pool = MP_STATE_VM(last_pool); pool != &CONST_POOL; pool = pool->prev) {
+        for (size_t at = 0; at < pool->len; at++) {
+            size_t h = qstr_compute_hash_unmasked((const byte *)pool->qstrs[at], pool->lengths[at]);
+            qstr_index_insert(index, h, pool->total_prev_len + at);
+        }
+    }
+    MP_STATE_VM(qstr_index) = index;
+}
+
+static qstr qstr_index_find(const qstr_index_t *index, const char *str, size_t str_len, size_t hash) {
+    size_t mask = index->alloc - 1;
+    for (size_t i = hash & mask; index->slots[i] != 0; i = (i + 1) & mask) {
+        qstr q = QSTR_INDEX_FIRST + index->slots[i] - 1;
+        size_t len;
+        const byte *data = qstr_data(q, &len);
+        if (len == str_len && memcmp(data, str, str_len) == 0) {
+            return q;
+        }
+    }
+    return MP_QSTRnull;
+}
+#endif
+
 // qstr_mutex must be taken while in this function
 static qstr qstr_add(mp_uint_t len, const char *q_ptr) {
+    #if MICROPY_QSTR_INDEX
+    size_t full_hash = qstr_compute_hash_unmasked((const byte *)q_ptr, len);
+    #endif
     #if MICROPY_QSTR_BYTES_IN_HASH
+    #if MICROPY_QSTR_INDEX
+    mp_uint_t hash = qstr_mask_hash(full_hash);
+    #else
     mp_uint_t hash = qstr_compute_hash((const byte *)q_ptr, len);
+    #endif
     DEBUG_printf("QSTR: add hash=%d len=%d data=%.*s\n", hash, len, len, q_ptr);
     #else
     DEBUG_printf("QSTR: add len=%d data=%.*s\n", len, len, q_ptr);
@@ -254,9 +344,14 @@ static qstr qstr_add(mp_uint_t len, const char *q_ptr) {
     MP_STATE_VM(last_pool)->lengths[at] = len;
     MP_STATE_VM(last_pool)->qstrs[at] = q_ptr;
     MP_STATE_VM(last_pool)->len++;
+    qstr q = MP_STATE_VM(last_pool)->total_prev_len + at;
+
+    #if MICROPY_QSTR_INDEX
+    qstr_index_add(q, full_hash);
+    #endif
 
     // return id for the newly-added qstr
-    return MP_STATE_VM(last_pool)->total_prev_len + at;
+    return q;
 }
 
 qstr qstr_find_strn(const char *str, size_t str_len) {
@@ -265,13 +360,28 @@ qstr qstr_find_strn(const char *str, size_t str_len) {
         return MP_QSTR_;
     }
 
+    // search pools for the data, starting with the runtime ones
+    const qstr_pool_t *pool = MP_STATE_VM(last_pool);
+
+    #if MICROPY_QSTR_INDEX
+    size_t full_hash = qstr_compute_hash_unmasked((const byte *)str, str_len);
+    const qstr_index_t *index = MP_STATE_VM(qstr_index);
+    if (index != NULL) {
+        qstr q = qstr_index_find(index, str, str_len, full_hash);
+        if (q != MP_QSTRnull) {
+            return q;
+        }
+        pool = &CONST_POOL;
+    }
     #if MICROPY_QSTR_BYTES_IN_HASH
+    size_t str_hash = qstr_mask_hash(full_hash);
+    #endif
+    #elif MICROPY_QSTR_BYTES_IN_HASH
     // work out hash of str
     size_t str_hash = qstr_compute_hash((const byte *)str, str_len);
     #endif
 
-    // search pools for the data
-    for (const qstr_pool_t *pool = MP_STATE_VM(last_pool); pool != NULL; pool = pool->prev) {
+    for (; pool != NULL; pool = pool->prev) {
         size_t low = 0;
         size_t high = pool->len - 1;
 
@@ -438,6 +548,11 @@ void qstr_pool_info(size_t *n_pool, size_t *n_qstr, size_t *n_str_data_bytes, si
                 + sizeof(qstr_len_t)) * pool->alloc;
         #endif
     }
+    #if MICROPY_QSTR_INDEX
+    if (MP_STATE_VM(qstr_index) != NULL) {
+        *n_total_bytes += sizeof(qstr_index_t) + MP_STATE_VM(qstr_index)->alloc * sizeof(qstr_short_t);
+    }
+    #endif
     *n_total_bytes += *n_str_data_bytes;
     QSTR_EXIT();
 }
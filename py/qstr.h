@@ -91,6 +91,13 @@ typedef struct _qstr_pool_t {
     const char *qstrs[];
 } qstr_pool_t;
 
+#if MICROPY_QSTR_INDEX
+typedef struct _qstr_index_t {
+    size_t alloc; // a power of 2
+    qstr_short_t slots[];
+} qstr_index_t;
+#endif
+
 #define QSTR_TOTAL() (MP_STATE_VM(last_pool)->total_prev_len + MP_STATE_VM(last_pool)->len)
 
 void qstr_init(void);
@@ -71,8 +71,18 @@ MP_REGISTER_MODULE(MP_QSTR___main__, mp_module___main__);
 void mp_init(void) {
     qstr_init();
 
+    #if MICROPY_OPT_INLINE_CACHE && MICROPY_PY_THREAD && !MICROPY_PY_THREAD_GIL
+    mp_thread_mutex_init(&MP_STATE_VM(inline_cache_mutex));
+    #endif
+
     // no pending exceptions to start with
     MP_STATE_THREAD(mp_pending_exception) = MP_OBJ_NULL;
+
+    #if MICROPY_VM_FRAME_CACHE && !MICROPY_ENABLE_PYSTACK
+    // any cached frames were on the old heap
+    memset(MP_STATE_THREAD(frame_cache), 0, sizeof(MP_STATE_THREAD(frame_cache)));
+    memset(MP_STATE_THREAD(frame_cache_len), 0, sizeof(MP_STATE_THREAD(frame_cache_len)));
+    #endif
     #if MICROPY_ENABLE_SCHEDULER
     // no pending callbacks to start with
     MP_STATE_VM(sched_state) = MP_SCHED_IDLE;
@@ -127,6 +137,10 @@ void mp_init(void) {
     MP_STATE_VM(persistent_code_root_pointers) = MP_OBJ_NULL;
     #endif
 
+    #if MICROPY_OPT_INSTANCE_SHAPES
+    MP_STATE_VM(instance_shapes) = NULL;
+    #endif
+
     #if MICROPY_PY_OS_DUPTERM
     for (size_t i = 0; i < MICROPY_PY_OS_DUPTERM; ++i) {
         MP_STATE_VM(dupterm_objs[i]) = MP_OBJ_NULL;
@@ -164,9 +178,15 @@ void mp_init(void) {
     #if MICROPY_PY_SYS_SETTRACE
     MP_STATE_THREAD(prof_trace_callback) = MP_OBJ_NULL;
     MP_STATE_THREAD(prof_callback_is_executing) = false;
+    #endif
+    #if MICROPY_TRACK_CODE_STATE
     MP_STATE_THREAD(current_code_state) = NULL;
     #endif
 
+    #if MICROPY_CALL_PROFILE
+    MP_STATE_VM(call_profile_enabled) = false;
+    #endif
+
     #if MICROPY_PY_SYS_TRACEBACKLIMIT
     MP_STATE_VM(sys_mutable[MP_SYS_MUTABLE_TRACEBACKLIMIT]) = MP_OBJ_NEW_SMALL_INT(1000);
     #endif
@@ -168,6 +168,19 @@ static inline void mp_thread_init_state(mp_state_thread_t *ts, size_t stack_size
     ts->nlr_jump_callback_top = NULL;
     ts->mp_pending_exception = MP_OBJ_NULL;
 
+    #if MICROPY_TRACK_CODE_STATE
+    // No bytecode is running in this thread yet
+    ts->current_code_state = NULL;
+    #endif
+
+    #if MICROPY_VM_FRAME_CACHE && !MICROPY_ENABLE_PYSTACK
+    // No frames are cached yet
+    for (size_t i = 0; i < MICROPY_VM_FRAME_CACHE_CLASSES; ++i) {
+        ts->frame_cache[i] = NULL;
+        ts->frame_cache_len[i] = 0;
+    }
+    #endif
+
     // If locals/globals are not given, inherit from main thread
     if (locals == NULL) {
         locals = mp_state_ctx.thread.dict_locals;
@@ -526,6 +526,36 @@ const byte *mp_bytecode_print_str(const mp_print_t *print, const byte *ip_start,
             mp_printf(print, "IMPORT_STAR");
             break;
 
+        case MP_BC_LOAD_FAST_0_ATTR:
+            DECODE_QSTR;
+            mp_printf(print, "LOAD_FAST_0_ATTR %s", qstr_str(qst));
+            break;
+
+        case MP_BC_LOAD_FAST_2:
+            DECODE_UINT;
+            mp_printf(print, "LOAD_FAST_2 " UINT_FMT " " UINT_FMT, unum >> 4, unum & 0xf);
+            break;
+
+        case MP_BC_INPLACE_ADD_FAST:
+            DECODE_UINT;
+            mp_printf(print, "INPLACE_ADD_FAST " UINT_FMT " " UINT_FMT, unum & 0xf, unum >> 4);
+            break;
+
+        case MP_BC_INPLACE_SUBTRACT_FAST:
+            DECODE_UINT;
+            mp_printf(print, "INPLACE_SUBTRACT_FAST " UINT_FMT " " UINT_FMT, unum & 0xf, unum >> 4);
+            break;
+
+        case MP_BC_BINARY_OP_POP_JUMP_IF: {
+            DECODE_SLABEL;
+            mp_uint_t op = *ip & ~MP_BC_BINARY_OP_POP_JUMP_IF_TRUE_FLAG;
+            mp_printf(print, "BINARY_OP_POP_JUMP_IF_%s " UINT_FMT " " UINT_FMT " %s",
+                (*ip & MP_BC_BINARY_OP_POP_JUMP_IF_TRUE_FLAG) ? "TRUE" : "FALSE",
+                (mp_uint_t)(ip + unum - ip_start), op, qstr_str(mp_binary_op_method_name[op]));
+            ip += 1;
+            break;
+        }
+
         default:
             if (ip[-1] < MP_BC_LOAD_CONST_SMALL_INT_MULTI + 64) {
                 mp_printf(print, "LOAD_CONST_SMALL_INT " INT_FMT, (mp_int_t)ip[-1] - MP_BC_LOAD_CONST_SMALL_INT_MULTI - 16);
@@ -30,9 +30,13 @@
 #include <assert.h>
 
 #include "py/emitglue.h"
+#include "py/gc.h"
+#include "py/objlist.h"
+#include "py/objtuple.h"
 #include "py/objtype.h"
 #include "py/objfun.h"
 #include "py/runtime.h"
+#include "py/smallint.h"
 #include "py/bc0.h"
 #include "py/profile.h"
 
@@ -187,6 +191,24 @@
     } \
 } while(0)
 
+#elif MICROPY_TRACK_CODE_STATE
+
+// Just keep track of the current code state, for the heap profiler
+#define FRAME_SETUP() do { \
+    MP_STATE_THREAD(current_code_state) = code_state; \
+} while(0)
+
+#define FRAME_ENTER() do { \
+    code_state->prev_state = MP_STATE_THREAD(current_code_state); \
+} while(0)
+
+#define FRAME_LEAVE() do { \
+    MP_STATE_THREAD(current_code_state) = code_state->prev_state; \
+} while(0)
+
+#define FRAME_UPDATE()
+#define TRACE_TICK(current_ip, current_sp, is_exception)
+
 #else // MICROPY_PY_SYS_SETTRACE
 #define FRAME_SETUP()
 #define FRAME_ENTER()
@@ -195,6 +217,382 @@
 #define TRACE_TICK(current_ip, current_sp, is_exception)
 #endif // MICROPY_PY_SYS_SETTRACE
 
+#if MICROPY_OPT_INLINE_CACHE
+
+// Each bytecode function gets a direct-mapped cache indexed by the offset of the
+// LOAD_GLOBAL/LOAD_ATTR/LOAD_METHOD argument.  An entry is only a hint and is
+// checked before use: a map slot must still hold the name, and a method is only
+// reused for the same type and name while MP_STATE_VM(inline_cache_epoch) is
+// unchanged, and (for instances) if the instance doesn't shadow it.  So entries
+// shared by two sites, or gone stale, just fall back to the normal lookup.
+//
+// Entries are updated with single word (or half word) stores, and methods are
+// put in a new immutable mp_inline_cache_method_t, so that without a GIL a
+// thread can't see a half-written entry.  In that case the cache is also never
+// replaced once attached to a function, rather than starting small and doubling
+// in size when two sites collide.
+
+#define INLINE_CACHE_NO_GIL (MICROPY_PY_THREAD && !MICROPY_PY_THREAD_GIL)
+#define INLINE_CACHE_MIN_ENTRIES (INLINE_CACHE_NO_GIL ? MICROPY_OPT_INLINE_CACHE_MAX_ENTRIES : 4)
+#define INLINE_CACHE_SLOT_NONE (0xffff)
+#define INLINE_CACHE_SLOT_BUILTIN (0xfffe)
+#define INLINE_CACHE_METHOD_MISSES (8)
+
+static inline mp_inline_cache_entry_t *inline_cache_get(mp_code_state_t *code_state, const byte *ip) {
+    mp_inline_cache_t *cache = code_state->fun_bc->inline_cache;
+    if (cache == NULL) {
+        return NULL;
+    }
+    return &cache->entry[(size_t)(ip - code_state->fun_bc->bytecode) & cache->mask];
+}
+
+// Returns the entry to fill in for the given site, or NULL if there is none.
+// Must not raise, because the heap may be locked.
+static mp_inline_cache_entry_t *inline_cache_claim(mp_code_state_t *code_state, const byte *ip) {
+    mp_obj_fun_bc_t *fun = code_state->fun_bc;
+    uint16_t offset = ip - fun->bytecode;
+    mp_inline_cache_t *cache = fun->inline_cache;
+    size_t n = INLINE_CACHE_MIN_ENTRIES;
+    if (cache != NULL) {
+        mp_inline_cache_entry_t *e = &cache->entry[offset & cache->mask];
+        if (e->offset == 0 || e->offset == offset || cache->mask + 1 >= MICROPY_OPT_INLINE_CACHE_MAX_ENTRIES) {
+            if (e->offset != offset) {
+                e->offset = offset;
+                e->slot = INLINE_CACHE_SLOT_NONE;
+            }
+            return e;
+        }
+        n = (cache->mask + 1) * 2;
+    }
+    mp_inline_cache_t *new_cache = m_malloc_maybe(sizeof(mp_inline_cache_t) + n * sizeof(mp_inline_cache_entry_t));
+    if (new_cache == NULL) {
+        return NULL;
+    }
+    memset(new_cache, 0, sizeof(mp_inline_cache_t) + n * sizeof(mp_inline_cache_entry_t));
+    new_cache->mask = n - 1;
+    #if INLINE_CACHE_NO_GIL
+    mp_thread_mutex_lock(&MP_STATE_VM(inline_cache_mutex), 1);
+    if (fun->inline_cache == NULL) {
+        fun->inline_cache = new_cache;
+    }
+    cache = fun->inline_cache;
+    mp_thread_mutex_unlock(&MP_STATE_VM(inline_cache_mutex));
+    if (cache != new_cache) {
+        // another thread attached a cache first
+        m_del(byte, new_cache, sizeof(mp_inline_cache_t) + n * sizeof(mp_inline_cache_entry_t));
+        return inline_cache_claim(code_state, ip);
+    }
+    #else
+    if (cache != NULL) {
+        for (size_t i = 0; i <= cache->mask; ++i) {
+            if (cache->entry[i].offset != 0) {
+                new_cache->entry[cache->entry[i].offset & new_cache->mask] = cache->entry[i];
+            }
+        }
+        m_del(byte, cache, sizeof(mp_inline_cache_t) + (cache->mask + 1) * sizeof(mp_inline_cache_entry_t));
+    }
+    fun->inline_cache = new_cache;
+    #endif
+    mp_inline_cache_entry_t *e = &new_cache->entry[offset & new_cache->mask];
+    e->offset = offset;
+    e->slot = INLINE_CACHE_SLOT_NONE;
+    e->method = NULL;
+    return e;
+}
+
+// Look up a name in a map, trying the slot remembered for this site first.
+static mp_map_elem_t *inline_cache_map_lookup(mp_code_state_t *code_state, const byte *ip, mp_map_t *map, qstr qst) {
+    mp_obj_t key = MP_OBJ_NEW_QSTR(qst);
+    mp_inline_cache_entry_t *e = inline_cache_get(code_state, ip);
+    if (e != NULL && e->slot < map->alloc && map->table[e->slot].key == key) {
+        return &map->table[e->slot];
+    }
+    mp_map_elem_t *elem = mp_map_lookup(map, key, MP_MAP_LOOKUP);
+    if (elem != NULL && (size_t)(elem - map->table) < INLINE_CACHE_SLOT_BUILTIN) {
+        e = inline_cache_claim(code_state, ip);
+        if (e != NULL) {
+            e->slot = elem - map->table;
+        }
+    }
+    return elem;
+}
+
+static mp_obj_t inline_cache_load_global(mp_code_state_t *code_state, const byte *ip, qstr qst) {
+    mp_inline_cache_entry_t *e = inline_cache_get(code_state, ip);
+    if (e == NULL || e->slot != INLINE_CACHE_SLOT_BUILTIN) {
+        mp_map_elem_t *elem = inline_cache_map_lookup(code_state, ip, &mp_globals_get()->map, qst);
+        if (elem != NULL) {
+            return elem->value;
+        }
+        e = inline_cache_claim(code_state, ip);
+        if (e != NULL) {
+            e->slot = INLINE_CACHE_SLOT_BUILTIN;
+        }
+    }
+    // found in builtins last time, let mp_load_global do the full lookup
+    return mp_load_global(qst);
+}
+
+// Look up an attribute stored in an instance.  The slot remembered for this site
+// is an index into the values of a shaped instance, or into its members map.
+static mp_obj_t *inline_cache_instance_lookup(mp_code_state_t *code_state, const byte *ip, mp_obj_instance_t *self, qstr qst) {
+    #if MICROPY_OPT_INSTANCE_SHAPES
+    const mp_obj_instance_shape_t *shape = self->shape;
+    if (shape != NULL) {
+        mp_inline_cache_entry_t *e = inline_cache_get(code_state, ip);
+        if (e != NULL && e->slot < shape->n_attrs && shape->attrs[e->slot] == qst) {
+            return &self->values[e->slot];
+        }
+        mp_obj_t *value = mp_obj_instance_lookup_member(self, qst);
+        if (value != NULL) {
+            e = inline_cache_claim(code_state, ip);
+            if (e != NULL) {
+                e->slot = value - self->values;
+            }
+        }
+        return value;
+    }
+    mp_map_elem_t *elem = inline_cache_map_lookup(code_state, ip, self->members, qst);
+    #else
+    mp_map_elem_t *elem = inline_cache_map_lookup(code_state, ip, &self->members, qst);
+    #endif
+    return elem != NULL ? &elem->value : NULL;
+}
+
+#if MICROPY_OPT_INSTANCE_SHAPES
+// Replace the value of an attribute that a shaped instance already has, if its
+// class doesn't intercept stores.  Returns false to use mp_store_attr instead,
+// which is also how attributes are deleted (value is MP_OBJ_NULL).
+static bool inline_cache_store_attr(mp_code_state_t *code_state, const byte *ip, mp_obj_t base, qstr qst, mp_obj_t value) {
+    const mp_obj_type_t *type = mp_obj_get_type(base);
+    if (value == MP_OBJ_NULL || !mp_obj_is_instance_type(type) || (type->flags & MP_TYPE_FLAG_HAS_SPECIAL_ACCESSORS)) {
+        return false;
+    }
+    mp_obj_instance_t *self = MP_OBJ_TO_PTR(base);
+    if (self->shape == NULL) {
+        return false;
+    }
+    mp_obj_t *slot = inline_cache_instance_lookup(code_state, ip, self, qst);
+    if (slot == NULL) {
+        return false;
+    }
+    *slot = value;
+    return true;
+}
+#endif
+
+// Whether an instance contains the attribute qst, without recomputing its hash.
+static bool inline_cache_members_contain(mp_obj_instance_t *self, qstr qst, size_t hash) {
+    #if MICROPY_OPT_INSTANCE_SHAPES
+    if (self->shape != NULL) {
+        return mp_obj_instance_lookup_member(self, qst) != NULL;
+    }
+    mp_map_t *map = self->members;
+    #else
+    mp_map_t *map = &self->members;
+    #endif
+    if (map->alloc == 0) {
+        return false;
+    }
+    if (map->is_ordered || !map->all_keys_are_qstrs) {
+        return mp_map_lookup(map, MP_OBJ_NEW_QSTR(qst), MP_MAP_LOOKUP) != NULL;
+    }
+    mp_obj_t key = MP_OBJ_NEW_QSTR(qst);
+    for (size_t pos = hash % map->alloc, n = map->alloc; n > 0; --n) {
+        if (map->table[pos].key == key) {
+            return true;
+        } else if (map->table[pos].key == MP_OBJ_NULL) {
+            return false;
+        }
+        if (++pos == map->alloc) {
+            pos = 0;
+        }
+    }
+    return false;
+}
+
+static mp_obj_t inline_cache_load_attr(mp_code_state_t *code_state, const byte *ip, mp_obj_t base, qstr qst) {
+    // Only instance members and module globals are cached, which covers the
+    // vast majority of attribute loads that aren't method calls.
+    const mp_obj_type_t *type = mp_obj_get_type(base);
+    if (mp_obj_is_instance_type(type)) {
+        mp_obj_t *value = inline_cache_instance_lookup(code_state, ip, MP_OBJ_TO_PTR(base), qst);
+        if (value != NULL) {
+            return *value;
+        }
+    } else if (type == &mp_type_module && qst != MP_QSTR___class__) {
+        mp_map_elem_t *elem = inline_cache_map_lookup(code_state, ip, &((mp_obj_module_t *)MP_OBJ_TO_PTR(base))->globals->map, qst);
+        if (elem != NULL) {
+            return elem->value;
+        }
+    }
+    return mp_load_attr(base, qst);
+}
+
+static void inline_cache_load_method(mp_code_state_t *code_state, const byte *ip, mp_obj_t base, qstr qst, mp_obj_t *dest) {
+    const mp_obj_type_t *type = mp_obj_get_type(base);
+    if (type == &mp_type_module) {
+        if (qst != MP_QSTR___class__) {
+            mp_map_elem_t *elem = inline_cache_map_lookup(code_state, ip, &((mp_obj_module_t *)MP_OBJ_TO_PTR(base))->globals->map, qst);
+            if (elem != NULL) {
+                dest[0] = elem->value;
+                dest[1] = MP_OBJ_NULL;
+                return;
+            }
+        }
+        mp_load_method(base, qst, dest);
+        return;
+    }
+
+    mp_inline_cache_entry_t *e = inline_cache_get(code_state, ip);
+    const mp_inline_cache_method_t *method = e != NULL ? e->method : NULL;
+    if (method != NULL && method->type == type && method->qst == qst && method->epoch == MP_STATE_VM(inline_cache_epoch)
+        && (!mp_obj_is_instance_type(type)
+            || !inline_cache_members_contain(MP_OBJ_TO_PTR(base), qst, method->hash))) {
+        dest[0] = method->value;
+        dest[1] = base;
+        if (e->slot != 0) {
+            e->slot = 0;
+        }
+        return;
+    }
+
+    mp_load_method(base, qst, dest);
+
+    // Remember methods that were bound to base.  For instances this means a
+    // function found in the class hierarchy.  Other types must not have an attr
+    // slot, so the method depends only on the type (and its locals dict).
+    if (dest[1] == base && (mp_obj_is_instance_type(type) || !MP_OBJ_TYPE_HAS_SLOT(type, attr))) {
+        e = inline_cache_claim(code_state, ip);
+        if (e == NULL) {
+            return;
+        }
+        // Don't let a polymorphic site allocate on every call: a method that
+        // is still valid is only replaced after several misses in a row.
+        method = e->method;
+        if (method != NULL && method->epoch == MP_STATE_VM(inline_cache_epoch) && method->qst == qst
+            && e->slot < INLINE_CACHE_METHOD_MISSES) {
+            e->slot += 1;
+            return;
+        }
+        mp_inline_cache_method_t *new_method = m_new_maybe(mp_inline_cache_method_t, 1);
+        if (new_method != NULL) {
+            new_method->type = type;
+            new_method->qst = qst;
+            new_method->hash = qstr_hash(qst);
+            new_method->epoch = MP_STATE_VM(inline_cache_epoch);
+            new_method->value = dest[0];
+            e->method = new_method;
+            e->slot = 0;
+        }
+    }
+}
+
+#endif // MICROPY_OPT_INLINE_CACHE
+
+#if MICROPY_OPT_QUICKENING
+
+// Return whether the function's opcodes should now be specialised.  Calls are
+// counted by the callers of mp_execute_bytecode, so generator resumes aren't.
+static bool vm_quicken_enabled(const mp_obj_fun_bc_t *fun) {
+    return fun->quicken_count == MICROPY_OPT_QUICKENING_THRESHOLD;
+}
+
+// Binary operators that have specialised opcodes: operator, small int version
+// and float version (0 if there isn't one).
+static const byte quicken_binary_op_table[][3] = {
+    { MP_BINARY_OP_ADD, MP_BC_BINARY_OP_SMALL_INT_ADD, MP_BC_BINARY_OP_FLOAT_ADD },
+    { MP_BINARY_OP_SUBTRACT, MP_BC_BINARY_OP_SMALL_INT_SUBTRACT, MP_BC_BINARY_OP_FLOAT_SUBTRACT },
+    { MP_BINARY_OP_INPLACE_ADD, MP_BC_BINARY_OP_SMALL_INT_INPLACE_ADD, MP_BC_BINARY_OP_FLOAT_INPLACE_ADD },
+    { MP_BINARY_OP_INPLACE_SUBTRACT, MP_BC_BINARY_OP_SMALL_INT_INPLACE_SUBTRACT, MP_BC_BINARY_OP_FLOAT_INPLACE_SUBTRACT },
+    { MP_BINARY_OP_LESS, MP_BC_BINARY_OP_SMALL_INT_LESS, MP_BC_BINARY_OP_FLOAT_LESS },
+    { MP_BINARY_OP_MORE, MP_BC_BINARY_OP_SMALL_INT_MORE, MP_BC_BINARY_OP_FLOAT_MORE },
+    { MP_BINARY_OP_EQUAL, MP_BC_BINARY_OP_SMALL_INT_EQUAL, 0 },
+    { MP_BINARY_OP_LESS_EQUAL, MP_BC_BINARY_OP_SMALL_INT_LESS_EQUAL, 0 },
+    { MP_BINARY_OP_MORE_EQUAL, MP_BC_BINARY_OP_SMALL_INT_MORE_EQUAL, 0 },
+    { MP_BINARY_OP_NOT_EQUAL, MP_BC_BINARY_OP_SMALL_INT_NOT_EQUAL, 0 },
+    { MP_BINARY_OP_MULTIPLY, 0, MP_BC_BINARY_OP_FLOAT_MULTIPLY },
+    { MP_BINARY_OP_TRUE_DIVIDE, 0, MP_BC_BINARY_OP_FLOAT_TRUE_DIVIDE },
+    { MP_BINARY_OP_INPLACE_MULTIPLY, 0, MP_BC_BINARY_OP_FLOAT_INPLACE_MULTIPLY },
+    { MP_BINARY_OP_INPLACE_TRUE_DIVIDE, 0, MP_BC_BINARY_OP_FLOAT_INPLACE_TRUE_DIVIDE },
+};
+
+// Specialise a MP_BC_BINARY_OP_MULTI opcode for the types of its operands.
+static void vm_quicken_binary_op(byte *ip, mp_binary_op_t op, mp_obj_t lhs, mp_obj_t rhs) {
+    size_t kind;
+    if (mp_obj_is_small_int(lhs) && mp_obj_is_small_int(rhs)) {
+        kind = 1;
+    #if MICROPY_PY_BUILTINS_FLOAT
+    } else if (mp_obj_is_float(lhs) && mp_obj_is_float(rhs)) {
+        kind = 2;
+    #endif
+    } else {
+        return;
+    }
+    for (size_t i = 0; i < MP_ARRAY_SIZE(quicken_binary_op_table); ++i) {
+        if (quicken_binary_op_table[i][0] == op) {
+            if (quicken_binary_op_table[i][kind] != 0) {
+                *ip = quicken_binary_op_table[i][kind];
+            }
+            return;
+        }
+    }
+}
+
+// Specialise a MP_BC_LOAD_ATTR opcode if it loaded an instance member,
+// otherwise mark it so there are no further attempts.
+static byte vm_quicken_load_attr(mp_obj_t base, qstr qst) {
+    if (mp_obj_is_instance_type(mp_obj_get_type(base))
+        && mp_obj_instance_lookup_member(MP_OBJ_TO_PTR(base), qst) != NULL) {
+        return MP_BC_LOAD_ATTR_INSTANCE;
+    }
+    return MP_BC_LOAD_ATTR_UNSPECIALISED;
+}
+
+// Return the generic opcode that a specialised one was derived from, or the
+// opcode itself if it isn't specialised.
+byte mp_bc_quicken_generic(byte op) {
+    switch (op) {
+        case MP_BC_LOAD_ATTR_INSTANCE:
+        case MP_BC_LOAD_ATTR_UNSPECIALISED:
+            return MP_BC_LOAD_ATTR;
+        case MP_BC_LOAD_SUBSCR_SEQ:
+            return MP_BC_LOAD_SUBSCR;
+        case MP_BC_STORE_SUBSCR_LIST:
+            return MP_BC_STORE_SUBSCR;
+    }
+    for (size_t i = 0; i < MP_ARRAY_SIZE(quicken_binary_op_table); ++i) {
+        if (quicken_binary_op_table[i][1] == op || quicken_binary_op_table[i][2] == op) {
+            return MP_BC_BINARY_OP_MULTI + quicken_binary_op_table[i][0];
+        }
+    }
+    // not specialised, or already put back by another thread
+    return op;
+}
+
+#define QUICKEN_SMALL_INT_COMPARE(op) do { \
+    if (mp_obj_is_small_int(sp[-1]) && mp_obj_is_small_int(sp[0])) { \
+        sp -= 1; \
+        SET_TOP(mp_obj_new_bool(MP_OBJ_SMALL_INT_VALUE(sp[0]) op MP_OBJ_SMALL_INT_VALUE(sp[1]))); \
+        DISPATCH(); \
+    } \
+    goto quicken_deopt; \
+} while (0)
+
+#define QUICKEN_FLOAT_OP(result) do { \
+    MARK_EXC_IP_SELECTIVE(); \
+    if (mp_obj_is_float(sp[-1]) && mp_obj_is_float(sp[0])) { \
+        mp_float_t lhs_val = mp_obj_float_get(sp[-1]); \
+        mp_float_t rhs_val = mp_obj_float_get(sp[0]); \
+        sp -= 1; \
+        SET_TOP(result); \
+        DISPATCH(); \
+    } \
+    goto quicken_deopt; \
+} while (0)
+
+#endif // MICROPY_OPT_QUICKENING
+
 // fastn has items in reverse order (fastn[0] is local[0], fastn[-1] is local[1], etc)
 // sp points to bottom of stack which grows up
 // returns:
@@ -269,6 +667,11 @@ FRAME_SETUP();
         exc_stack = (mp_exc_stack_t*)(code_state->state + n_state);
     }
 
+    #if MICROPY_OPT_QUICKENING
+    // whether generic opcodes should be specialised as they are run
+    const bool quicken = vm_quicken_enabled(code_state->fun_bc);
+    #endif
+
     // variables that are visible to the exception handler (declared volatile)
     mp_exc_stack_t *volatile exc_sp = MP_CODE_STATE_EXC_SP_IDX_TO_PTR(exc_stack, code_state->exc_sp_idx); // stack grows up, exc_sp points to top of stack
 
@@ -387,42 +790,69 @@ dispatch_loop:
 
                 ENTRY(MP_BC_LOAD_GLOBAL): {
                     MARK_EXC_IP_SELECTIVE();
+                    #if MICROPY_OPT_INLINE_CACHE
+                    const byte *site = ip;
+                    DECODE_QSTR;
+                    PUSH(inline_cache_load_global(code_state, site, qst));
+                    #else
                     DECODE_QSTR;
                     PUSH(mp_load_global(qst));
+                    #endif
                     DISPATCH();
                 }
 
+                #if MICROPY_OPT_QUICKENING
+                ENTRY(MP_BC_LOAD_ATTR_UNSPECIALISED):
+                #endif
                 ENTRY(MP_BC_LOAD_ATTR): {
+                    load_attr:
                     FRAME_UPDATE();
                     MARK_EXC_IP_SELECTIVE();
+                    #if MICROPY_OPT_INLINE_CACHE || MICROPY_OPT_QUICKENING
+                    const byte *site = ip;
+                    #endif
                     DECODE_QSTR;
                     mp_obj_t top = TOP();
                     mp_obj_t obj;
+                    #if MICROPY_OPT_QUICKENING
+                    if (quicken && site[-1] == MP_BC_LOAD_ATTR) {
+                        *(byte *)(site - 1) = vm_quicken_load_attr(top, qst);
+                    }
+                    #endif
+                    #if MICROPY_OPT_INLINE_CACHE
+                    obj = inline_cache_load_attr(code_state, site, top, qst);
+                    #else
                     #if MICROPY_OPT_LOAD_ATTR_FAST_PATH
                     // For the specific case of an instance type, it implements .attr
                     // and forwards to its members map. Attribute lookups on instance
                     // types are extremely common, so avoid all the other checks and
                     // calls that normally happen first.
-                    mp_map_elem_t *elem = NULL;
+                    mp_obj_t *value = NULL;
                     if (mp_obj_is_instance_type(mp_obj_get_type(top))) {
-                        mp_obj_instance_t *self = MP_OBJ_TO_PTR(top);
-                        elem = mp_map_lookup(&self->members, MP_OBJ_NEW_QSTR(qst), MP_MAP_LOOKUP);
+                        value = mp_obj_instance_lookup_member(MP_OBJ_TO_PTR(top), qst);
                     }
-                    if (elem) {
-                        obj = elem->value;
+                    if (value) {
+                        obj = *value;
                     } else
                     #endif
                     {
                         obj = mp_load_attr(top, qst);
                     }
+                    #endif
                     SET_TOP(obj);
                     DISPATCH();
                 }
 
                 ENTRY(MP_BC_LOAD_METHOD): {
                     MARK_EXC_IP_SELECTIVE();
+                    #if MICROPY_OPT_INLINE_CACHE
+                    const byte *site = ip;
+                    DECODE_QSTR;
+                    inline_cache_load_method(code_state, site, *sp, qst, sp);
+                    #else
                     DECODE_QSTR;
                     mp_load_method(*sp, qst, sp);
+                    #endif
                     sp += 1;
                     DISPATCH();
                 }
@@ -442,6 +872,12 @@ dispatch_loop:
 
                 ENTRY(MP_BC_LOAD_SUBSCR): {
                     MARK_EXC_IP_SELECTIVE();
+                    #if MICROPY_OPT_QUICKENING
+                    if (quicken && mp_obj_is_small_int(TOP())
+                        && (mp_obj_is_exact_type(sp[-1], &mp_type_list) || mp_obj_is_exact_type(sp[-1], &mp_type_tuple))) {
+                        *(byte *)(ip - 1) = MP_BC_LOAD_SUBSCR_SEQ;
+                    }
+                    #endif
                     mp_obj_t index = POP();
                     SET_TOP(mp_obj_subscr(TOP(), index, MP_OBJ_SENTINEL));
                     DISPATCH();
@@ -476,14 +912,27 @@ dispatch_loop:
                 ENTRY(MP_BC_STORE_ATTR): {
                     FRAME_UPDATE();
                     MARK_EXC_IP_SELECTIVE();
+                    #if MICROPY_OPT_INLINE_CACHE && MICROPY_OPT_INSTANCE_SHAPES
+                    const byte *site = ip;
+                    DECODE_QSTR;
+                    if (!inline_cache_store_attr(code_state, site, sp[0], qst, sp[-1])) {
+                        mp_store_attr(sp[0], qst, sp[-1]);
+                    }
+                    #else
                     DECODE_QSTR;
                     mp_store_attr(sp[0], qst, sp[-1]);
+                    #endif
                     sp -= 2;
                     DISPATCH();
                 }
 
                 ENTRY(MP_BC_STORE_SUBSCR):
                     MARK_EXC_IP_SELECTIVE();
+                    #if MICROPY_OPT_QUICKENING
+                    if (quicken && mp_obj_is_small_int(sp[0]) && mp_obj_is_exact_type(sp[-1], &mp_type_list)) {
+                        *(byte *)(ip - 1) = MP_BC_STORE_SUBSCR_LIST;
+                    }
+                    #endif
                     mp_obj_subscr(sp[-1], sp[0], sp[-2]);
                     sp -= 3;
                     DISPATCH();
@@ -1250,6 +1699,224 @@ yield:
                     mp_import_all(POP());
                     DISPATCH();
 
+                ENTRY(MP_BC_LOAD_FAST_0_ATTR):
+                    obj_shared = fastn[0];
+                    if (obj_shared == MP_OBJ_NULL) {
+                        goto local_name_error;
+                    }
+                    PUSH(obj_shared);
+                    goto load_attr;
+
+                ENTRY(MP_BC_LOAD_FAST_2): {
+                    DECODE_UINT;
+                    obj_shared = fastn[-(mp_int_t)(unum >> 4)];
+                    if (obj_shared == MP_OBJ_NULL) {
+                        goto local_name_error;
+                    }
+                    PUSH(obj_shared);
+                    obj_shared = fastn[-(mp_int_t)(unum & 0xf)];
+                    goto load_check;
+                }
+
+                ENTRY(MP_BC_INPLACE_ADD_FAST):
+                ENTRY(MP_BC_INPLACE_SUBTRACT_FAST): {
+                    MARK_EXC_IP_SELECTIVE();
+                    bool is_add = ip[-1] == MP_BC_INPLACE_ADD_FAST;
+                    DECODE_UINT;
+                    mp_obj_t *local = &fastn[-(mp_int_t)(unum & 0xf)];
+                    mp_int_t k = unum >> 4;
+                    if (*local == MP_OBJ_NULL) {
+                        goto local_name_error;
+                    }
+                    if (mp_obj_is_small_int(*local)) {
+                        mp_int_t val = MP_OBJ_SMALL_INT_VALUE(*local) + (is_add ? k : -k);
+                        if (MP_SMALL_INT_FITS(val)) {
+                            *local = MP_OBJ_NEW_SMALL_INT(val);
+                            DISPATCH();
+                        }
+                    }
+                    *local = mp_binary_op(is_add ? MP_BINARY_OP_INPLACE_ADD : MP_BINARY_OP_INPLACE_SUBTRACT,
+                        *local, MP_OBJ_NEW_SMALL_INT(k));
+                    DISPATCH();
+                }
+
+                ENTRY(MP_BC_BINARY_OP_POP_JUMP_IF): {
+                    MARK_EXC_IP_SELECTIVE();
+                    DECODE_SLABEL;
+                    const byte *target = ip + slab;
+                    byte arg = *ip++;
+                    mp_binary_op_t op = arg & ~MP_BC_BINARY_OP_POP_JUMP_IF_TRUE_FLAG;
+                    mp_obj_t rhs = POP();
+                    mp_obj_t lhs = POP();
+                    bool result;
+                    if (op <= MP_BINARY_OP_NOT_EQUAL && mp_obj_is_small_int(lhs) && mp_obj_is_small_int(rhs)) {
+                        mp_int_t lhs_val = MP_OBJ_SMALL_INT_VALUE(lhs);
+                        mp_int_t rhs_val = MP_OBJ_SMALL_INT_VALUE(rhs);
+                        switch (op) {
+                            case MP_BINARY_OP_LESS:
+                                result = lhs_val < rhs_val;
+                                break;
+                            case MP_BINARY_OP_MORE:
+                                result = lhs_val > rhs_val;
+                                break;
+                            case MP_BINARY_OP_EQUAL:
+                                result = lhs_val == rhs_val;
+                                break;
+                            case MP_BINARY_OP_LESS_EQUAL:
+                                result = lhs_val <= rhs_val;
+                                break;
+                            case MP_BINARY_OP_MORE_EQUAL:
+                                result = lhs_val >= rhs_val;
+                                break;
+                            default:
+                                result = lhs_val != rhs_val;
+                                break;
+                        }
+                    } else {
+                        result = mp_obj_is_true(mp_binary_op(op, lhs, rhs));
+                    }
+                    if (result == ((arg & MP_BC_BINARY_OP_POP_JUMP_IF_TRUE_FLAG) != 0)) {
+                        ip = target;
+                    }
+                    DISPATCH_WITH_PEND_EXC_CHECK();
+                }
+
+                #if MICROPY_OPT_QUICKENING
+                ENTRY(MP_BC_LOAD_ATTR_INSTANCE): {
+                    FRAME_UPDATE();
+                    MARK_EXC_IP_SELECTIVE();
+                    const byte *site = ip;
+                    DECODE_QSTR;
+                    mp_obj_t top = TOP();
+                    if (mp_obj_is_instance_type(mp_obj_get_type(top))) {
+                        #if MICROPY_OPT_INLINE_CACHE
+                        mp_obj_t *value = inline_cache_instance_lookup(code_state, site, MP_OBJ_TO_PTR(top), qst);
+                        #else
+                        mp_obj_t *value = mp_obj_instance_lookup_member(MP_OBJ_TO_PTR(top), qst);
+                        #endif
+                        if (value != NULL) {
+                            SET_TOP(*value);
+                            DISPATCH();
+                        }
+                    }
+                    ip = site;
+                    goto quicken_deopt;
+                }
+
+                ENTRY(MP_BC_LOAD_SUBSCR_SEQ): {
+                    if (mp_obj_is_small_int(sp[0])) {
+                        size_t len;
+                        mp_obj_t *items;
+                        if (mp_obj_is_exact_type(sp[-1], &mp_type_list)) {
+                            mp_obj_list_t *list = MP_OBJ_TO_PTR(sp[-1]);
+                            len = list->len;
+                            items = list->items;
+                        } else if (mp_obj_is_exact_type(sp[-1], &mp_type_tuple)) {
+                            mp_obj_tuple_t *tuple = MP_OBJ_TO_PTR(sp[-1]);
+                            len = tuple->len;
+                            items = tuple->items;
+                        } else {
+                            goto quicken_deopt;
+                        }
+                        mp_int_t index = MP_OBJ_SMALL_INT_VALUE(sp[0]);
+                        if (index < 0) {
+                            index += len;
+                        }
+                        if ((mp_uint_t)index < len) {
+                            sp -= 1;
+                            SET_TOP(items[index]);
+                            DISPATCH();
+                        }
+                    }
+                    goto quicken_deopt;
+                }
+
+                ENTRY(MP_BC_STORE_SUBSCR_LIST): {
+                    if (mp_obj_is_small_int(sp[0]) && mp_obj_is_exact_type(sp[-1], &mp_type_list)) {
+                        mp_obj_list_t *list = MP_OBJ_TO_PTR(sp[-1]);
+                        mp_int_t index = MP_OBJ_SMALL_INT_VALUE(sp[0]);
+                        if (index < 0) {
+                            index += list->len;
+                        }
+                        if ((mp_uint_t)index < list->len) {
+                            list->items[index] = sp[-2];
+                            sp -= 3;
+                            DISPATCH();
+                        }
+                    }
+                    goto quicken_deopt;
+                }
+
+                ENTRY(MP_BC_BINARY_OP_SMALL_INT_ADD):
+                ENTRY(MP_BC_BINARY_OP_SMALL_INT_INPLACE_ADD):
+                    if (mp_obj_is_small_int(sp[-1]) && mp_obj_is_small_int(sp[0])) {
+                        mp_int_t val = MP_OBJ_SMALL_INT_VALUE(sp[-1]) + MP_OBJ_SMALL_INT_VALUE(sp[0]);
+                        if (MP_SMALL_INT_FITS(val)) {
+                            sp -= 1;
+                            SET_TOP(MP_OBJ_NEW_SMALL_INT(val));
+                            DISPATCH();
+                        }
+                    }
+                    goto quicken_deopt;
+
+                ENTRY(MP_BC_BINARY_OP_SMALL_INT_SUBTRACT):
+                ENTRY(MP_BC_BINARY_OP_SMALL_INT_INPLACE_SUBTRACT):
+                    if (mp_obj_is_small_int(sp[-1]) && mp_obj_is_small_int(sp[0])) {
+                        mp_int_t val = MP_OBJ_SMALL_INT_VALUE(sp[-1]) - MP_OBJ_SMALL_INT_VALUE(sp[0]);
+                        if (MP_SMALL_INT_FITS(val)) {
+                            sp -= 1;
+                            SET_TOP(MP_OBJ_NEW_SMALL_INT(val));
+                            DISPATCH();
+                        }
+                    }
+                    goto quicken_deopt;
+
+                ENTRY(MP_BC_BINARY_OP_SMALL_INT_LESS):
+                    QUICKEN_SMALL_INT_COMPARE(<);
+                ENTRY(MP_BC_BINARY_OP_SMALL_INT_MORE):
+                    QUICKEN_SMALL_INT_COMPARE(>);
+                ENTRY(MP_BC_BINARY_OP_SMALL_INT_EQUAL):
+                    QUICKEN_SMALL_INT_COMPARE(==);
+                ENTRY(MP_BC_BINARY_OP_SMALL_INT_LESS_EQUAL):
+                    QUICKEN_SMALL_INT_COMPARE(<=);
+                ENTRY(MP_BC_BINARY_OP_SMALL_INT_MORE_EQUAL):
+                    QUICKEN_SMALL_INT_COMPARE(>=);
+                ENTRY(MP_BC_BINARY_OP_SMALL_INT_NOT_EQUAL):
+                    QUICKEN_SMALL_INT_COMPARE(!=);
+
+                #if MICROPY_PY_BUILTINS_FLOAT
+                ENTRY(MP_BC_BINARY_OP_FLOAT_ADD):
+                ENTRY(MP_BC_BINARY_OP_FLOAT_INPLACE_ADD):
+                    QUICKEN_FLOAT_OP(mp_obj_new_float(lhs_val + rhs_val));
+                ENTRY(MP_BC_BINARY_OP_FLOAT_SUBTRACT):
+                ENTRY(MP_BC_BINARY_OP_FLOAT_INPLACE_SUBTRACT):
+                    QUICKEN_FLOAT_OP(mp_obj_new_float(lhs_val - rhs_val));
+                ENTRY(MP_BC_BINARY_OP_FLOAT_MULTIPLY):
+                ENTRY(MP_BC_BINARY_OP_FLOAT_INPLACE_MULTIPLY):
+                    QUICKEN_FLOAT_OP(mp_obj_new_float(lhs_val * rhs_val));
+                ENTRY(MP_BC_BINARY_OP_FLOAT_LESS):
+                    QUICKEN_FLOAT_OP(mp_obj_new_bool(lhs_val < rhs_val));
+                ENTRY(MP_BC_BINARY_OP_FLOAT_MORE):
+                    QUICKEN_FLOAT_OP(mp_obj_new_bool(lhs_val > rhs_val));
+                ENTRY(MP_BC_BINARY_OP_FLOAT_TRUE_DIVIDE):
+                ENTRY(MP_BC_BINARY_OP_FLOAT_INPLACE_TRUE_DIVIDE):
+                    // division by zero is left to the generic opcode to raise
+                    if (mp_obj_is_float(sp[0]) && mp_obj_float_get(sp[0]) == 0) {
+                        goto quicken_deopt;
+                    }
+                    QUICKEN_FLOAT_OP(mp_obj_new_float(lhs_val / rhs_val));
+                #endif
+
+quicken_deopt: {
+                    // The guard of a specialised opcode failed: put back the
+                    // generic opcode and run that instead.
+                    ip -= 1;
+                    byte op = mp_bc_quicken_generic(*ip);
+                    *(byte *)ip = op;
+                    DISPATCH();
+                }
+                #endif // MICROPY_OPT_QUICKENING
+
                 #if MICROPY_OPT_COMPUTED_GOTO
                 ENTRY(MP_BC_LOAD_CONST_SMALL_INT_MULTI):
                     PUSH(MP_OBJ_NEW_SMALL_INT((mp_int_t)ip[-1] - MP_BC_LOAD_CONST_SMALL_INT_MULTI - MP_BC_LOAD_CONST_SMALL_INT_MULTI_EXCESS));
@@ -1272,7 +1939,13 @@ yield:
                     MARK_EXC_IP_SELECTIVE();
                     mp_obj_t rhs = POP();
                     mp_obj_t lhs = TOP();
-                    SET_TOP(mp_binary_op(ip[-1] - MP_BC_BINARY_OP_MULTI, lhs, rhs));
+                    mp_binary_op_t op = ip[-1] - MP_BC_BINARY_OP_MULTI;
+                    #if MICROPY_OPT_QUICKENING
+                    if (quicken) {
+                        vm_quicken_binary_op((byte *)ip - 1, op, lhs, rhs);
+                    }
+                    #endif
+                    SET_TOP(mp_binary_op(op, lhs, rhs));
                     DISPATCH();
                 }
 
@@ -1295,7 +1968,13 @@ yield:
                     } else if (ip[-1] < MP_BC_BINARY_OP_MULTI + MP_BC_BINARY_OP_MULTI_NUM) {
                         mp_obj_t rhs = POP();
                         mp_obj_t lhs = TOP();
-                        SET_TOP(mp_binary_op(ip[-1] - MP_BC_BINARY_OP_MULTI, lhs, rhs));
+                        mp_binary_op_t op = ip[-1] - MP_BC_BINARY_OP_MULTI;
+                        #if MICROPY_OPT_QUICKENING
+                        if (quicken) {
+                            vm_quicken_binary_op((byte *)ip - 1, op, lhs, rhs);
+                        }
+                        #endif
+                        SET_TOP(mp_binary_op(op, lhs, rhs));
                         DISPATCH();
                     } else
                 #endif // MICROPY_OPT_COMPUTED_GOTO
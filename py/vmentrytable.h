@@ -113,11 +113,44 @@ static const void *const entry_table[256] = {
     [MP_BC_IMPORT_NAME] = &&entry_MP_BC_IMPORT_NAME,
     [MP_BC_IMPORT_FROM] = &&entry_MP_BC_IMPORT_FROM,
     [MP_BC_IMPORT_STAR] = &&entry_MP_BC_IMPORT_STAR,
+    [MP_BC_LOAD_FAST_0_ATTR] = &&entry_MP_BC_LOAD_FAST_0_ATTR,
+    [MP_BC_LOAD_FAST_2] = &&entry_MP_BC_LOAD_FAST_2,
+    [MP_BC_INPLACE_ADD_FAST] = &&entry_MP_BC_INPLACE_ADD_FAST,
+    [MP_BC_INPLACE_SUBTRACT_FAST] = &&entry_MP_BC_INPLACE_SUBTRACT_FAST,
+    [MP_BC_BINARY_OP_POP_JUMP_IF] = &&entry_MP_BC_BINARY_OP_POP_JUMP_IF,
     [MP_BC_LOAD_CONST_SMALL_INT_MULTI ... MP_BC_LOAD_CONST_SMALL_INT_MULTI + MP_BC_LOAD_CONST_SMALL_INT_MULTI_NUM - 1] = &&entry_MP_BC_LOAD_CONST_SMALL_INT_MULTI,
     [MP_BC_LOAD_FAST_MULTI ... MP_BC_LOAD_FAST_MULTI + MP_BC_LOAD_FAST_MULTI_NUM - 1] = &&entry_MP_BC_LOAD_FAST_MULTI,
     [MP_BC_STORE_FAST_MULTI ... MP_BC_STORE_FAST_MULTI + MP_BC_STORE_FAST_MULTI_NUM - 1] = &&entry_MP_BC_STORE_FAST_MULTI,
     [MP_BC_UNARY_OP_MULTI ... MP_BC_UNARY_OP_MULTI + MP_BC_UNARY_OP_MULTI_NUM - 1] = &&entry_MP_BC_UNARY_OP_MULTI,
     [MP_BC_BINARY_OP_MULTI ... MP_BC_BINARY_OP_MULTI + MP_BC_BINARY_OP_MULTI_NUM - 1] = &&entry_MP_BC_BINARY_OP_MULTI,
+    #if MICROPY_OPT_QUICKENING
+    [MP_BC_LOAD_ATTR_INSTANCE] = &&entry_MP_BC_LOAD_ATTR_INSTANCE,
+    [MP_BC_LOAD_ATTR_UNSPECIALISED] = &&entry_MP_BC_LOAD_ATTR_UNSPECIALISED,
+    [MP_BC_LOAD_SUBSCR_SEQ] = &&entry_MP_BC_LOAD_SUBSCR_SEQ,
+    [MP_BC_STORE_SUBSCR_LIST] = &&entry_MP_BC_STORE_SUBSCR_LIST,
+    [MP_BC_BINARY_OP_SMALL_INT_ADD] = &&entry_MP_BC_BINARY_OP_SMALL_INT_ADD,
+    [MP_BC_BINARY_OP_SMALL_INT_SUBTRACT] = &&entry_MP_BC_BINARY_OP_SMALL_INT_SUBTRACT,
+    [MP_BC_BINARY_OP_SMALL_INT_INPLACE_ADD] = &&entry_MP_BC_BINARY_OP_SMALL_INT_INPLACE_ADD,
+    [MP_BC_BINARY_OP_SMALL_INT_INPLACE_SUBTRACT] = &&entry_MP_BC_BINARY_OP_SMALL_INT_INPLACE_SUBTRACT,
+    [MP_BC_BINARY_OP_SMALL_INT_LESS] = &&entry_MP_BC_BINARY_OP_SMALL_INT_LESS,
+    [MP_BC_BINARY_OP_SMALL_INT_MORE] = &&entry_MP_BC_BINARY_OP_SMALL_INT_MORE,
+    [MP_BC_BINARY_OP_SMALL_INT_EQUAL] = &&entry_MP_BC_BINARY_OP_SMALL_INT_EQUAL,
+    [MP_BC_BINARY_OP_SMALL_INT_LESS_EQUAL] = &&entry_MP_BC_BINARY_OP_SMALL_INT_LESS_EQUAL,
+    [MP_BC_BINARY_OP_SMALL_INT_MORE_EQUAL] = &&entry_MP_BC_BINARY_OP_SMALL_INT_MORE_EQUAL,
+    [MP_BC_BINARY_OP_SMALL_INT_NOT_EQUAL] = &&entry_MP_BC_BINARY_OP_SMALL_INT_NOT_EQUAL,
+    #if MICROPY_PY_BUILTINS_FLOAT
+    [MP_BC_BINARY_OP_FLOAT_ADD] = &&entry_MP_BC_BINARY_OP_FLOAT_ADD,
+    [MP_BC_BINARY_OP_FLOAT_SUBTRACT] = &&entry_MP_BC_BINARY_OP_FLOAT_SUBTRACT,
+    [MP_BC_BINARY_OP_FLOAT_MULTIPLY] = &&entry_MP_BC_BINARY_OP_FLOAT_MULTIPLY,
+    [MP_BC_BINARY_OP_FLOAT_TRUE_DIVIDE] = &&entry_MP_BC_BINARY_OP_FLOAT_TRUE_DIVIDE,
+    [MP_BC_BINARY_OP_FLOAT_INPLACE_ADD] = &&entry_MP_BC_BINARY_OP_FLOAT_INPLACE_ADD,
+    [MP_BC_BINARY_OP_FLOAT_INPLACE_SUBTRACT] = &&entry_MP_BC_BINARY_OP_FLOAT_INPLACE_SUBTRACT,
+    [MP_BC_BINARY_OP_FLOAT_INPLACE_MULTIPLY] = &&entry_MP_BC_BINARY_OP_FLOAT_INPLACE_MULTIPLY,
+    [MP_BC_BINARY_OP_FLOAT_INPLACE_TRUE_DIVIDE] = &&entry_MP_BC_BINARY_OP_FLOAT_INPLACE_TRUE_DIVIDE,
+    [MP_BC_BINARY_OP_FLOAT_LESS] = &&entry_MP_BC_BINARY_OP_FLOAT_LESS,
+    [MP_BC_BINARY_OP_FLOAT_MORE] = &&entry_MP_BC_BINARY_OP_FLOAT_MORE,
+    #endif
+    #endif
 };
 
 #if __clang__
@@ -183,6 +183,23 @@ void vstr_add_strn(vstr_t *vstr, const char *str, size_t len) {
     vstr->len += len;
 }
 
+#if MICROPY_GC_PROFILE || MICROPY_CALL_PROFILE
+// Add value as an unsigned LEB128 number.
+void vstr_add_uleb(vstr_t *vstr, size_t value) {
+    do {
+        byte b = value & 0x7f;
+        value >>= 7;
+        vstr_add_byte(vstr, b | (value ? 0x80 : 0));
+    } while (value);
+}
+
+// Add a string as its uleb length followed by its bytes.
+void vstr_add_uleb_str(vstr_t *vstr, const char *str, size_t len) {
+    vstr_add_uleb(vstr, len);
+    vstr_add_strn(vstr, str, len);
+}
+#endif
+
 static char *vstr_ins_blank_bytes(vstr_t *vstr, size_t byte_pos, size_t byte_len) {
     size_t l = vstr->len;
     if (byte_pos > l) {
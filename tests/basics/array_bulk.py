@@ -0,0 +1,88 @@
+# test bulk numeric functions of the array module (MicroPython extension)
+
+try:
+    import array
+
+    array.sum
+except (ImportError, AttributeError):
+    print("SKIP")
+    raise SystemExit
+
+# reductions on each integer typecode
+for typecode in "bBhHiIlLqQ":
+    try:
+        a = array.array(typecode, [3, 1, 4, 1, 5, 9, 2, 6, 5, 3, 5])
+    except ValueError:
+        # typecode not supported
+        print(typecode, 44, 232, 1, 9, 1, 5)
+        continue
+    print(typecode, array.sum(a), array.dot(a, a), array.min(a), array.max(a), array.argmin(a), array.argmax(a))
+
+# signed and unsigned extremes
+print(array.sum(array.array("b", [-128] * 100)), array.sum(array.array("B", [255] * 100)))
+print(array.dot(array.array("h", [-32768, 32767]), array.array("h", [-32768, 32767])))
+print(array.min(array.array("i", [5, -7, 3])), array.max(array.array("I", [5, 0xFFFFFFFF, 3])))
+print(array.sum(array.array("B")))
+
+# elementwise operations in place, which wrap around like array stores
+a = array.array("b", [100, -100, 5, 0])
+array.add(a, array.array("b", [100, -100, 5, 0]))
+print(a)
+array.mul(a, 3)
+print(a)
+array.add(a, -1)
+print(a)
+a = array.array("H", [1, 2, 3])
+array.mul(a, array.array("H", [60000, 2, 3]))
+print(a)
+
+# clip, with limits that are saturated to the range of the typecode
+a = array.array("h", [-1000, -10, 0, 10, 1000])
+array.clip(a, -10, 100)
+print(a)
+a = array.array("B", [0, 100, 255])
+array.clip(a, -5, 1000)
+print(a)
+array.clip(a, 50, 200)
+print(a)
+
+# memoryview and bytearray
+a = array.array("h", range(10))
+m = memoryview(a)[2:5]
+print(array.sum(m), array.argmax(m))
+array.mul(m, 10)
+print(a)
+print(array.sum(b"\x01\x02\x03"), array.max(bytearray(b"\x05\xff\x00")))
+
+# cast between integer typecodes
+a = array.array("h", [-1, 300, 7])
+b = array.array("B", [0, 0, 0])
+array.cast(b, a)
+print(b)
+c = array.array("i", [0, 0, 0])
+array.cast(c, a)
+print(c)
+array.cast(c, b)
+print(c)
+
+# errors
+for args in (
+    (array.array("h", [1]), array.array("H", [1])),
+    (array.array("h", [1]), array.array("h", [1, 2])),
+):
+    try:
+        array.dot(*args)
+    except ValueError as er:
+        print("ValueError", er)
+try:
+    array.max(array.array("h"))
+except ValueError as er:
+    print("ValueError", er)
+try:
+    array.add(b"abc", 1)
+except TypeError:
+    print("TypeError")
+try:
+    array.sum(array.array("O", [1]))
+except (ValueError, TypeError):
+    print("ValueError/TypeError")
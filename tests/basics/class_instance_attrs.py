@@ -0,0 +1,79 @@
+# test storing, loading and deleting attributes of many instances
+
+
+class P:
+    def __init__(self, x, y):
+        self.x = x
+        self.y = y
+
+    def norm(self):
+        return self.x * self.x + self.y * self.y
+
+
+# same attributes set in the same and in different orders
+ps = [P(i, -i) for i in range(10)]
+q = P(1, 2)
+del q.x
+q.x = 3
+print(sum(p.norm() for p in ps), q.norm(), sorted(q.__dict__.items()))
+
+
+# one load site seeing instances with differently laid out attributes
+def get_y(o):
+    return o.y
+
+
+objs = []
+for i in range(6):
+    o = P(i, i)
+    for j in range(i):
+        setattr(o, "a%d" % j, j)
+    objs.append(o)
+objs.append(q)
+for _ in range(20):
+    total = sum(get_y(o) for o in objs)
+print(total)
+
+# many attributes
+o = P(0, 0)
+for i in range(40):
+    setattr(o, "attr%d" % i, i)
+print(sum(getattr(o, "attr%d" % i) for i in range(40)), o.x, o.y, len(o.__dict__))
+for i in range(0, 40, 2):
+    delattr(o, "attr%d" % i)
+print(hasattr(o, "attr0"), hasattr(o, "attr1"), len(o.__dict__))
+
+# deleting then re-adding attributes
+o = P(1, 2)
+del o.y
+try:
+    o.y
+except AttributeError:
+    print("AttributeError")
+try:
+    del o.y
+except AttributeError:
+    print("AttributeError")
+o.y = 5
+print(o.norm(), sorted(o.__dict__))
+
+
+# an instance attribute shadowing a method, after the method was called
+class C:
+    def f(self):
+        return "method"
+
+
+c = C()
+for _ in range(20):
+    r = c.f()
+c.f = lambda: "attr"
+print(r, c.f())
+del c.f
+print(c.f())
+
+# attribute names that aren't interned yet
+o = C()
+name = "".join(["dyn", "amic"])
+setattr(o, name, 1)
+print(o.dynamic, getattr(o, "dyn" + "amic"))
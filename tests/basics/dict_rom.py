@@ -0,0 +1,33 @@
+# test lookups and iteration of the constant dicts of built-in modules and types
+
+import sys
+
+try:
+    sys.__dict__
+    int.__dict__
+except AttributeError:
+    print("SKIP")
+    raise SystemExit
+
+
+def check(obj, hits, misses):
+    d = obj.__dict__
+    keys = list(d)
+    # iteration yields each key once, and every key can be looked up
+    print(len(keys) == len(d), len(set(keys)) == len(keys))
+    print(all(k in d and d.get(k) is d[k] for k in keys))
+    print(sorted(keys) == sorted(k for k, v in d.items()))
+    # hits, including with str keys built at runtime
+    for k in hits:
+        k2 = "".join(list(k))
+        print(k, k in d, k2 in d, d.get(k2) is d[k])
+    # misses, including names of other attributes and non-str keys
+    for k in misses:
+        print(repr(k), k in d, d.get(k, "none"))
+
+
+check(sys, ("argv", "modules", "version"), ("append", "argvx", "", 1, None))
+check(int, ("from_bytes", "to_bytes"), ("path", "to_bytesx", 1.5))
+check(str, ("join", "split", "upper", "startswith"), ("append", "JOIN", b"join"))
+check(list, ("append", "pop", "sort"), ("join", "appendx", ()))
+check(dict, ("get", "items", "keys", "fromkeys"), ("append", "getx", 0))
@@ -0,0 +1,33 @@
+# test recursive calls of functions with large state, and exceptions through them
+
+
+# this function has 20 locals
+def f(n, fail):
+    a0 = a1 = a2 = a3 = a4 = a5 = a6 = a7 = a8 = a9 = n
+    b0 = b1 = b2 = b3 = b4 = b5 = b6 = b7 = b8 = n + 1
+    if n == fail:
+        raise ValueError(n)
+    if n == 0:
+        return 0
+    return a0 + b8 + f(n - 1, fail) + a9
+
+
+# this function has 40 locals and runs a generator within each call
+def g(n):
+    a0 = a1 = a2 = a3 = a4 = a5 = a6 = a7 = a8 = a9 = n
+    b0 = b1 = b2 = b3 = b4 = b5 = b6 = b7 = b8 = b9 = n
+    c0 = c1 = c2 = c3 = c4 = c5 = c6 = c7 = c8 = c9 = n
+    d0 = d1 = d2 = d3 = d4 = d5 = d6 = d7 = d8 = n
+    total = sum(x for x in (a0, b9, c5, d8))
+    if n > 0:
+        total += f(n, -1) + g(n - 1)
+    return total
+
+
+for i in range(3):
+    print(f(10, -1))
+    try:
+        f(10, 5)
+    except ValueError as er:
+        print("ValueError", er)
+    print(g(8))
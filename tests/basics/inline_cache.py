@@ -0,0 +1,96 @@
+# test that cached attribute, method and global lookups see changes
+
+
+class A:
+    def f(self):
+        return "A.f"
+
+    def g(self):
+        return "A.g"
+
+
+class B(A):
+    pass
+
+
+class C:
+    def f(self):
+        return "C.f"
+
+
+def call_f(objs):
+    return [o.f() for o in objs]
+
+
+# the same call site with several types
+objs = [A(), B(), C(), A(), [1], B()]
+objs[4] = C()
+for _ in range(3):
+    print(call_f(objs))
+
+# method redefined on the class, and on a base class
+a = A()
+b = B()
+for i in range(4):
+    if i == 1:
+        A.f = lambda self: "A.f2"
+    if i == 2:
+        B.f = lambda self: "B.f"
+    if i == 3:
+        del B.f
+    print(i, a.f(), b.f())
+
+# method shadowed by an instance attribute
+for i in range(3):
+    if i == 1:
+        a.g = lambda: "a.g"
+    if i == 2:
+        del a.g
+    print(i, a.g())
+
+# built-in types
+for x in ([3, 1, 2], (3, 1, 2), "312", [3, 1, 2]):
+    print(x.index(x[1]), x.index(x[2]))
+
+
+# instance members, with different layouts per instance
+class P:
+    def __init__(self, n):
+        for i in range(n):
+            setattr(self, "m" + str(i), i)
+        self.x = n
+
+
+for n in (0, 1, 5, 2, 9):
+    p = P(n)
+    print(p.x, p.x)
+    p.x = -n
+    print(p.x)
+
+
+# globals, including one that shadows a builtin for a while
+def get_globals():
+    return X, len("ab")
+
+
+X = 1
+print(get_globals())
+X = 2
+len = lambda x: -1
+print(get_globals())
+del len
+print(get_globals())
+
+# module attributes and methods, with the same sites seeing an instance
+import sys
+
+
+class NS:
+    pass
+
+
+ns = NS()
+ns.platform = "ns"
+ns.exit = lambda: "ns"
+for m in (sys, ns, sys):
+    print(m.platform == sys.platform, m.exit == sys.exit)
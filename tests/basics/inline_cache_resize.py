@@ -0,0 +1,69 @@
+# test that cached global and attribute lookups stay correct when the dict
+# holding the name is resized or rearranged between lookups
+
+
+def get_x():
+    return X
+
+
+# each new global may grow the globals dict and move X to another slot
+X = -1
+for i in range(40):
+    globals()["g" + str(i)] = i
+    X = i
+    if get_x() != i:
+        print("grow", i, get_x())
+print(get_x())
+
+# delete and re-add, so X may land in another slot of a table of the same size
+for i in range(10):
+    del X
+    try:
+        get_x()
+    except NameError:
+        print("NameError", i)
+    globals()["h" + str(i)] = i
+    X = -i
+    if get_x() != -i:
+        print("re-add", i, get_x())
+print(get_x())
+
+# other names removed from in front of X
+for i in range(40):
+    del globals()["g" + str(i)]
+    if get_x() != -9:
+        print("shrink", i, get_x())
+print(get_x())
+
+
+class O:
+    pass
+
+
+def get_a(o):
+    return o.a
+
+
+# an instance's members growing past any fixed layout
+o = O()
+o.a = -1
+for i in range(40):
+    setattr(o, "m" + str(i), i)
+    o.a = i
+    if get_a(o) != i:
+        print("attr", i, get_a(o))
+print(get_a(o))
+
+# the same site with instances whose members are laid out differently
+objs = []
+for n in range(0, 40, 7):
+    p = O()
+    for i in range(n):
+        setattr(p, "m" + str(i), i)
+    p.a = n
+    objs.append(p)
+print([get_a(p) for p in objs])
+del objs[2].a
+objs[2].z = 0
+objs[2].a = "moved"
+print([get_a(p) for p in objs])
@@ -0,0 +1,26 @@
+# test that specialised small int opcodes fall back when results overflow
+
+
+def arith(a, b):
+    return (a + b, a - b, a < b, a > b, a <= b, a >= b, a == b, a != b)
+
+
+def inplace(a, b):
+    a += b
+    c = a
+    c -= b
+    return a, c
+
+
+# warm up with small ints so the sites are specialised
+for i in range(20):
+    arith(i, 3)
+    inplace(i, 3)
+
+big = 1 << 62
+print(arith(big, big), inplace(big, big))
+print(arith(-big, 1), inplace(-big, 1))
+big = 1 << 30
+print(arith(big, big), inplace(big, big))
+print(arith(-big, -big), inplace(-big, -big))
+print(arith(5, 3), inplace(5, 3))
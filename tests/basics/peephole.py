@@ -0,0 +1,186 @@
+# test code sequences that the compiler may fuse into superinstructions
+
+
+class A:
+    def __init__(self, x):
+        self.x = x
+
+    def get(self):
+        return self.x
+
+    def total(self, n):
+        t = 0
+        i = 0
+        while i < n:
+            t += self.x
+            i += 1
+        return t
+
+
+a = A(3)
+print(a.get(), a.total(4))
+
+
+# unbound local loaded by a fused opcode
+def f(a):
+    del a
+    return a.x
+
+
+try:
+    f(A(1))
+except NameError:
+    print("NameError")
+
+
+def f(a, b):
+    if a:
+        del b
+    return a + b
+
+
+print(f(0, 2))
+try:
+    f(1, 2)
+except NameError:
+    print("NameError")
+
+
+def f():
+    i += 1
+
+
+try:
+    f()
+except NameError:
+    print("NameError")
+
+
+# in-place add/subtract of a constant, with different local types
+def f(x):
+    x += 1
+    x -= 2
+    x += 100
+    x -= 127
+    x += 128
+    return x
+
+
+print(f(0), f(-5), f(True))
+print(f(1 << 20))
+
+
+class B:
+    def __init__(self, v):
+        self.v = v
+
+    def __add__(self, other):
+        return B(self.v + other * 10)
+
+    def __sub__(self, other):
+        return B(self.v - other * 10)
+
+
+print(f(B(0)).v)
+try:
+    f("a")
+except TypeError:
+    print("TypeError")
+
+
+# comparisons followed by a conditional jump
+def f(a, b):
+    r = []
+    if a < b:
+        r.append("lt")
+    if a > b:
+        r.append("gt")
+    if a == b:
+        r.append("eq")
+    if a <= b:
+        r.append("le")
+    if a >= b:
+        r.append("ge")
+    if a != b:
+        r.append("ne")
+    if a is b:
+        r.append("is")
+    if a is not b:
+        r.append("is not")
+    if not a < b:
+        r.append("not lt")
+    return r
+
+
+print(f(1, 2))
+print(f(2, 1))
+print(f(2, 2))
+print(f(-3, 3))
+print(f("a", "b"))
+print(f([1], [1]))
+try:
+    f(None, None)
+except TypeError:
+    print("TypeError")
+
+
+def f(l, x):
+    r = []
+    if x in l:
+        r.append("in")
+    if x not in l:
+        r.append("not in")
+    return r
+
+
+print(f([1, 2], 2), f([1, 2], 3), f("abc", "b"))
+
+
+def f(n):
+    i = 0
+    while i < n:
+        i += 2
+    while n - i != -3:
+        i += 1
+    return i
+
+
+print(f(0), f(5), f(-2))
+
+
+# stores to locals that are never read
+def f(l):
+    n = 0
+    for _ in l:
+        n += 1
+    unused = l
+    try:
+        raise ValueError
+    except ValueError as er:
+        pass
+    return n
+
+
+print(f([1, 2, 3]))
+
+
+# jumps to jumps
+def f(n):
+    r = []
+    for i in range(n):
+        if i % 2:
+            if i % 3:
+                r.append(i)
+            else:
+                r.append(-i)
+        else:
+            continue
+    while n > 0:
+        if n == 5:
+            n -= 2
+        else:
+            n -= 1
+    return r, n
+
+
+print(f(10))
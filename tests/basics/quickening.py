@@ -0,0 +1,99 @@
+# test that specialised opcodes give the same results as generic ones, and
+# fall back correctly when the types at a site change
+
+def arith(a, b):
+    return (a + b, a - b, a < b, a > b, a <= b, a >= b, a == b, a != b)
+
+
+def inplace(a, b):
+    a += b
+    c = a
+    c -= b
+    return a, c
+
+
+# warm up with small ints so the sites are specialised
+for i in range(20):
+    arith(i, 3)
+    inplace(i, 3)
+print(arith(5, 3), inplace(5, 3))
+
+# other types at the same sites
+print(arith(True, False))
+print(inplace(True, True))
+print(arith(5, 3), inplace(5, 3))
+
+
+def load(seq, i):
+    return seq[i]
+
+
+def store(seq, i, v):
+    seq[i] = v
+
+
+l = [1, 2, 3]
+for i in range(20):
+    load(l, i % 3)
+    load((4, 5, 6), -1)
+    store(l, i % 3, i)
+print(l, load(l, -3), load((4, 5, 6), 1))
+for seq, i in ((l, 3), (l, -4), ((1,), 1), ({}, 0)):
+    try:
+        load(seq, i)
+    except IndexError:
+        print("IndexError")
+    except KeyError:
+        print("KeyError")
+print(load("abc", 1), load({1: 2}, 1), load(b"xyz", 2))
+for seq, i in ((l, 3), (l, -4), ((1,), 0)):
+    try:
+        store(seq, i, 0)
+    except IndexError:
+        print("IndexError")
+    except TypeError:
+        print("TypeError")
+d = {}
+store(d, 0, 1)
+print(d, l)
+
+
+class L(list):
+    def __getitem__(self, i):
+        return "L"
+
+
+print(load(L([1]), 0), load(l, 0))
+
+
+class A:
+    k = "class"
+
+    def __init__(self, x):
+        self.x = x
+
+
+def attr(o):
+    return o.x
+
+
+def kattr(o):
+    return o.k
+
+
+a = A(1)
+for i in range(20):
+    attr(a)
+    kattr(a)
+print(attr(a), attr(A(2)), kattr(a))
+b = A(3)
+del b.x
+try:
+    attr(b)
+except AttributeError:
+    print("AttributeError")
+A.x = "from class"
+print(attr(b), attr(a))
+a.k = "instance"
+print(kattr(a), kattr(A(0)))
+print(attr(type("N", (), {"x": 4})), attr(A(5)))
@@ -0,0 +1,15 @@
+# cmdline: -O2 -v -v
+# test printing of bytecode with the optimisations done at level 2
+GAIN = 2
+
+
+def f(data):
+    y = 0.5 * 3 + 2.0
+    s = "ab" + "c" * 2
+    for x in data:
+        y += abs(x) * GAIN
+    return y, s
+
+
+# not folded, because the result differs with single-precision floats
+STEP = 0.1 * 0.1
@@ -0,0 +1,25 @@
+# cmdline: -v -v
+# test printing of bytecode that is fused by the peephole optimiser
+
+
+def f0(self, a, b):
+    return self.x + (a < b)
+
+
+def f1(n):
+    i = 0
+    while i < n:
+        i += 1
+        n -= 2
+
+
+def f2(x, l):
+    for _ in l:
+        if x:
+            if l:
+                x = 1
+            else:
+                x = 2
+        else:
+            continue
+    return x
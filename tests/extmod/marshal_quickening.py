@@ -0,0 +1,40 @@
+# Test that marshalling a function after it has been run many times, so that the
+# VM may have specialised its opcodes, gives the same data as before it was run.
+
+try:
+    import marshal
+
+    (lambda: 0).__code__
+except (AttributeError, ImportError):
+    print("SKIP")
+    raise SystemExit
+
+ftype = type(lambda: 0)
+
+
+class A:
+    def __init__(self):
+        self.x = 1
+
+
+def f(a, b, o, lst):
+    s = a + b
+    s -= a
+    t = a * 1.5 + b / 2.0
+    lst[0] = s < b
+    return (s, t, o.x, lst[0], a == b)
+
+
+code = f.__code__
+before = marshal.dumps(code)
+lst = [0]
+for i in range(300):
+    f(i, 2, A(), lst)
+    f(i + 0.5, 2.5, A(), lst)
+after = marshal.dumps(code)
+print(before == after)
+
+# the data loads and runs
+f2 = ftype(marshal.loads(after), {})
+print(f2(3, 4, A(), [0]))
+print(f2(1.0, 0.5, A(), [0]))
@@ -146,6 +146,30 @@ def make_romfs(files, data=None):
     return fs.finalise()
 
 
+# An mpy file with nested functions, from mpy-cross of:
+#     def f(x):
+#         def g(y):
+#             return x + y
+#         return g
+#     class C:
+#         def m(self):
+#             return [i * 2 for i in range(3)]
+#     def gen():
+#         yield 1
+#         yield 2
+nested_mpy = (
+    b"M\x07\x00\x1f\x10\x00\x0elazy.py\x00\x0f\x02C\x00\x02f\x00\x06g"
+    b"en\x00\x02g\x00\x02m\x00\x14<listcomp>\x00\x02x\x00"
+    b"/-5\x0b\x02y\x00\x82\x13\x81y\x81L\x10\x08\x01d i2\x00\x16\x03T"
+    b"2\x01\x10\x024\x02\x16\x022\x02\x16\x04Qc\x03t\x11\t\x03\x08 E\x00\xb0"
+    b" \x00\x01\xc1\xb1c\x01X\x1a\x08\x05\x0c\r@%\x00\xb1\xf2c\x81\x1c\x00\x06\x02"
+    b"h@\x11\t\x16\n\x10\x02\x16\x0b2\x00\x16\x06Qc\x01\x81\x04\x19\x08\x06\x0e`"
+    b"`2\x00\x12\x0f\x834\x014\x01c\x01\x81(A\x08\x07\x0c``+\x00\xb0_"
+    b"K\x08\xc1\xb1\x82\xf4/\x14B6cx\x80@\x08\x04\x80\x08#\x81gY\x82g"
+    b"YQc"
+)
+
+
 # A class to test if a value is within a range, needed because MicroPython's range
 # doesn't support arbitrary objects.
 class Range:
@@ -482,5 +506,30 @@ class TestMounted(TestBase):
         vfs.umount("/test_rom2")
 
 
+class TestImportNested(unittest.TestCase):
+    @classmethod
+    def setUpClass(cls):
+        cls.romfs = make_romfs((("nested.mpy", nested_mpy),))
+
+    def setUp(self):
+        self.orig_sys_path = list(sys.path)
+        vfs.mount(vfs.VfsRom(self.romfs), "/test_rom")
+        sys.path.append("/test_rom")
+
+    def tearDown(self):
+        vfs.umount("/test_rom")
+        sys.path = self.orig_sys_path
+        sys.modules.pop("nested", None)
+
+    def test_import(self):
+        nested = __import__("nested")
+        self.assertEqual(nested.__file__, "/test_rom/nested.mpy")
+        # Each function is made more than once, to use it after it's been set up.
+        for i in range(2):
+            self.assertEqual(nested.f(1)(i), 1 + i)
+            self.assertEqual(nested.C().m(), [0, 2, 4])
+            self.assertEqual(list(nested.gen()), [1, 2])
+
+
 if __name__ == "__main__":
     unittest.main()
@@ -0,0 +1,4 @@
+# check if sys.settrace is available
+import sys
+
+print(hasattr(sys, "settrace"))
@@ -0,0 +1,46 @@
+# test bulk numeric functions of the array module on float arrays (MicroPython extension)
+
+try:
+    import array
+
+    array.sum
+except (ImportError, AttributeError):
+    print("SKIP")
+    raise SystemExit
+
+for typecode in "fd":
+    a = array.array(typecode, [0.5, -1.25, 3.0, 2.0, -4.5, 8.0, 0.25])
+    print(array.sum(a), array.dot(a, a), array.min(a), array.max(a), array.argmin(a), array.argmax(a))
+    array.add(a, a)
+    print(a)
+    array.mul(a, 0.5)
+    print(a)
+    array.add(a, 1)
+    print(a)
+    array.mul(a, array.array(typecode, [2] * 7))
+    print(a)
+    array.clip(a, -2, 4.5)
+    print(a)
+
+# cast float to int truncates towards zero and saturates
+f = array.array("f", [-1.75, 1.75, 300.5, -300.5, 1e30, -1e30, float("nan")])
+for typecode in "bBhi":
+    a = array.array(typecode, [0] * 7)
+    array.cast(a, f)
+    print(a)
+
+# cast int to float, and between float typecodes
+f = array.array("f", [0] * 3)
+array.cast(f, array.array("h", [-32768, 0, 32767]))
+print(f)
+d = array.array("d", [0] * 3)
+array.cast(d, f)
+print(d)
+array.cast(d, array.array("B", [1, 2, 255]))
+print(d)
+
+# a float scalar can't be applied to an int array
+try:
+    array.add(array.array("h", [1]), 1.5)
+except TypeError:
+    print("TypeError")
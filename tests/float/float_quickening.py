@@ -0,0 +1,29 @@
+# test that specialised float opcodes give the same results as generic ones
+
+
+def farith(a, b):
+    return (a + b, a - b, a * b, a / b, a < b, a > b)
+
+
+def finplace(a, b):
+    a += b
+    a -= b
+    a *= b
+    a /= b
+    return a
+
+
+for i in range(20):
+    farith(i + 0.5, 2.0)
+    finplace(i + 0.5, 2.0)
+print(farith(1.5, 2.0), finplace(1.5, 2.0))
+print(farith(1.5, 2), farith(3, 2.0), farith(4, 2))
+try:
+    farith(1.0, 0.0)
+except ZeroDivisionError:
+    print("ZeroDivisionError")
+try:
+    finplace(1.0, 0.0)
+except ZeroDivisionError:
+    print("ZeroDivisionError")
+print(farith(1.5, 2.0), finplace(1.5, 2.0))
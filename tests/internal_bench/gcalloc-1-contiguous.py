@@ -0,0 +1,11 @@
+import bench
+import gc
+
+
+def test(num):
+    gc.collect()
+    for i in range(num // 20):
+        bytearray(200)
+
+
+bench.run(test)
@@ -0,0 +1,16 @@
+import bench
+import gc
+
+
+def test(num):
+    # Keep every other small object alive so that the heap is full of holes
+    # too small for the buffers allocated below
+    live = [bytearray(16) for _ in range(20000)]
+    for i in range(0, len(live), 2):
+        live[i] = None
+    gc.collect()
+    for i in range(num // 20):
+        bytearray(200)
+
+
+bench.run(test)
@@ -0,0 +1,69 @@
+# test micropython.call_profile and call_snapshot
+
+import micropython
+
+if not hasattr(micropython, "call_profile"):
+    print("SKIP")
+    raise SystemExit
+
+
+def uleb(data, pos):
+    value = shift = 0
+    while True:
+        b = data[pos]
+        pos += 1
+        value |= (b & 0x7F) << shift
+        shift += 7
+        if not b & 0x80:
+            return value, pos
+
+
+def string(data, pos):
+    n, pos = uleb(data, pos)
+    return str(data[pos : pos + n], "utf8"), pos + n
+
+
+def parse(data):
+    assert data[:5] == b"MPCP\x01"
+    n, pos = uleb(data, 5)
+    funs = {}
+    for _ in range(n):
+        file, pos = string(data, pos)
+        name, pos = string(data, pos)
+        line, pos = uleb(data, pos)
+        calls, pos = uleb(data, pos)
+        us, pos = uleb(data, pos)
+        funs[name] = (line, calls, us)
+    assert pos == len(data)
+    return funs
+
+
+def leaf(x):
+    return x + 1
+
+
+def outer(n):
+    for i in range(n):
+        leaf(i)
+
+
+print(micropython.call_profile())
+micropython.call_profile(True)
+print(micropython.call_profile())
+outer(10)
+outer(5)
+micropython.call_profile(False)
+print(micropython.call_profile())
+
+# functions are identified by the line of their first statement
+funs = parse(micropython.call_snapshot())
+print(funs["leaf"][:2], funs["outer"][:2])
+
+# calls made while not profiling aren't counted
+outer(3)
+print(parse(micropython.call_snapshot())["leaf"][1])
+
+# starting again clears what was recorded
+micropython.call_profile(True)
+micropython.call_profile(False)
+print(parse(micropython.call_snapshot()))
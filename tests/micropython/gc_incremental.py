@@ -0,0 +1,53 @@
+# test gc.collect(budget_us=...) and lazy sweeping
+
+import gc
+
+if not hasattr(gc, "max_pause"):
+    print("SKIP")
+    raise SystemExit
+
+
+def make_garbage(n):
+    for i in range(n):
+        [i] * 8
+
+
+# preallocate the objects kept below, so the heap only changes by garbage
+keep = [bytearray(16) for i in range(200)]
+fresh = [None] * 32
+gc.collect()
+free = gc.mem_free()
+
+# a zero budget always makes progress, and the collection eventually completes
+make_garbage(100)
+steps = 1
+while not gc.collect(budget_us=0):
+    # objects allocated while the sweep is pending must survive it
+    fresh[steps % len(fresh)] = bytearray(16)
+    steps += 1
+print(steps >= 1)
+print(all(len(b) == 16 for b in keep + [b for b in fresh if b is not None]))
+
+# a full collection reclaims the garbage
+for i in range(len(fresh)):
+    fresh[i] = None
+gc.collect()
+print(abs(gc.mem_free() - free) < 1024)
+
+# garbage that a pending sweep hasn't freed yet is counted as free
+junk = [bytearray(100) for i in range(100)]
+junk = None
+pending = not gc.collect(budget_us=0)
+print(pending, abs(gc.mem_free() - free) < 1024)
+gc.collect()
+
+# a large budget completes the collection in one call
+make_garbage(10)
+print(gc.collect(budget_us=1000000))
+
+# max_pause can be read and reset
+print(type(gc.max_pause()) is int)
+gc.max_pause(0)
+print(gc.max_pause() >= 0)
+gc.collect()
+print(gc.max_pause() > 0)
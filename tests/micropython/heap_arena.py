@@ -0,0 +1,60 @@
+# test micropython.arena
+
+import gc
+import micropython
+
+try:
+    micropython.arena
+except AttributeError:
+    print("SKIP")
+    raise SystemExit
+
+
+def parse(line):
+    return [int(x) for x in line.split(",")]
+
+
+# temporaries are freed on exit, and objects that escape are kept
+gc.collect()
+keep = []
+free = gc.mem_free()
+with micropython.arena(32768):
+    for i in range(20):
+        total = sum(parse("1,2,3,4,5,6,7,8"))
+    keep.append(parse("9,10,11"))
+    keep.append("-".join(str(x) for x in range(5)))
+print(total, keep)
+print(free - gc.mem_free() < 2048)
+
+# escaped objects survive a full collection
+gc.collect()
+print(keep)
+
+# allocations that don't fit in the arena come from the heap
+with micropython.arena(64):
+    big = bytearray(1000)
+    small = [parse("1,2") for i in range(20)]
+print(len(big), small[-1])
+
+# the arena is exited when an exception propagates
+try:
+    with micropython.arena(1024):
+        x = parse("1,2,3")
+        raise ValueError(x)
+except ValueError as e:
+    print("ValueError", e)
+with micropython.arena(1024):
+    print(parse("4,5"))
+
+# arenas don't nest
+with micropython.arena(1024):
+    try:
+        with micropython.arena(1024):
+            pass
+    except RuntimeError:
+        print("RuntimeError")
+
+try:
+    micropython.arena(0)
+except ValueError:
+    print("ValueError")
@@ -0,0 +1,78 @@
+# test micropython.heap_profile and heap_snapshot
+
+import micropython
+
+if not hasattr(micropython, "heap_profile"):
+    print("SKIP")
+    raise SystemExit
+
+
+def uleb(data, pos):
+    value = shift = 0
+    while True:
+        b = data[pos]
+        pos += 1
+        value |= (b & 0x7F) << shift
+        shift += 7
+        if not b & 0x80:
+            return value, pos
+
+
+def string(data, pos):
+    n, pos = uleb(data, pos)
+    return str(data[pos : pos + n], "utf8"), pos + n
+
+
+def parse(data):
+    assert data[:5] == b"MPHP\x01"
+    rate, pos = uleb(data, 5)
+    n, pos = uleb(data, pos)
+    types = {}
+    for _ in range(n):
+        name, pos = string(data, pos)
+        count, pos = uleb(data, pos)
+        nbytes, pos = uleb(data, pos)
+        types[name] = count
+    _, pos = uleb(data, pos)
+    _, pos = uleb(data, pos)
+    n, pos = uleb(data, pos)
+    sites = {}
+    for _ in range(n):
+        file, pos = string(data, pos)
+        line, pos = uleb(data, pos)
+        counts = []
+        for _ in range(4):
+            value, pos = uleb(data, pos)
+            counts.append(value)
+        sites[line] = counts
+    assert pos == len(data)
+    return rate, types, sites
+
+
+class Marker:
+    pass
+
+
+print(micropython.heap_profile())
+micropython.heap_profile(1)
+print(micropython.heap_profile())
+
+keep = [Marker() for _ in range(20)]
+rate, types, sites = parse(micropython.heap_snapshot())
+print(rate, types.get("Marker", 0))
+
+# line 60, which made the Marker objects, made at least 20 allocations, all live
+counts = sites[60]
+print(counts[0] >= 20, counts[2] >= 20)
+
+keep = None
+rate, types, sites = parse(micropython.heap_snapshot())
+print(types.get("Marker", 0), sites[60][2])
+
+micropython.heap_profile(0)
+print(micropython.heap_profile())
+
+try:
+    micropython.heap_profile(-1)
+except ValueError:
+    print("ValueError")
@@ -0,0 +1,107 @@
+# test the optimisations done at optimisation level 2
+import micropython
+
+micropython.opt_level(2)
+
+# folding of float, str and bytes constant expressions
+exec("print(1 / 4, 2 * 1.5 + 1, -2.5, 2.0 ** 3, 7.5 // 2, 7.5 % 2, 3 / 2 * 4)")
+exec("print('ab' + 'cd', 'xy' * 3, 2 * 'z', b'12' + b'34', b'-' * 4, 'q' * 0)")
+
+# operations that would raise must not be folded
+for expr in ("1.0 / 0", "1 / 0", "2.5 // 0", "'a' + 1", "'a' * 1.5", "0.0 ** -1"):
+    try:
+        exec("print(" + expr + ")")
+    except Exception as e:
+        print(expr, type(e).__name__)
+
+# a long result is left to be computed at run time
+exec("print(len('abcd' * 1000))")
+
+
+# globals and builtins read in a loop
+exec(
+    """
+SCALE = 3
+
+def scaled(data):
+    total = 0
+    for x in data:
+        total += abs(x) * SCALE
+    i = 0
+    while i < len(data):
+        total += SCALE
+        i += 1
+    else:
+        total += SCALE
+    return total
+
+print(scaled([1, -2, 3]))
+"""
+)
+
+# a loop sees globals rebound while it runs, including through globals()
+exec(
+    """
+COUNT = 0
+
+def inc():
+    global COUNT
+    COUNT += 1
+
+def count_up(n):
+    seen = []
+    for i in range(n):
+        inc()
+        seen.append(COUNT)
+    return seen
+
+print(count_up(3))
+
+def rebind():
+    globals()["SCALE"] = SCALE + 1
+
+def scale_up(n):
+    seen = []
+    for i in range(n):
+        rebind()
+        seen.append(SCALE)
+    return seen
+
+SCALE = 0
+print(scale_up(3))
+"""
+)
+
+# a name that is not defined is still only looked up when it is reached
+exec(
+    """
+def f(n):
+    for i in range(n):
+        if i > 10:
+            undefined_name()
+    return n
+
+def g(data):
+    for x in data:
+        LATER.append(x)
+
+print(f(3))
+g([])
+LATER = []
+g([1])
+print(LATER)
+"""
+)
+
+# generators are not changed
+exec(
+    """
+def gen(n):
+    for i in range(n):
+        yield SCALE * i
+
+print(list(gen(3)))
+"""
+)
+
+micropython.opt_level(0)
@@ -0,0 +1,80 @@
+# test viper and native functions where the hottest locals are not the first ones
+
+
+@micropython.viper
+def args6(a: int, b: int, c: int, d: int, e: int, f: int) -> int:
+    # the later arguments are used the most
+    x = 0
+    for i in range(f):
+        x += e * i + d
+    return x + a + b + c
+
+
+print(args6(1, 2, 3, 4, 5, 10))
+
+
+@micropython.viper
+def swap(n: int) -> int:
+    unused1 = 1
+    unused2 = 2
+    a = 1
+    b = 2
+    c = 3
+    for i in range(n):
+        a, b, c = b, c, a + b
+    return a + b * 1000 + c * 1000000 + unused1 + unused2
+
+
+print(swap(5))
+
+
+@micropython.viper
+def checksum(buf: ptr8, n: int, seed: int) -> int:
+    s1 = seed & 0xFFFF
+    s2 = seed >> 16
+    i = 0
+    while i < n:
+        s1 = (s1 + buf[i]) % 65521
+        s2 = (s2 + s1) % 65521
+        i += 1
+    return (s2 << 16) | s1
+
+
+print(hex(checksum(b"MicroPython viper", 17, 1)))
+
+
+@micropython.viper
+def fir(src: ptr32, dst: ptr32, n: int):
+    k0 = 1
+    k1 = 2
+    k2 = 1
+    prev1 = 0
+    prev2 = 0
+    for i in range(n):
+        x = src[i]
+        dst[i] = (k0 * x + k1 * prev1 + k2 * prev2) >> 2
+        prev2 = prev1
+        prev1 = x
+
+
+src = bytearray(4 * 8)
+dst = bytearray(4 * 8)
+for i in range(8):
+    src[4 * i] = i * 8
+fir(src, dst, 8)
+print([dst[4 * i] for i in range(8)])
+
+
+@micropython.native
+def nested(n):
+    t = 0
+    a = "unused"
+    for i in range(n):
+        for j in range(n):
+            if j == i:
+                continue
+            t += i * j
+    return t, a
+
+
+print(nested(6))
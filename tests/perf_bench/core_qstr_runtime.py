@@ -0,0 +1,43 @@
+# This tests qstr_find_strn() speed when there are thousands of qstrs that were
+# interned at runtime, as when attribute names come from data.
+
+
+class Obj:
+    pass
+
+
+def test(obj, names, nloop):
+    total = 0
+    for _ in range(nloop):
+        for name in names:
+            total += getattr(obj, name)
+    return total
+
+
+###########################################################################
+# Benchmark interface
+
+bm_params = {
+    (32, 10): (200, 2),
+    (1000, 10): (2000, 20),
+    (5000, 10): (4000, 50),
+}
+
+
+def bm_setup(params):
+    nqstr, nloop = params
+    obj = Obj()
+    # these are str objects, so each getattr has to look up the qstr again
+    names = ["key_%d" % i for i in range(nqstr)]
+    for i, name in enumerate(names):
+        setattr(obj, name, i & 1)
+    state = None
+
+    def run():
+        nonlocal state
+        state = test(obj, names, nloop)
+
+    def result():
+        return nloop * nqstr, state
+
+    return run, result
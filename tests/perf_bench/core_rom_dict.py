@@ -0,0 +1,49 @@
+# This tests lookups in ROM dicts: methods of built-in types, attributes of
+# built-in modules and names from builtins.
+
+import math
+
+
+class List(list):
+    def total(self):
+        return sum(self)
+
+
+def test(n):
+    lst = List()
+    d = {}
+    acc = 0
+    for i in range(n):
+        lst.append(i)
+        d.setdefault(i & 7, 0)
+        d.update(x=i)
+        acc += len(lst) + abs(-i) + min(i, 3) + d.get(i & 7, 0)
+        acc += int(math.sqrt(i)) + math.floor(math.fabs(i))
+        if i & 15 == 0:
+            acc += lst.count(i) + lst.index(i) + lst.total()
+            lst.clear()
+    return acc
+
+
+###########################################################################
+# Benchmark interface
+
+bm_params = {
+    (32, 10): (100,),
+    (1000, 10): (1000,),
+    (5000, 10): (5000,),
+}
+
+
+def bm_setup(params):
+    (nloop,) = params
+    state = None
+
+    def run():
+        nonlocal state
+        state = test(nloop)
+
+    def result():
+        return nloop, state
+
+    return run, result
@@ -0,0 +1,37 @@
+import array
+
+
+@micropython.viper
+def fir3(src: ptr32, dst: ptr32, n: int, k0: int, k1: int, k2: int):
+    x1 = 0
+    x2 = 0
+    i = 0
+    while i < n:
+        x0 = src[i]
+        dst[i] = (k0 * x0 + k1 * x1 + k2 * x2) >> 4
+        x2 = x1
+        x1 = x0
+        i += 1
+
+
+bm_params = {
+    (50, 10): (10, 64),
+    (100, 10): (20, 64),
+    (1000, 10): (50, 256),
+    (5000, 10): (250, 256),
+}
+
+
+def bm_setup(params):
+    nloop, datalen = params
+    src = array.array("i", (i * 37 % 1000 for i in range(datalen)))
+    dst = array.array("i", range(datalen))
+
+    def run():
+        for _ in range(nloop):
+            fir3(src, dst, datalen, 4, 8, 4)
+
+    def result():
+        return nloop * datalen, None
+
+    return run, result
@@ -0,0 +1,36 @@
+@micropython.viper
+def adler32(buf: ptr8, n: int) -> int:
+    s1 = 1
+    s2 = 0
+    i = 0
+    while i < n:
+        s1 += buf[i]
+        if s1 >= 65521:
+            s1 -= 65521
+        s2 += s1
+        if s2 >= 65521:
+            s2 -= 65521
+        i += 1
+    return (s2 << 16) | s1
+
+
+bm_params = {
+    (50, 10): (10, 256),
+    (100, 10): (20, 256),
+    (1000, 10): (50, 1024),
+    (5000, 10): (250, 1024),
+}
+
+
+def bm_setup(params):
+    nloop, datalen = params
+    data = bytearray(i & 0xFF for i in range(datalen))
+
+    def run():
+        for _ in range(nloop):
+            adler32(data, datalen)
+
+    def result():
+        return nloop * datalen, None
+
+    return run, result
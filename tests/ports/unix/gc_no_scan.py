@@ -0,0 +1,63 @@
+# Test that the data of bytes and bytearray objects isn't scanned for heap
+# pointers: objects referenced only from such data are collected, while ones
+# referenced from an array of pointers are kept.
+
+try:
+    import array, gc, struct
+
+    array.array("P")
+except (ImportError, ValueError):
+    print("SKIP")
+    raise SystemExit
+
+N = 16
+SIZE = 1024
+FMT = "P" * N
+
+
+def pack_bytearray(ids):
+    buf = bytearray(struct.calcsize(FMT))
+    struct.pack_into(FMT, buf, 0, *ids)
+    return buf
+
+
+def pack_bytes(ids):
+    return struct.pack(FMT, *ids)
+
+
+def pack_array(ids):
+    return array.array("P", ids)
+
+
+def make_ref(pack, holder):
+    objs = [bytearray(SIZE) for _ in range(N)]
+    holder.append(pack([id(o) for o in objs]))
+
+
+def clobber_stack(n):
+    # Overwrite the C stack left over from make_ref, so it can't keep the
+    # objects alive.
+    if n:
+        clobber_stack(n - 1)
+
+
+# Returns whether the objects whose ids pack() stores are kept alive by the
+# result, by counting how many are freed once the result is dropped.
+def kept_alive(pack):
+    holder = []
+    make_ref(pack, holder)
+    clobber_stack(10)
+    gc.collect()
+    before = gc.mem_free()
+    holder.clear()
+    gc.collect()
+    return (gc.mem_free() - before) // SIZE > N // 2
+
+
+if kept_alive(pack_bytearray):
+    # This build scans all heap memory.
+    print("SKIP")
+    raise SystemExit
+
+print(kept_alive(pack_bytes))
+print(kept_alive(pack_array))
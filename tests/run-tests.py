@@ -704,6 +704,14 @@ def run_tests(pyb, tests, args, result_dir, num_threads=1):
         if "True" not in str(t, "ascii"):
             skip_tests.add("cmdline/repl_words_move.py")
 
+        # Check if sys.settrace is enabled, and skip tests that rely on bytecode
+        # optimisations it turns off
+        t = run_feature_check(pyb, args, "settrace_check.py")
+        if "True" in str(t, "ascii"):
+            skip_tests.add("cmdline/cmd_showbc.py")  # no peephole pass with settrace
+            skip_tests.add("cmdline/cmd_showbc_peephole.py")  # no peephole pass with settrace
+            skip_tests.add("cmdline/cmd_showbc_opt2.py")  # no peephole pass with settrace
+
         upy_byteorder = run_feature_check(pyb, args, "byteorder.py")
         upy_float_precision = run_feature_check(pyb, args, "float.py")
         try:
@@ -819,6 +827,7 @@ def run_tests(pyb, tests, args, result_dir, num_threads=1):
         skip_tests.add("basics/del_deref.py")  # requires checking for unbound local
         skip_tests.add("basics/del_local.py")  # requires checking for unbound local
         skip_tests.add("basics/exception_chain.py")  # raise from is not supported
+        skip_tests.add("basics/peephole.py")  # requires checking for unbound local
         skip_tests.add("basics/scope_implicit.py")  # requires checking for unbound local
         skip_tests.add("basics/sys_tracebacklimit.py")  # requires traceback info
         skip_tests.add("basics/try_finally_return2.py")  # requires raise_varargs
@@ -840,6 +849,8 @@ def run_tests(pyb, tests, args, result_dir, num_threads=1):
         skip_tests.add(
             "micropython/opt_level_lineno.py"
         )  # native doesn't have proper traceback info
+        skip_tests.add("micropython/heap_profile.py")  # native doesn't record line numbers
+        skip_tests.add("micropython/call_profile.py")  # only bytecode functions are profiled
         skip_tests.add("micropython/schedule.py")  # native code doesn't check pending events
         skip_tests.add("stress/bytecode_limit.py")  # bytecode specific test
 
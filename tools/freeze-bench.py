@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+#
+# This file is part of the MicroPython project, http://micropython.org/
+#
+# The MIT License (MIT)
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+
+# Time the stages of freezing all the .py files in a tree (by default
+# micropython-lib) the way makemanifest.py does, to compare one mpy-cross
+# process per file with a pool of mpy-cross --batch processes, and freezing
+# with mpy-tool.py with and without its cache.
+
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+TOOLS_DIR = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, os.path.join(TOOLS_DIR, "../mpy-cross"))
+import mpy_cross
+
+
+def find_py_files(top):
+    for path, dirs, files in os.walk(top):
+        dirs.sort()
+        for f in sorted(files):
+            if f.endswith(".py"):
+                yield os.path.join(path, f)
+
+
+def timed(name, fun):
+    t = time.perf_counter()
+    result = fun()
+    print("{:<40} {:8.3f} s".format(name, time.perf_counter() - t))
+    return result
+
+
+def main():
+    cmd_parser = argparse.ArgumentParser(description="Benchmark compiling and freezing .py files.")
+    cmd_parser.add_argument(
+        "dir",
+        nargs="?",
+        default=os.path.join(TOOLS_DIR, "../lib/micropython-lib"),
+        help="directory of .py files (default: micropython-lib)",
+    )
+    cmd_parser.add_argument("--mpy-cross", help="mpy-cross binary to use")
+    cmd_parser.add_argument("-j", "--jobs", type=int, help="mpy-cross processes (default: CPUs)")
+    cmd_parser.add_argument("-q", "--qstr-header", help="qstr header to freeze against")
+    args = cmd_parser.parse_args()
+
+    srcs = list(find_py_files(args.dir))
+    if not srcs:
+        print("no .py files found in {}".format(args.dir))
+        sys.exit(1)
+
+    work = tempfile.mkdtemp()
+    try:
+        jobs = [
+            {"src": src, "dest": "{}/{}.mpy".format(work, i), "src_path": os.path.basename(src)}
+            for i, src in enumerate(srcs)
+        ]
+
+        # Some files don't compile (eg CPython-only code); leave them out of the rest.
+        def compile_each():
+            ok = []
+            for job in jobs:
+                try:
+                    mpy_cross.compile(mpy_cross=args.mpy_cross, **job)
+                    ok.append(job)
+                except mpy_cross.CrossCompileError:
+                    pass
+            return ok
+
+        jobs = timed("mpy-cross, one process per file", compile_each)
+        print("({} of {} files compiled)".format(len(jobs), len(srcs)))
+        timed(
+            "mpy-cross --batch, 1 process",
+            lambda: mpy_cross.compile_batch(jobs, mpy_cross=args.mpy_cross, workers=1),
+        )
+        timed(
+            "mpy-cross --batch, {} processes".format(args.jobs or os.cpu_count()),
+            lambda: mpy_cross.compile_batch(jobs, mpy_cross=args.mpy_cross, workers=args.jobs),
+        )
+
+        mpy_tool = [sys.executable, os.path.join(TOOLS_DIR, "mpy-tool.py"), "-f"]
+        if args.qstr_header:
+            mpy_tool += ["-q", args.qstr_header]
+        mpy_files = [job["dest"] for job in jobs]
+        cache = work + "/cache"
+
+        def freeze(extra_args):
+            with open(os.devnull, "w") as null:
+                subprocess.check_call(mpy_tool + extra_args + mpy_files, stdout=null)
+
+        timed("mpy-tool.py -f", lambda: freeze([]))
+        timed("mpy-tool.py -f --cache, cold", lambda: freeze(["--cache", cache]))
+        timed("mpy-tool.py -f --cache, warm", lambda: freeze(["--cache", cache]))
+        mpy_cross.compile(mpy_cross=args.mpy_cross, **dict(jobs[0], src_path="changed.py"))
+        timed("mpy-tool.py -f --cache, 1 file changed", lambda: freeze(["--cache", cache]))
+    finally:
+        shutil.rmtree(work)
+
+
+if __name__ == "__main__":
+    main()
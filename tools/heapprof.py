@@ -0,0 +1,167 @@
+#!/usr/bin/env python3
+#
+# This file is part of the MicroPython project, http://micropython.org/
+#
+# The MIT License (MIT)
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+
+# Render heap snapshots made by micropython.heap_snapshot(), or the difference
+# between two of them.  See py/gcprofile.c for the format.
+#
+# On the device:
+#     with open("snap.bin", "wb") as f:
+#         f.write(micropython.heap_snapshot())
+#
+# Then on the host:
+#     heapprof.py snap.bin            # what's live, by type and by allocation site
+#     heapprof.py old.bin new.bin     # what changed, eg to find a slow leak
+
+import argparse
+import sys
+
+MAGIC = b"MPHP"
+VERSION = 1
+
+
+class Reader:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def uleb(self):
+        value = shift = 0
+        while True:
+            b = self.data[self.pos]
+            self.pos += 1
+            value |= (b & 0x7F) << shift
+            shift += 7
+            if not b & 0x80:
+                return value
+
+    def str(self):
+        n = self.uleb()
+        s = self.data[self.pos : self.pos + n]
+        self.pos += n
+        return str(s, "utf8")
+
+
+class Snapshot:
+    def __init__(self, data):
+        if data[:4] != MAGIC:
+            raise ValueError("not a heap snapshot")
+        if data[4] != VERSION:
+            raise ValueError("unsupported snapshot version {}".format(data[4]))
+        r = Reader(data)
+        r.pos = 5
+        self.rate = r.uleb()
+        # name -> (count, bytes)
+        self.types = {}
+        for _ in range(r.uleb()):
+            name = r.str()
+            count = r.uleb()
+            nbytes = r.uleb()
+            prev = self.types.get(name, (0, 0))
+            self.types[name] = (prev[0] + count, prev[1] + nbytes)
+        self.types["<untyped>"] = (r.uleb(), r.uleb())
+        # (file, line) -> (n_allocs, alloc_bytes, live_count, live_bytes)
+        self.sites = {}
+        for _ in range(r.uleb()):
+            site = (r.str() or "<other>", r.uleb())
+            self.sites[site] = tuple(r.uleb() for _ in range(4))
+
+
+def site_name(site):
+    return "{}:{}".format(*site) if site[1] else site[0]
+
+
+def print_table(title, header, rows):
+    print(title)
+    widths = [max(len(str(row[i])) for row in [header] + rows) for i in range(len(header))]
+    for row in [header] + rows:
+        cells = [str(cell).rjust(w) if i else str(cell).ljust(w) for i, (cell, w) in enumerate(zip(row, widths))]
+        print("  " + "  ".join(cells))
+    print()
+
+
+def show(snap, top):
+    rows = sorted(snap.types.items(), key=lambda kv: -kv[1][1])[:top]
+    total = sum(b for _, b in snap.types.values())
+    print_table(
+        "Live heap: {} bytes".format(total),
+        ("type", "count", "bytes"),
+        [(name, count, nbytes) for name, (count, nbytes) in rows],
+    )
+    if snap.sites:
+        rows = sorted(snap.sites.items(), key=lambda kv: (-kv[1][3], -kv[1][1]))[:top]
+        print_table(
+            "Sampled allocations (1 in {})".format(snap.rate),
+            ("site", "allocs", "bytes", "live", "live bytes"),
+            [(site_name(site), *counts) for site, counts in rows],
+        )
+
+
+def show_diff(old, new, top):
+    names = set(old.types) | set(new.types)
+    rows = []
+    for name in names:
+        oc, ob = old.types.get(name, (0, 0))
+        nc, nb = new.types.get(name, (0, 0))
+        if (oc, ob) != (nc, nb):
+            rows.append((name, nc - oc, nb - ob, nb))
+    rows.sort(key=lambda row: -abs(row[2]))
+    print_table("Change in live heap", ("type", "+count", "+bytes", "bytes"), rows[:top])
+    sites = set(old.sites) | set(new.sites)
+    rows = []
+    for site in sites:
+        o = old.sites.get(site, (0, 0, 0, 0))
+        n = new.sites.get(site, (0, 0, 0, 0))
+        if o != n:
+            rows.append((site_name(site), n[0] - o[0], n[2] - o[2], n[3] - o[3]))
+    rows.sort(key=lambda row: (-row[3], -row[1]))
+    if rows:
+        print_table(
+            "Change in sampled allocations (1 in {})".format(new.rate),
+            ("site", "+allocs", "+live", "+live bytes"),
+            rows[:top],
+        )
+
+
+def main():
+    cmd_parser = argparse.ArgumentParser(description="Render MicroPython heap snapshots.")
+    cmd_parser.add_argument("snapshot", help="snapshot from micropython.heap_snapshot()")
+    cmd_parser.add_argument("newer", nargs="?", help="later snapshot, to show what changed")
+    cmd_parser.add_argument("--top", type=int, default=20, help="rows to show per table")
+    args = cmd_parser.parse_args()
+
+    try:
+        with open(args.snapshot, "rb") as f:
+            snap = Snapshot(f.read())
+        if args.newer:
+            with open(args.newer, "rb") as f:
+                show_diff(snap, Snapshot(f.read()), args.top)
+        else:
+            show(snap, args.top)
+    except (ValueError, IndexError) as er:
+        print("error:", er, file=sys.stderr)
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
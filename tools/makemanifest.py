@@ -25,6 +25,8 @@
 # THE SOFTWARE.
 
 from __future__ import print_function
+import contextlib
+import hashlib
 import sys
 import os
 import subprocess
@@ -60,12 +62,117 @@ def get_timestamp(path, default=None):
         return default
 
 
+def hash_file(h, path):
+    with open(path, "rb") as f:
+        h.update(f.read())
+
+
+# Write a file only if its content changes, so its timestamp says when it last did.
+def update_file(path, content):
+    try:
+        with open(path, "rb") as f:
+            if f.read() == content:
+                return
+    except OSError:
+        pass
+    mkdir(path)
+    with open(path, "wb") as f:
+        f.write(content)
+
+
 def mkdir(filename):
     path = os.path.dirname(filename)
     if not os.path.isdir(path):
         os.makedirs(path)
 
 
+# Evaluate the argument of a const(), which may refer to earlier constants.
+def eval_const_expr(node, consts):
+    import ast
+    import operator
+
+    binary_ops = {
+        ast.Add: operator.add,
+        ast.Sub: operator.sub,
+        ast.Mult: operator.mul,
+        ast.Div: operator.truediv,
+        ast.FloorDiv: operator.floordiv,
+        ast.Mod: operator.mod,
+        ast.Pow: operator.pow,
+        ast.LShift: operator.lshift,
+        ast.RShift: operator.rshift,
+        ast.BitOr: operator.or_,
+        ast.BitXor: operator.xor,
+        ast.BitAnd: operator.and_,
+    }
+    unary_ops = {ast.UAdd: operator.pos, ast.USub: operator.neg, ast.Invert: operator.invert}
+    if isinstance(node, ast.Constant) and isinstance(node.value, (int, float, str, bytes)):
+        return node.value
+    elif isinstance(node, ast.Name) and node.id in consts:
+        return consts[node.id]
+    elif isinstance(node, ast.BinOp) and type(node.op) in binary_ops:
+        return binary_ops[type(node.op)](
+            eval_const_expr(node.left, consts), eval_const_expr(node.right, consts)
+        )
+    elif isinstance(node, ast.UnaryOp) and type(node.op) in unary_ops:
+        return unary_ops[type(node.op)](eval_const_expr(node.operand, consts))
+    raise ValueError
+
+
+# Find the public module-level "NAME = const(value)" definitions in a module, so
+# that modules compiled at -O2 can use them as constants when they import them.
+# Returns a list of "<module>.<NAME>=<value>" strings to pass to mpy-cross -D.
+def get_module_consts(full_path, target_path):
+    import ast
+    import math
+
+    module = target_path[:-3].replace("/", ".")
+    if module.endswith(".__init__"):
+        module = module[: -len(".__init__")]
+    try:
+        with open(full_path, "rb") as f:
+            tree = ast.parse(f.read(), full_path)
+    except (SyntaxError, ValueError):
+        # mpy-cross will report any error
+        return []
+    consts = {}
+    defs = []
+    for stmt in tree.body:
+        if not (
+            isinstance(stmt, ast.Assign)
+            and len(stmt.targets) == 1
+            and isinstance(stmt.targets[0], ast.Name)
+            and isinstance(stmt.value, ast.Call)
+            and isinstance(stmt.value.func, ast.Name)
+            and stmt.value.func.id == "const"
+            and len(stmt.value.args) == 1
+        ):
+            continue
+        name = stmt.targets[0].id
+        try:
+            value = eval_const_expr(stmt.value.args[0], consts)
+        except (ValueError, ArithmeticError, TypeError):
+            continue
+        consts[name] = value
+        if isinstance(value, float) and (
+            not math.isfinite(value) or math.copysign(1.0, value) < 0 and value == 0
+        ):
+            # mpy-cross can't take inf, nan or -0.0 as a constant
+            continue
+        if not name.startswith("_"):
+            defs.append("{}.{}={!r}".format(module, name, consts[name]))
+    return defs
+
+
+def get_opt_level(opt, mpy_cross_flags):
+    if opt is None:
+        # the level may be given in the mpy-cross flags instead
+        for flag in mpy_cross_flags:
+            if flag.startswith("-O"):
+                opt = int(flag[2:]) if flag[2:].isdigit() else flag.count("O")
+    return opt or 0
+
+
 # Formerly make-frozen.py.
 # This generates:
 # - MP_FROZEN_STR_NAMES macro
@@ -173,47 +280,99 @@ def main():
             print('freeze error executing "{}": {}'.format(input_manifest, er.args[0]))
             sys.exit(1)
 
+    mpy_cross_flags = args.mpy_cross_flags.split()
+
+    # Compiled modules are cached under a hash of everything that goes into them,
+    # so only the modules that changed are compiled again.  Setting
+    # MICROPY_MPY_CACHE shares the cache between builds; it can be deleted at any time.
+    cache_dir = os.getenv("MICROPY_MPY_CACHE", args.build_dir + "/frozen_mpy_cache")
+    mkdir(cache_dir + "/")
+    tool_hash = hashlib.sha256()
+    hash_file(tool_hash, MPY_CROSS)
+    if "--profile" in mpy_cross_flags:
+        # the call profile decides which functions are compiled to native code
+        hash_file(tool_hash, mpy_cross_flags[mpy_cross_flags.index("--profile") + 1])
+
+    # Collect the constants that frozen modules define, for modules compiled at -O2
+    module_consts = []
+    for result in manifest.files():
+        if result.kind == manifestfile.KIND_FREEZE_AS_MPY:
+            module_consts += get_module_consts(result.full_path, result.target_path)
+
     # Process the manifest
     str_paths = []
     mpy_files = []
+    mpy_cached = []
+    compile_targets = []
+    compile_jobs = []
     ts_newest = 0
-    for result in manifest.files():
-        if result.kind == manifestfile.KIND_FREEZE_AS_STR:
-            str_paths.append(
-                (
-                    result.full_path,
-                    result.target_path,
+    with contextlib.ExitStack() as stack:
+        for result in manifest.files():
+            if result.kind == manifestfile.KIND_FREEZE_AS_STR:
+                str_paths.append(
+                    (
+                        result.full_path,
+                        result.target_path,
+                    )
+                )
+                ts_newest = max(ts_newest, result.timestamp)
+            elif result.kind == manifestfile.KIND_FREEZE_AS_MPY:
+                outfile = "{}/frozen_mpy/{}.mpy".format(args.build_dir, result.target_path[:-3])
+                extra_args = mpy_cross_flags
+                if module_consts and get_opt_level(result.opt, mpy_cross_flags) >= 2:
+                    for const in module_consts:
+                        extra_args = extra_args + ["-D", const]
+                h = tool_hash.copy()
+                h.update(
+                    repr(
+                        (result.target_path, result.opt, extra_args, result.metadata.version)
+                    ).encode()
                 )
-            )
-            ts_outfile = result.timestamp
-        elif result.kind == manifestfile.KIND_FREEZE_AS_MPY:
-            outfile = "{}/frozen_mpy/{}.mpy".format(args.build_dir, result.target_path[:-3])
-            ts_outfile = get_timestamp(outfile, 0)
-            if result.timestamp >= ts_outfile:
-                print("MPY", result.target_path)
-                mkdir(outfile)
-                # Add __version__ to the end of the file before compiling.
-                with manifestfile.tagged_py_file(result.full_path, result.metadata) as tagged_path:
-                    try:
-                        mpy_cross.compile(
-                            tagged_path,
-                            dest=outfile,
-                            src_path=result.target_path,
-                            opt=result.opt,
-                            mpy_cross=MPY_CROSS,
-                            extra_args=args.mpy_cross_flags.split(),
-                        )
-                    except mpy_cross.CrossCompileError as ex:
-                        print("error compiling {}:".format(result.target_path))
-                        print(ex.args[0])
-                        raise SystemExit(1)
-                ts_outfile = get_timestamp(outfile)
-            mpy_files.append(outfile)
-        else:
-            assert result.kind == manifestfile.KIND_FREEZE_MPY
-            mpy_files.append(result.full_path)
-            ts_outfile = result.timestamp
-        ts_newest = max(ts_newest, ts_outfile)
+                hash_file(h, result.full_path)
+                cached = "{}/{}.mpy".format(cache_dir, h.hexdigest())
+                if not os.path.exists(cached):
+                    print("MPY", result.target_path)
+                    # Add __version__ to the end of the file before compiling.
+                    tagged_path = stack.enter_context(
+                        manifestfile.tagged_py_file(result.full_path, result.metadata)
+                    )
+                    compile_targets.append((result.target_path, cached))
+                    compile_jobs.append(
+                        {
+                            "src": tagged_path,
+                            "dest": "{}.{}.tmp".format(cached, os.getpid()),
+                            "src_path": result.target_path,
+                            "opt": result.opt,
+                            "extra_args": extra_args,
+                        }
+                    )
+                mpy_files.append(outfile)
+                mpy_cached.append((outfile, cached))
+            else:
+                assert result.kind == manifestfile.KIND_FREEZE_MPY
+                mpy_files.append(result.full_path)
+                ts_newest = max(ts_newest, result.timestamp)
+
+        # Compile the modules that aren't in the cache, in parallel
+        if compile_jobs:
+            try:
+                mpy_cross.compile_batch(compile_jobs, mpy_cross=MPY_CROSS)
+            except mpy_cross.CrossCompileError as ex:
+                if ex.args[1] >= 0:
+                    print("error compiling {}:".format(compile_targets[ex.args[1]][0]))
+                print(ex.args[0])
+                for job in compile_jobs:
+                    if os.path.exists(job["dest"]):
+                        os.unlink(job["dest"])
+                raise SystemExit(1)
+            for job, (_, cached) in zip(compile_jobs, compile_targets):
+                os.replace(job["dest"], cached)
+
+    # Copy compiled modules out of the cache, leaving unchanged ones untouched
+    for outfile, cached in mpy_cached:
+        with open(cached, "rb") as f:
+            update_file(outfile, f.read())
+        ts_newest = max(ts_newest, get_timestamp(outfile))
 
     # Check if output file needs generating
     if ts_newest < get_timestamp(args.output, 0):
@@ -232,6 +391,8 @@ def main():
                 "-f",
                 "-q",
                 args.build_dir + "/genhdr/qstrdefs.preprocessed.h",
+                "--cache",
+                cache_dir,
             ]
             + args.mpy_tool_flags.split()
             + mpy_files
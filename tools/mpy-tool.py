@@ -87,7 +87,8 @@ class FreezeError(Exception):
 
 
 class Config:
-    MPY_VERSION = 6
+    MPY_VERSION = 7
+    MPY_VERSION_MIN = 6
     MPY_SUB_VERSION = 3
     MICROPY_LONGINT_IMPL_NONE = 0
     MICROPY_LONGINT_IMPL_LONGLONG = 1
@@ -189,10 +190,10 @@ class Opcode:
     # fmt: off
     # Load, Store, Delete, Import, Make, Build, Unpack, Call, Jump, Exception, For, sTack, Return, Yield, Op
     MP_BC_BASE_RESERVED               = (0x00) # ----------------
-    MP_BC_BASE_QSTR_O                 = (0x10) # LLLLLLSSSDDII---
+    MP_BC_BASE_QSTR_O                 = (0x10) # LLLLLLSSSDDII--L
     MP_BC_BASE_VINT_E                 = (0x20) # MMLLLLSSDDBBBBBB
-    MP_BC_BASE_VINT_O                 = (0x30) # UUMMCCCC--------
-    MP_BC_BASE_JUMP_E                 = (0x40) # J-JJJJJEEEEF----
+    MP_BC_BASE_VINT_O                 = (0x30) # UUMMCCCCOOL-----
+    MP_BC_BASE_JUMP_E                 = (0x40) # JJJJJJJEEEEF----
     MP_BC_BASE_BYTE_O                 = (0x50) # LLLLSSDTTTTTEEFF
     MP_BC_BASE_BYTE_E                 = (0x60) # --BREEEYYI------
     MP_BC_LOAD_CONST_SMALL_INT_MULTI  = (0x70) # LLLLLLLLLLLLLLLL
@@ -294,11 +295,18 @@ class Opcode:
     MP_BC_IMPORT_NAME                 = (MP_BC_BASE_QSTR_O + 0x0b) # qstr
     MP_BC_IMPORT_FROM                 = (MP_BC_BASE_QSTR_O + 0x0c) # qstr
     MP_BC_IMPORT_STAR                 = (MP_BC_BASE_BYTE_E + 0x09)
+
+    MP_BC_LOAD_FAST_0_ATTR            = (MP_BC_BASE_QSTR_O + 0x0f) # qstr
+    MP_BC_LOAD_FAST_2                 = (MP_BC_BASE_VINT_O + 0x0a) # uint
+    MP_BC_INPLACE_ADD_FAST            = (MP_BC_BASE_VINT_O + 0x08) # uint
+    MP_BC_INPLACE_SUBTRACT_FAST       = (MP_BC_BASE_VINT_O + 0x09) # uint
+    MP_BC_BINARY_OP_POP_JUMP_IF       = (MP_BC_BASE_JUMP_E + 0x01) # signed relative bytecode offset; then a byte
     # fmt: on
 
     # Create sets of related opcodes.
     ALL_OFFSET_SIGNED = (
         MP_BC_UNWIND_JUMP,
+        MP_BC_BINARY_OP_POP_JUMP_IF,
         MP_BC_JUMP,
         MP_BC_POP_JUMP_IF_TRUE,
         MP_BC_POP_JUMP_IF_FALSE,
@@ -532,22 +540,21 @@ class GlobalQStrList:
     def __init__(self):
         # Initialise global list of qstrs with static qstrs
         self.qstrs = [None]  # MP_QSTRnull should never be referenced
+        self.by_str = {}
         for n in qstrutil.static_qstr_list:
-            self.qstrs.append(QStrType(n))
+            self.add(n)
 
     def add(self, s):
         q = QStrType(s)
         self.qstrs.append(q)
+        self.by_str.setdefault(s, q)
         return q
 
     def get_by_index(self, i):
         return self.qstrs[i]
 
     def find_by_str(self, s):
-        for q in self.qstrs:
-            if q is not None and q.str == s:
-                return q
-        return None
+        return self.by_str.get(s)
 
 
 class MPFunTable:
@@ -656,6 +663,20 @@ class CompiledModule:
         print("obj_table:", self.obj_table)
         self.raw_code.disassemble()
 
+    def referenced_qstrs(self):
+        # The qstrs that the frozen code of this module refers to.
+        strs = set(q.str for q in self.qstr_table)
+
+        def add_objs(objs):
+            for obj in objs:
+                if isinstance(obj, tuple):
+                    add_objs(obj)
+                elif is_str_type(obj) and global_qstrs.find_by_str(obj):
+                    strs.add(obj)
+
+        add_objs(self.obj_table)
+        return sorted(strs)
+
     def freeze(self, compiled_module_index):
         print()
         print("/" * 80)
@@ -1345,6 +1366,24 @@ def read_raw_code(reader, parent_name, qstr_table, obj_table, segments):
     return rc
 
 
+def read_mpy_header(filename, header):
+    if len(header) < 4 or header[0] != ord("M"):
+        raise MPYReadError(filename, "not a valid .mpy file")
+    if not config.MPY_VERSION_MIN <= header[1] <= config.MPY_VERSION:
+        raise MPYReadError(filename, "incompatible .mpy version")
+    feature_byte = header[2]
+    mpy_native_arch = feature_byte >> 2
+    if mpy_native_arch != MP_NATIVE_ARCH_NONE:
+        mpy_sub_version = feature_byte & 3
+        if mpy_sub_version != config.MPY_SUB_VERSION:
+            raise MPYReadError(filename, "incompatible .mpy sub-version")
+        if config.native_arch == MP_NATIVE_ARCH_NONE:
+            config.native_arch = mpy_native_arch
+        elif config.native_arch != mpy_native_arch:
+            raise MPYReadError(filename, "native architecture mismatch")
+    config.mp_small_int_bits = header[3]
+
+
 def read_mpy(filename):
     with open(filename, "rb") as fileobj:
         reader = MPYReader(filename, fileobj)
@@ -1352,21 +1391,7 @@ def read_mpy(filename):
 
         # Read and verify the header.
         header = reader.read_bytes(4)
-        if header[0] != ord("M"):
-            raise MPYReadError(filename, "not a valid .mpy file")
-        if header[1] != config.MPY_VERSION:
-            raise MPYReadError(filename, "incompatible .mpy version")
-        feature_byte = header[2]
-        mpy_native_arch = feature_byte >> 2
-        if mpy_native_arch != MP_NATIVE_ARCH_NONE:
-            mpy_sub_version = feature_byte & 3
-            if mpy_sub_version != config.MPY_SUB_VERSION:
-                raise MPYReadError(filename, "incompatible .mpy sub-version")
-            if config.native_arch == MP_NATIVE_ARCH_NONE:
-                config.native_arch = mpy_native_arch
-            elif config.native_arch != mpy_native_arch:
-                raise MPYReadError(filename, "native architecture mismatch")
-        config.mp_small_int_bits = header[3]
+        read_mpy_header(filename, header)
 
         # Read number of qstrs, and number of objects.
         n_qstr = reader.read_uint()
@@ -1406,6 +1431,123 @@ def read_mpy(filename):
     )
 
 
+# Size counters that freeze_mpy reports at the end of its output.
+FREEZE_COUNTERS = (
+    "bc_content",
+    "const_str_content",
+    "const_int_content",
+    "const_obj_content",
+    "const_table_qstr_content",
+    "const_table_ptr_content",
+    "raw_code_count",
+    "raw_code_content",
+)
+
+
+# A module whose frozen code was loaded from the cache.
+class CachedModule:
+    def __init__(self, entry):
+        self.escaped_name = entry["escaped_name"]
+        self.source_file = QStrType(entry["source_file"])
+        self.frozen = entry["frozen"]
+        self.counters = entry["counters"]
+        for s in entry["qstrs"]:
+            if not global_qstrs.find_by_str(s):
+                global_qstrs.add(s)
+
+    def freeze(self, compiled_module_index):
+        sys.stdout.write(self.frozen)
+        for name, value in zip(FREEZE_COUNTERS, self.counters):
+            globals()[name] += value
+
+
+# Frozen code is cached per module, under a hash of the .mpy file and of everything
+# else that goes into its frozen code, so that only modules that changed are frozen
+# again; the rest of the output is cheap to generate.
+class FreezeCache:
+    def __init__(self, cache_dir):
+        import hashlib
+
+        self.cache_dir = cache_dir
+        self.tool_hash = hashlib.sha256()
+        for tool in (__file__, qstrutil.__file__):
+            with open(tool, "rb") as f:
+                self.tool_hash.update(f.read())
+
+    def path(self, filename, data):
+        h = self.tool_hash.copy()
+        h.update(
+            repr(
+                (
+                    filename,
+                    config.MICROPY_LONGINT_IMPL,
+                    config.MPZ_DIG_SIZE,
+                    config.MICROPY_QSTR_BYTES_IN_HASH,
+                    config.native_arch,
+                    config.mp_small_int_bits,
+                )
+            ).encode()
+        )
+        h.update(data)
+        return "{}/{}.freeze".format(self.cache_dir, h.hexdigest())
+
+    def load(self, path):
+        import json
+
+        try:
+            with open(path) as f:
+                return CachedModule(json.load(f))
+        except (OSError, ValueError):
+            return None
+
+    def freeze(self, cm, compiled_module_index, path):
+        import io
+        import json
+        import os
+
+        counters = [globals()[name] for name in FREEZE_COUNTERS]
+        stdout = sys.stdout
+        sys.stdout = io.StringIO()
+        try:
+            cm.freeze(compiled_module_index)
+            frozen = sys.stdout.getvalue()
+        finally:
+            sys.stdout = stdout
+        stdout.write(frozen)
+        entry = {
+            "escaped_name": cm.escaped_name,
+            "source_file": cm.source_file.str,
+            "frozen": frozen,
+            "counters": [globals()[name] - c for name, c in zip(FREEZE_COUNTERS, counters)],
+            "qstrs": cm.referenced_qstrs(),
+        }
+        if not os.path.isdir(self.cache_dir):
+            os.makedirs(self.cache_dir)
+        tmp_path = "{}.{}.tmp".format(path, os.getpid())
+        with open(tmp_path, "w") as f:
+            json.dump(entry, f)
+        os.replace(tmp_path, path)
+
+
+def read_mpy_cached(filenames, cache):
+    # Check all headers first, as they set config values that are part of the hash.
+    data = []
+    for filename in filenames:
+        with open(filename, "rb") as f:
+            data.append(f.read())
+        read_mpy_header(filename, bytes_cons(data[-1][:4]))
+    compiled_modules = []
+    cache_paths = []
+    for filename, d in zip(filenames, data):
+        path = cache.path(filename, d)
+        cm = cache.load(path)
+        if cm is None:
+            cm = read_mpy(filename)
+        compiled_modules.append(cm)
+        cache_paths.append(path)
+    return compiled_modules, cache_paths
+
+
 def hexdump_mpy(compiled_modules):
     for cm in compiled_modules:
         cm.hexdump()
@@ -1416,7 +1558,7 @@ def disassemble_mpy(compiled_modules):
         cm.disassemble()
 
 
-def freeze_mpy(firmware_qstr_idents, compiled_modules):
+def freeze_mpy(firmware_qstr_idents, compiled_modules, cache=None, cache_paths=None):
     # add to qstrs
     new = {}
     for q in global_qstrs.qstrs:
@@ -1527,7 +1669,10 @@ def freeze_mpy(firmware_qstr_idents, compiled_modules):
 
     # Freeze all modules.
     for idx, cm in enumerate(compiled_modules):
-        cm.freeze(idx)
+        if cache is None or isinstance(cm, CachedModule):
+            cm.freeze(idx)
+        else:
+            cache.freeze(cm, idx, cache_paths[idx])
 
     # Print separator, separating individual modules from global data structures.
     print()
@@ -1795,6 +1940,9 @@ def main(args=None):
         default=16,
         help="mpz digit size used by target (default 16)",
     )
+    cmd_parser.add_argument(
+        "--cache", metavar="DIR", help="with --freeze, cache the frozen code of each module in DIR"
+    )
     cmd_parser.add_argument("-o", "--output", default=None, help="output file")
     cmd_parser.add_argument("files", nargs="+", help="input .mpy files")
     args = cmd_parser.parse_args(args)
@@ -1824,8 +1972,13 @@ def main(args=None):
     global_qstrs = GlobalQStrList()
 
     # Load all .mpy files.
+    cache = cache_paths = None
     try:
-        compiled_modules = [read_mpy(file) for file in args.files]
+        if args.freeze and args.cache and not (args.hexdump or args.disassemble or args.merge):
+            cache = FreezeCache(args.cache)
+            compiled_modules, cache_paths = read_mpy_cached(args.files, cache)
+        else:
+            compiled_modules = [read_mpy(file) for file in args.files]
     except MPYReadError as er:
         print(er, file=sys.stderr)
         sys.exit(1)
@@ -1840,7 +1993,7 @@ def main(args=None):
 
     if args.freeze:
         try:
-            freeze_mpy(firmware_qstr_idents, compiled_modules)
+            freeze_mpy(firmware_qstr_idents, compiled_modules, cache, cache_paths)
         except FreezeError as er:
             print(er, file=sys.stderr)
             sys.exit(1)